@@ -0,0 +1,376 @@
+import json
+import struct
+import zlib
+import numpy as np
+from sklearn.tree import DecisionTreeClassifier
+from sklearn.ensemble import RandomForestClassifier, GradientBoostingClassifier
+from sklearn.linear_model import LogisticRegression, Ridge
+from sklearn.svm import SVC
+from sklearn.neighbors import KNeighborsClassifier
+from sklearn.naive_bayes import GaussianNB
+from sklearn.kernel_approximation import RBFSampler
+
+# Artifact read by the C++ native engine, see ui/include/native/native_model.h.
+NATIVE_FORMAT = 'ml-native'
+NATIVE_VERSION = 1
+
+def float32_floor(values):
+    # sklearn compares float32 features against float64 thresholds. For a
+    # float32 x, x <= t holds exactly when x <= the largest float32 not above
+    # t, so thresholds are rounded down instead of to nearest.
+    exact = np.asarray(values, dtype=np.float64)
+    rounded = exact.astype(np.float32)
+    above = rounded.astype(np.float64) > exact
+    rounded[above] = np.nextafter(rounded[above], np.float32(-np.inf))
+    return rounded
+
+def export_tree(estimator, leaf_values):
+    tree = estimator.tree_
+    is_leaf = tree.children_left == -1
+
+    return {
+        'feature': np.where(is_leaf, -1, tree.feature).astype(int).tolist(),
+        'threshold': float32_floor(np.where(is_leaf, 0.0, tree.threshold)).tolist(),
+        'left': tree.children_left.astype(int).tolist(),
+        'right': tree.children_right.astype(int).tolist(),
+        'value': np.asarray(leaf_values, dtype=np.float64).tolist(),
+        # Training rows reaching each node (bootstrap weighted for forests),
+        # the branch frequencies behind the engine's hot-path node layout.
+        'samples': tree.weighted_n_node_samples.astype(float).tolist()
+    }
+
+def positive_class_fraction(estimator):
+    # Normalized so that both count-valued and fraction-valued trees (sklearn
+    # >= 1.4) give the class-1 probability of every node.
+    counts = estimator.tree_.value[:, 0, :]
+    return counts[:, 1] / counts.sum(axis=1)
+
+# QuickScorer keeps one 64-bit leaf mask per tree.
+QUICKSCORER_MAX_LEAVES = 64
+
+def evaluation_mode(estimators):
+    # Shallow boosted trees are scored fastest with QuickScorer; forests and
+    # single trees are grown to full depth and keep plain traversal.
+    max_leaves = max(estimator.tree_.n_leaves for estimator in estimators)
+    return 'quickscorer' if max_leaves <= QUICKSCORER_MAX_LEAVES else 'traversal'
+
+def export_trees(model, num_features):
+    if isinstance(model, DecisionTreeClassifier):
+        trees = [export_tree(model, positive_class_fraction(model))]
+        return {'aggregation': 'mean_probability', 'base_score': 0.0, 'trees': trees}
+
+    if isinstance(model, RandomForestClassifier):
+        trees = [export_tree(tree, positive_class_fraction(tree)) for tree in model.estimators_]
+        return {'aggregation': 'mean_probability', 'base_score': 0.0, 'trees': trees}
+
+    if isinstance(model, GradientBoostingClassifier):
+        # The learning rate is folded into the leaves and the prior log-odds
+        # of the init estimator becomes the base score.
+        base_score = float(model._raw_predict_init(np.zeros((1, num_features), dtype=np.float32))[0, 0])
+        trees = [
+            export_tree(stage[0], stage[0].tree_.value[:, 0, 0] * model.learning_rate)
+            for stage in model.estimators_
+        ]
+        return {
+            'aggregation': 'sum_logit',
+            'base_score': base_score,
+            'evaluation': evaluation_mode([stage[0] for stage in model.estimators_]),
+            'trees': trees
+        }
+
+    return None
+
+def export_linear(model):
+    if not isinstance(model, LogisticRegression) or model.coef_.shape[0] != 1:
+        return None
+
+    return {
+        'coefficients': model.coef_[0].astype(float).tolist(),
+        'intercept': float(model.intercept_[0])
+    }
+
+# Components of the random Fourier feature approximation of an RBF SVC.
+RFF_COMPONENTS = 256
+
+def fit_svm_approximation(model, X_train, X_eval, n_components=RFF_COMPONENTS, alpha=1.0, random_state=42):
+    """Fits a random Fourier feature approximation of an RBF SVC.
+
+    z(x) = sqrt(2 / D) cos(xW + b) approximates the model's RBF kernel, and a
+    ridge regression on z is trained to reproduce the SVC decision function
+    on X_train, so scoring costs the same whatever the number of support
+    vectors. Returns the section for export_native_model and the fraction
+    of X_eval rows on which it predicts the same class as the SVC.
+    """
+    sampler = RBFSampler(gamma=model._gamma, n_components=n_components, random_state=random_state)
+    sampler.fit(X_train)
+    ridge = Ridge(alpha=alpha).fit(sampler.transform(X_train), model.decision_function(X_train))
+
+    approximate = ridge.predict(sampler.transform(X_eval))
+    agreement = float(np.mean((approximate > 0) == (model.decision_function(X_eval) > 0)))
+
+    section = {
+        'weights': np.asarray(sampler.random_weights_, dtype=np.float64).T.tolist(),
+        'offsets': np.asarray(sampler.random_offset_, dtype=np.float64).tolist(),
+        # The sqrt(2 / D) of z is folded into the linear layer.
+        'coefficients': (ridge.coef_ * np.sqrt(2.0 / n_components)).astype(float).tolist(),
+        'intercept': float(ridge.intercept_),
+        'agreement': agreement
+    }
+    return section, agreement
+
+def export_svm(model, approximation=None):
+    # Probabilities need the Platt parameters fitted by probability=True.
+    # They are read from the private attributes because the public probA_
+    # and probB_ are deprecated.
+    if not isinstance(model, SVC) or model.kernel != 'rbf' or not model.probability:
+        return None
+
+    prob_a = getattr(model, '_probA', None)
+    prob_b = getattr(model, '_probB', None)
+    if prob_a is None or prob_b is None or len(prob_a) != 1:
+        return None
+
+    # dual_coef_ and intercept_ carry sklearn's public sign: a positive
+    # decision value means classes_[1].
+    section = {
+        'kernel': 'rbf',
+        'gamma': float(model._gamma),
+        'support_vectors': np.asarray(model.support_vectors_, dtype=np.float64).tolist(),
+        'dual_coef': np.asarray(model.dual_coef_[0], dtype=np.float64).tolist(),
+        'intercept': float(model.intercept_[0]),
+        'prob_a': float(prob_a[0]),
+        'prob_b': float(prob_b[0])
+    }
+
+    if approximation is not None:
+        section['random_features'] = approximation
+    return section
+
+def export_knn(model):
+    # Exact search over the training rows, which KNeighborsClassifier keeps
+    # already scaled. Only the Euclidean metric is supported.
+    if not isinstance(model, KNeighborsClassifier) or model.effective_metric_ != 'euclidean':
+        return None
+    if model.weights not in ('uniform', 'distance'):
+        return None
+
+    # _y holds every row's index into classes_.
+    return {
+        'n_neighbors': int(model.n_neighbors),
+        'weights': model.weights,
+        'references': np.asarray(model._fit_X, dtype=np.float64).tolist(),
+        'targets': np.asarray(model._y, dtype=int).tolist()
+    }
+
+def export_naive_bayes(model):
+    if not isinstance(model, GaussianNB):
+        return None
+
+    # var_ already includes the var_smoothing term added during fit.
+    return {
+        'theta': np.asarray(model.theta_, dtype=np.float64).tolist(),
+        'var': np.asarray(model.var_, dtype=np.float64).tolist(),
+        'class_prior': np.asarray(model.class_prior_, dtype=np.float64).tolist()
+    }
+
+def export_scaler(scaler, num_features):
+    # Stored as trained; the engine folds it into the model where it can.
+    mean = scaler.mean_ if scaler.mean_ is not None else np.zeros(num_features)
+    scale = scaler.scale_ if scaler.scale_ is not None else np.ones(num_features)
+    return {'mean': np.asarray(mean, dtype=np.float64).tolist(), 'scale': np.asarray(scale, dtype=np.float64).tolist()}
+
+def native_artifact(model, features, scaler=None, svm_approximation=None):
+    """Builds the artifact dictionary for model, None when the engine does
+    not support it. Arguments are as for export_native_model."""
+    if len(getattr(model, 'classes_', [])) != 2:
+        return None
+
+    artifact = {
+        'format': NATIVE_FORMAT,
+        'version': NATIVE_VERSION,
+        'classes': [int(c) for c in model.classes_],
+        'num_features': len(features),
+        'features': list(features)
+    }
+
+    if scaler is not None:
+        artifact['scaler'] = export_scaler(scaler, len(features))
+
+    trees = export_trees(model, len(features))
+    linear = export_linear(model)
+    svm = export_svm(model, svm_approximation)
+    knn = export_knn(model)
+    naive_bayes = export_naive_bayes(model)
+
+    if trees is not None:
+        artifact['model'] = 'trees'
+        artifact['trees'] = trees
+    elif linear is not None:
+        artifact['model'] = 'linear'
+        artifact['linear'] = linear
+    elif svm is not None:
+        artifact['model'] = 'svm'
+        artifact['svm'] = svm
+    elif knn is not None:
+        artifact['model'] = 'knn'
+        artifact['knn'] = knn
+    elif naive_bayes is not None:
+        artifact['model'] = 'naive_bayes'
+        artifact['naive_bayes'] = naive_bayes
+    else:
+        return None
+
+    return artifact
+
+def export_native_model(model, features, path, scaler=None, svm_approximation=None):
+    """Writes model to path for the C++ native engine.
+
+    scaler is the fitted StandardScaler when the model was trained on
+    scaled features, None otherwise. svm_approximation is an optional
+    section from fit_svm_approximation stored with an SVC.
+
+    Returns False (and writes nothing) for models the engine does not
+    support, so callers can fall back to the Python service.
+    """
+    artifact = native_artifact(model, features, scaler, svm_approximation)
+    if artifact is None:
+        return False
+
+    with open(path, 'w') as f:
+        json.dump(artifact, f)
+
+    return True
+
+# Binary bundle, see ui/include/native/model_bundle.h for the layout.
+BUNDLE_MAGIC = b'MLBUNDLE'
+BUNDLE_VERSION = 1
+BUNDLE_ALIGNMENT = 64
+BUNDLE_HEADER = struct.Struct('<8sIIQQII24x')
+BUNDLE_ENTRY = struct.Struct('<32sIIQQQ')
+BUNDLE_TYPES = {np.dtype('<f4'): 1, np.dtype('<f8'): 2, np.dtype('<i4'): 3, np.dtype('u1'): 4}
+BUNDLE_TEXT = 5
+
+# Rows the engine scans per vector; row sets it scans are padded to a
+# multiple of this.
+VECTOR_LANES = 8
+
+def padded_length(count):
+    return -(-count // VECTOR_LANES) * VECTOR_LANES
+
+def feature_major(rows):
+    # One float32 row per feature, padded with zeros to whole vectors.
+    rows = np.asarray(rows, dtype=np.float64)
+    matrix = np.zeros((rows.shape[1], padded_length(rows.shape[0])), dtype='<f4')
+    matrix[:, :rows.shape[0]] = rows.T
+    return matrix
+
+def padded(values, dtype):
+    values = np.asarray(values)
+    result = np.zeros(padded_length(len(values)), dtype=dtype)
+    result[:len(values)] = values
+    return result
+
+def bundle_sections(artifact):
+    """Splits an artifact into its metadata and arrays.
+
+    Arrays are taken out of the metadata and returned as named sections in
+    the layout the engine uses, so it can read them in place.
+    """
+    metadata = {key: value for key, value in artifact.items()
+                if key not in ('scaler', 'trees', 'linear', 'svm', 'knn', 'naive_bayes')}
+    sections = {}
+
+    if 'scaler' in artifact:
+        sections['scaler.mean'] = np.asarray(artifact['scaler']['mean'], dtype='<f8')
+        sections['scaler.scale'] = np.asarray(artifact['scaler']['scale'], dtype='<f8')
+
+    kind = artifact['model']
+    section = artifact[kind]
+
+    if kind == 'trees':
+        trees = section['trees']
+        metadata['trees'] = {key: value for key, value in section.items() if key != 'trees'}
+        sections['trees.offsets'] = np.cumsum([0] + [len(tree['feature']) for tree in trees]).astype('<i4')
+        for name, dtype in (('feature', '<i4'), ('threshold', '<f4'), ('left', '<i4'), ('right', '<i4'), ('value', '<f8')):
+            sections['trees.' + name] = np.concatenate([np.asarray(tree[name], dtype=dtype) for tree in trees])
+        if all('samples' in tree for tree in trees):
+            sections['trees.samples'] = np.concatenate([np.asarray(tree['samples'], dtype='<f8') for tree in trees])
+    elif kind == 'linear':
+        metadata['linear'] = {'intercept': section['intercept']}
+        sections['linear.coefficients'] = np.asarray(section['coefficients'], dtype='<f8')
+    elif kind == 'svm':
+        metadata['svm'] = {key: value for key, value in section.items()
+                           if key not in ('support_vectors', 'dual_coef', 'random_features')}
+        metadata['svm']['support_vector_count'] = len(section['dual_coef'])
+        sections['svm.support_vectors'] = feature_major(section['support_vectors'])
+        sections['svm.dual_coef'] = padded(section['dual_coef'], '<f8')
+        if 'random_features' in section:
+            layer = section['random_features']
+            metadata['svm']['random_features'] = {
+                'components': len(layer['offsets']),
+                'intercept': layer['intercept'],
+                'agreement': layer['agreement']
+            }
+            sections['svm.rff.weights'] = feature_major(layer['weights'])
+            sections['svm.rff.offsets'] = padded(layer['offsets'], '<f4')
+            sections['svm.rff.coefficients'] = padded(layer['coefficients'], '<f8')
+    elif kind == 'knn':
+        metadata['knn'] = {'n_neighbors': section['n_neighbors'], 'weights': section['weights'],
+                           'reference_count': len(section['targets'])}
+        sections['knn.references'] = feature_major(section['references'])
+        sections['knn.targets'] = np.asarray(section['targets'], dtype='u1')
+    elif kind == 'naive_bayes':
+        metadata['naive_bayes'] = {}
+        for name in ('theta', 'var', 'class_prior'):
+            sections['naive_bayes.' + name] = np.asarray(section[name], dtype='<f8')
+
+    return metadata, sections
+
+def align_offset(offset):
+    return -(-offset // BUNDLE_ALIGNMENT) * BUNDLE_ALIGNMENT
+
+def write_bundle(path, metadata, sections):
+    entries = [('metadata', BUNDLE_TEXT, json.dumps(metadata).encode('utf-8'), None)]
+    for name, values in sections.items():
+        values = np.ascontiguousarray(values)
+        entries.append((name, BUNDLE_TYPES[values.dtype], values.tobytes(), values.shape))
+
+    directory_offset = BUNDLE_HEADER.size
+    offset = align_offset(directory_offset + len(entries) * BUNDLE_ENTRY.size)
+    directory = bytearray()
+    placed = []
+    for name, element_type, data, shape in entries:
+        if shape is None:
+            rows, columns = len(data), 1
+        elif len(shape) == 1:
+            rows, columns = shape[0], 1
+        else:
+            rows, columns = shape
+        directory += BUNDLE_ENTRY.pack(name.encode('ascii'), element_type, 0, offset, rows, columns)
+        placed.append((offset, data))
+        offset = align_offset(offset + len(data))
+
+    file_size = placed[-1][0] + len(placed[-1][1])
+    body = bytearray(file_size - BUNDLE_HEADER.size)
+    body[:len(directory)] = directory
+    for section_offset, data in placed:
+        start = section_offset - BUNDLE_HEADER.size
+        body[start:start + len(data)] = data
+
+    header = BUNDLE_HEADER.pack(BUNDLE_MAGIC, BUNDLE_VERSION, len(entries), file_size, directory_offset,
+                                zlib.crc32(body), 0)
+    with open(path, 'wb') as f:
+        f.write(header)
+        f.write(body)
+
+def export_native_bundle(model, features, path, scaler=None, svm_approximation=None):
+    """Writes model to path as a binary bundle the C++ engine memory-maps.
+
+    Arguments and return value are as for export_native_model.
+    """
+    artifact = native_artifact(model, features, scaler, svm_approximation)
+    if artifact is None:
+        return False
+
+    write_bundle(path, *bundle_sections(artifact))
+    return True
@@ -1,6 +1,10 @@
 import sys
 import json
+import mmap
 import pickle
+import select
+import struct
+import time
 import numpy as np
 import os
 import warnings
@@ -11,6 +15,39 @@ from dotenv import load_dotenv
 
 load_dotenv()
 
+# Binary framing, see ui/include/utils/binary_frame.h for the layout.
+FRAME_HEADER = struct.Struct('<IBBHIIQ')
+FRAME_MAGIC = 0x46424C4D
+FRAME_PREDICT = 0x01
+FRAME_INFO = 0x02
+FRAME_EXIT = 0x03
+FRAME_RESULT = 0x81
+FRAME_JSON = 0x82
+
+# Shared-memory rings, see ui/include/app/shm_transport.h for the layout.
+SHM_MAGIC = 0x48534C4D
+SHM_REQUEST_TAIL = 64
+SHM_REQUEST_HEAD = 128
+SHM_REQUEST_WAITING = 192
+SHM_RESPONSE_TAIL = 256
+SHM_RESPONSE_HEAD = 320
+SHM_RESPONSE_WAITING = 384
+SHM_DATA = 512
+SHM_SPIN_SECONDS = 0.0001
+# Python cannot issue a store-load fence, so a wake-up can be missed in a
+# narrow window; sleeping with a timeout bounds the cost of that to 1 ms.
+SHM_SLEEP_SECONDS = 0.001
+
+def pin_to_cpu():
+    cpu = os.getenv("ML_WORKER_CPU")
+    if cpu is None or not hasattr(os, 'sched_setaffinity'):
+        return
+
+    try:
+        os.sched_setaffinity(0, {int(cpu)})
+    except (ValueError, OSError) as e:
+        print(f"Could not pin worker to CPU {cpu}: {e}", file=sys.stderr)
+
 def load_model():
     with open(os.getenv("MODEL_PATH"), 'rb') as f:
         model = pickle.load(f)
@@ -21,27 +58,249 @@ def load_model():
     with open(os.getenv("METADATA_PATH"), 'r') as f:
         metadata = json.load(f)
 
+    metadata['model_fingerprint'] = model_fingerprint(os.getenv("MODEL_PATH"))
+
     return model, scaler, metadata
 
+def model_fingerprint(path):
+    # Changes whenever the model file is replaced, so clients can drop
+    # anything they cached for the previous model.
+    stat = os.stat(path)
+    return f"{stat.st_size}-{stat.st_mtime_ns}"
+
+def predict_matrix(features_matrix, model, scaler, uses_scaling):
+    if uses_scaling:
+        features_matrix = scaler.transform(features_matrix)
+
+    predictions = model.predict(features_matrix)
+    probabilities = model.predict_proba(features_matrix)[:, 1]
+
+    return predictions.astype(int), probabilities.astype(float)
+
 def predict(features, model, scaler, uses_scaling):
     features_array = np.array(features).reshape(1, -1)
+    predictions, probabilities = predict_matrix(features_array, model, scaler, uses_scaling)
 
-    if uses_scaling:
-        features_scaled = scaler.transform(features_array)
-        prediction = model.predict(features_scaled)[0]
-        probability = model.predict_proba(features_scaled)[0]
-    else:
-        prediction = model.predict(features_array)[0]
-        probability = model.predict_proba(features_array)[0]
+    return int(predictions[0]), float(probabilities[0])
+
+def predict_batch(rows, model, scaler, uses_scaling):
+    features_matrix = np.asarray(rows, dtype=np.float64)
+    if features_matrix.ndim != 2:
+        raise ValueError('rows must be a list of equally sized feature lists')
+
+    predictions, probabilities = predict_matrix(features_matrix, model, scaler, uses_scaling)
+
+    return predictions.tolist(), probabilities.tolist()
+
+def respond(response, request_id=None):
+    if request_id is not None:
+        response['id'] = request_id
+    print(json.dumps(response), flush=True)
+
+def info_response(metadata):
+    return {
+        'status': 'success',
+        'data': {
+            'model_name': metadata['best_model'],
+            'features': metadata['features'],
+            'num_features': metadata['num_features'],
+            'metrics': metadata['metrics'],
+            'model_fingerprint': metadata.get('model_fingerprint', '')
+        }
+    }
+
+def read_exact(stream, size):
+    data = b''
+    while len(data) < size:
+        chunk = stream.read(size - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+def write_frame(stream, frame_type, request_id, payload=b'', count=0, columns=0):
+    header = FRAME_HEADER.pack(FRAME_MAGIC, frame_type, 0, columns, count, len(payload), request_id)
+    stream.write(header + payload)
+    stream.flush()
+
+def write_json_frame(stream, response, request_id):
+    write_frame(stream, FRAME_JSON, request_id, json.dumps(response).encode('utf-8'))
+
+class SharedMemoryChannel:
+    """Byte-stream view of the shared-memory rings with the same read/write/flush
+    interface as the stdio buffers, so serve_binary works on either."""
+
+    def __init__(self, name, request_fd, response_fd):
+        fd = os.open('/dev/shm/' + name.lstrip('/'), os.O_RDWR)
+        try:
+            self.region = mmap.mmap(fd, os.fstat(fd).st_size)
+        finally:
+            os.close(fd)
+
+        magic, _, capacity = struct.unpack_from('<IIQ', self.region, 0)
+        if magic != SHM_MAGIC:
+            raise ValueError('shared-memory region has an unexpected layout')
+
+        self.capacity = capacity
+        self.request_data = SHM_DATA
+        self.response_data = SHM_DATA + capacity
+        self.request_fd = request_fd
+        self.response_fd = response_fd
+        self.stdin_fd = sys.stdin.fileno()
+
+    def _load(self, offset):
+        return struct.unpack_from('<Q', self.region, offset)[0]
+
+    def _store(self, offset, value):
+        struct.pack_into('<Q', self.region, offset, value)
+
+    def _wait_for_requests(self, head):
+        deadline = time.perf_counter() + SHM_SPIN_SECONDS
+        while time.perf_counter() < deadline:
+            tail = self._load(SHM_REQUEST_TAIL)
+            if tail != head:
+                return tail
+
+        while True:
+            self._store(SHM_REQUEST_WAITING, 1)
+            tail = self._load(SHM_REQUEST_TAIL)
+            if tail != head:
+                self._store(SHM_REQUEST_WAITING, 0)
+                return tail
+
+            readable, _, _ = select.select([self.request_fd, self.stdin_fd], [], [], SHM_SLEEP_SECONDS)
+            self._store(SHM_REQUEST_WAITING, 0)
+
+            if self.request_fd in readable:
+                try:
+                    os.read(self.request_fd, 8)
+                except BlockingIOError:
+                    pass
+
+            # stdin is idle after the handshake; EOF means the parent is gone.
+            if self.stdin_fd in readable and not os.read(self.stdin_fd, 4096):
+                return None
+
+            tail = self._load(SHM_REQUEST_TAIL)
+            if tail != head:
+                return tail
+
+    def read(self, size):
+        head = self._load(SHM_REQUEST_HEAD)
+        tail = self._load(SHM_REQUEST_TAIL)
+        if tail == head:
+            tail = self._wait_for_requests(head)
+            if tail is None:
+                return b''
+
+        count = min(size, tail - head)
+        position = head % self.capacity
+        first = min(count, self.capacity - position)
+
+        start = self.request_data + position
+        data = self.region[start:start + first]
+        if count > first:
+            data += self.region[self.request_data:self.request_data + count - first]
+
+        self._store(SHM_REQUEST_HEAD, head + count)
+        return data
+
+    def write(self, data):
+        written = 0
+        while written < len(data):
+            tail = self._load(SHM_RESPONSE_TAIL)
+            available = self.capacity - (tail - self._load(SHM_RESPONSE_HEAD))
+            if available == 0:
+                time.sleep(0)
+                continue
+
+            count = min(available, len(data) - written)
+            position = tail % self.capacity
+            first = min(count, self.capacity - position)
+
+            start = self.response_data + position
+            self.region[start:start + first] = data[written:written + first]
+            if count > first:
+                self.region[self.response_data:self.response_data + count - first] = \
+                    data[written + first:written + count]
+
+            self._store(SHM_RESPONSE_TAIL, tail + count)
+            written += count
+            self.flush()
+
+    def flush(self):
+        if self._load(SHM_RESPONSE_WAITING):
+            os.write(self.response_fd, (1).to_bytes(8, 'little'))
+
+def open_shared_memory_channel():
+    name = os.getenv('ML_SHM_NAME')
+    if not name:
+        return None
+
+    try:
+        return SharedMemoryChannel(
+            name,
+            int(os.getenv('ML_SHM_REQUEST_FD')),
+            int(os.getenv('ML_SHM_RESPONSE_FD'))
+        )
+    except (OSError, ValueError, TypeError) as e:
+        print(f'shared memory unavailable, using pipes: {e}', file=sys.stderr, flush=True)
+        return None
+
+def serve_binary(stdin, stdout, model, scaler, metadata):
+    while True:
+        header = read_exact(stdin, FRAME_HEADER.size)
+        if header is None:
+            return
+
+        magic, frame_type, _, columns, count, payload_bytes, request_id = FRAME_HEADER.unpack(header)
+        if magic != FRAME_MAGIC:
+            print('corrupted frame header, stopping', file=sys.stderr, flush=True)
+            return
 
-    return int(prediction), float(probability[1])
+        payload = read_exact(stdin, payload_bytes) if payload_bytes else b''
+        if payload is None:
+            return
+
+        if frame_type == FRAME_EXIT:
+            return
+
+        try:
+            if frame_type == FRAME_INFO:
+                write_json_frame(stdout, info_response(metadata), request_id)
+                continue
+
+            if frame_type != FRAME_PREDICT:
+                raise ValueError(f'unknown frame type {frame_type}')
+
+            features_matrix = np.frombuffer(payload, dtype='<f4').reshape(count, columns)
+            predictions, probabilities = predict_matrix(
+                features_matrix.astype(np.float64),
+                model,
+                scaler,
+                metadata['uses_scaling']
+            )
+
+            result = probabilities.astype('<f4').tobytes() + predictions.astype('i1').tobytes()
+            write_frame(stdout, FRAME_RESULT, request_id, result, count=count)
+
+        except Exception as e:
+            write_json_frame(stdout, {'status': 'error', 'message': str(e)}, request_id)
 
 def main():
+    pin_to_cpu()
+
     try:
         model, scaler, metadata = load_model()
 
-        for line in sys.stdin:
-            line = line.strip()
+        stdin = sys.stdin.buffer
+
+        while True:
+            raw = stdin.readline()
+            if not raw:
+                break
+
+            line = raw.decode('utf-8').strip()
             if not line:
                 continue
 
@@ -49,20 +308,62 @@ def main():
                 break
 
             if line == "INFO":
-                response = {
-                    'status': 'success',
-                    'data': {
-                        'model_name': metadata['best_model'],
-                        'features': metadata['features'],
-                        'num_features': metadata['num_features'],
-                        'metrics': metadata['metrics']
-                    }
-                }
-                print(json.dumps(response), flush=True)
+                respond(info_response(metadata))
                 continue
 
+            request_id = None
+
             try:
                 data = json.loads(line)
+                request_id = data.get('id')
+                command = data.get('command', 'PREDICT')
+
+                if command == 'EXIT':
+                    break
+
+                if command == 'HELLO':
+                    protocol = 'binary' if 'binary' in data.get('protocols', []) else 'json'
+
+                    channel = None
+                    if protocol == 'binary' and 'shm' in data.get('transports', []):
+                        channel = open_shared_memory_channel()
+
+                    response = {
+                        'status': 'success',
+                        'protocol': protocol,
+                        'transport': 'shm' if channel else 'pipe'
+                    }
+                    respond(response, request_id)
+
+                    if channel:
+                        serve_binary(channel, channel, model, scaler, metadata)
+                        break
+
+                    if protocol == 'binary':
+                        serve_binary(stdin, sys.stdout.buffer, model, scaler, metadata)
+                        break
+                    continue
+
+                if command == 'INFO':
+                    respond(info_response(metadata), request_id)
+                    continue
+
+                if command == 'BATCH':
+                    predictions, probabilities = predict_batch(
+                        data['rows'],
+                        model,
+                        scaler,
+                        metadata['uses_scaling']
+                    )
+
+                    response = {
+                        'status': 'success',
+                        'predictions': predictions,
+                        'probabilities': probabilities
+                    }
+                    respond(response, request_id)
+                    continue
+
                 features = data['features']
 
                 prediction, probability = predict(
@@ -77,21 +378,21 @@ def main():
                     'prediction': prediction,
                     'probability': probability
                 }
-                print(json.dumps(response), flush=True)
+                respond(response, request_id)
 
             except Exception as e:
                 response = {
                     'status': 'error',
                     'message': str(e)
                 }
-                print(json.dumps(response), flush=True)
+                respond(response, request_id)
 
     except Exception as e:
         response = {
             'status': 'error',
             'message': f'initialization error: {str(e)}'
         }
-        print(json.dumps(response), flush=True)
+        respond(response)
         sys.exit(1)
 
 if __name__ == '__main__':
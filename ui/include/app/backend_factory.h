@@ -0,0 +1,23 @@
+#pragma once
+#ifndef BACKEND_FACTORY_H
+#define BACKEND_FACTORY_H
+
+#include <QObject>
+#include <memory>
+#include <string>
+
+#include "inference_backend.h"
+
+// Creates the backend named by INFERENCE_BACKEND in .env: "python" (the
+// default, predict_service.py workers), "embedded" (predict_service.py in an
+// in-process CPython), "onnx" (best_model.onnx in-process, on ONNX Runtime
+// or the built-in interpreter) or "native" (the built-in engine in
+// include/native).
+class BackendFactory {
+public:
+  // nullptr for unknown names or backends that were not compiled in.
+  static std::unique_ptr<InferenceBackend> create(const std::string& name, QObject* parent = nullptr);
+  static std::unique_ptr<InferenceBackend> fromEnv(QObject* parent = nullptr);
+};
+
+#endif // BACKEND_FACTORY_H
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef EMBEDDED_PYTHON_BACKEND_H
+#define EMBEDDED_PYTHON_BACKEND_H
+
+#include <QObject>
+#include <QString>
+#include <QDebug>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include "env_loader.h"
+#include "inference_backend.h"
+#include "model_info.h"
+#include "prediction_result.h"
+
+// Runs predict_service.py's predict_matrix inside the application's own
+// CPython interpreter instead of in worker processes, so models the native
+// engine cannot port keep sklearn's exact semantics without process spawn,
+// pipe round trips or serialization.
+//
+// Rows are widened to float64 into a buffer the backend owns and handed to
+// Python as a read-only numpy array over that buffer, without a copy. The
+// GIL is only held while Python runs; the interpreter itself is started
+// once per process and never finalized, since numpy cannot be re-imported
+// into a fresh interpreter.
+//
+// Only available when CMake found the Python development files and numpy
+// (HAVE_EMBEDDED_PYTHON).
+class EmbeddedPythonBackend : public InferenceBackend {
+  Q_OBJECT
+
+public:
+  explicit EmbeddedPythonBackend(QObject *parent = nullptr);
+  ~EmbeddedPythonBackend();
+
+  // Whether CPython was compiled in.
+  static bool isAvailable();
+
+  std::string name() const override;
+
+  // Imports PYTHON_SERVICE_PATH as a module and loads MODEL_PATH,
+  // SCALER_PATH and METADATA_PATH through its load_model(). The first
+  // backend to initialize starts the interpreter as if it were
+  // PYTHON_INTERPRETER_PATH, so a virtualenv's packages are found.
+  bool initialize() override;
+
+  ModelInfo info() override;
+  PredictionResult predict(const std::vector<float>& features) override;
+  std::vector<PredictionResult> predictBatch(const std::vector<std::vector<float>>& rows) override;
+
+  void shutdown();
+
+private:
+  struct Service;
+
+  std::vector<PredictionResult> score(const std::vector<std::vector<float>>& rows, bool batch);
+  std::vector<PredictionResult> fail(size_t rowCount, const std::string& message);
+
+  std::unique_ptr<Service> service;
+  std::string metadataPath;
+  std::string modelPath;
+};
+
+#endif // EMBEDDED_PYTHON_BACKEND_H
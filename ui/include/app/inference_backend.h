@@ -0,0 +1,66 @@
+#pragma once
+#ifndef INFERENCE_BACKEND_H
+#define INFERENCE_BACKEND_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "log2_histogram.h"
+#include "model_info.h"
+#include "prediction_result.h"
+
+// Common interface of everything that can score the heart disease model, so
+// the UI does not depend on where inference actually runs. Implementations
+// are created by BackendFactory.
+class InferenceBackend : public QObject {
+  Q_OBJECT
+
+public:
+  struct Stats {
+    std::string backend;
+    quint64 requests = 0;   // single-row predictions
+    quint64 batches = 0;    // predictBatch calls
+    quint64 rows = 0;       // rows scored by both
+    Log2Histogram latencyUs;
+    // Backend specific counters, e.g. cache hit rate.
+    std::vector<std::pair<std::string, double>> details;
+  };
+
+  explicit InferenceBackend(QObject *parent = nullptr);
+  virtual ~InferenceBackend() = default;
+
+  virtual std::string name() const = 0;
+
+  // Reads its configuration from .env and loads the model.
+  virtual bool initialize() = 0;
+
+  virtual ModelInfo info() = 0;
+  virtual PredictionResult predict(const std::vector<float>& features) = 0;
+  virtual std::vector<PredictionResult> predictBatch(const std::vector<std::vector<float>>& rows) = 0;
+
+  // Returns a request id and delivers the result through predictionReady().
+  // The default runs predict() right away and emits on the next event loop
+  // iteration, which suits in-process backends.
+  virtual quint64 predictAsync(const std::vector<float>& features);
+
+  virtual Stats stats() const;
+
+  signals:
+      void errorOccurred(const QString& error);
+      void predictionReady(quint64 requestId, const PredictionResult& result);
+
+protected:
+  qint64 nowNs() const;
+  void recordCall(size_t rows, bool batch, qint64 startedNs);
+
+private:
+  QElapsedTimer statsClock;
+  Stats callStats;
+  quint64 nextAsyncId;
+};
+
+#endif // INFERENCE_BACKEND_H
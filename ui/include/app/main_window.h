@@ -20,7 +20,7 @@
 #include <optional>
 #include <random>
 
-#include "python_bridge.h"
+#include "backend_factory.h"
 #include "feature_limits.h"
 #include "model_info.h"
 
@@ -33,7 +33,8 @@ public:
 private slots:
   void onPredictClicked();
   void onClearClicked();
-  void onPythonError(const QString& error);
+  void onBackendError(const QString& error);
+  void onPredictionReady(quint64 requestId, const PredictionResult& result);
   void onLangToggle();
   void onRandomData();
 
@@ -43,6 +44,7 @@ private:
   void updateTheme();
   void updateTexts();
   std::optional<std::vector<float>> validateAndCollect();
+  void showPrediction(const PredictionResult& result);
 
   QWidget *central;
   QVBoxLayout *mainLayout;
@@ -62,8 +64,9 @@ private:
   QPushButton *langBtn;
   QPushButton *randomBtn;
 
-  std::unique_ptr<PythonBridge> bridge;
+  std::unique_ptr<InferenceBackend> backend;
   ModelInfo modelInfo;
+  quint64 pendingPredictionId = 0;
   std::map<std::string, QLineEdit*> inputFields;
   std::map<std::string, QLabel*> featureLabels;
 
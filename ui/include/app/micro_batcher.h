@@ -0,0 +1,71 @@
+#pragma once
+#ifndef MICRO_BATCHER_H
+#define MICRO_BATCHER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <vector>
+
+#include "log2_histogram.h"
+
+// Gathers single-row predictions into vectorized calls. While the transport
+// has spare capacity a request is flushed on its own, so a lone request is
+// never delayed. Once every allowed batch is in flight, requests queue until
+// one of those batches completes, maxBatch rows are waiting or the window
+// expires, whichever comes first. Under load the batch size therefore grows
+// with the queue depth, and an idle system answers immediately.
+class MicroBatcher : public QObject {
+  Q_OBJECT
+
+public:
+  struct Options {
+    int windowUs = 200;
+    size_t maxBatch = 32;      // 1 disables batching
+    size_t maxInFlight = 1;    // batches allowed on the wire at once
+  };
+
+  struct Entry {
+    quint64 requestId;
+    std::vector<float> features;
+    qint64 enqueuedNs;
+  };
+
+  struct Stats {
+    Log2Histogram batchSizes;
+    Log2Histogram queueWaitUs;
+  };
+
+  explicit MicroBatcher(QObject *parent = nullptr);
+
+  void configure(const Options& options);
+  void setMaxInFlight(size_t maxInFlight);
+
+  void enqueue(quint64 requestId, std::vector<float> features);
+
+  // Sends everything queued right away, e.g. for a blocking caller.
+  void flush();
+
+  // Must be called once for every batch emitted through batchReady().
+  void batchCompleted();
+
+  void clear();
+
+  size_t queued() const;
+  const Stats& stats() const;
+
+  signals:
+      void batchReady(const std::vector<MicroBatcher::Entry>& entries);
+
+private:
+  void flushUpTo(size_t count);
+
+  Options options;
+  std::vector<Entry> queue;
+  size_t inFlight;
+  QElapsedTimer clock;
+  QTimer windowTimer;
+  Stats batchStats;
+};
+
+#endif // MICRO_BATCHER_H
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef NATIVE_BACKEND_H
+#define NATIVE_BACKEND_H
+
+#include <QObject>
+#include <QString>
+#include <QDebug>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "env_loader.h"
+#include "inference_backend.h"
+#include "native_model.h"
+
+// Scores the model in-process with the dependency-free engine in
+// include/native, loading the artifact written by native_export.py.
+class NativeBackend : public InferenceBackend {
+  Q_OBJECT
+
+public:
+  explicit NativeBackend(QObject *parent = nullptr);
+
+  std::string name() const override;
+
+  // Loads NATIVE_MODEL_PATH, a native_model.json artifact, a
+  // native_model.bin bundle or a best_model.pkl pickle (scaled with
+  // SCALER_PATH when the metadata says so); model metadata is read from
+  // METADATA_PATH.
+  // In builds with ML_GENERATED_MODEL an unset NATIVE_MODEL_PATH selects the
+  // model compiled into the app.
+  // NATIVE_TREE_EVALUATION=traversal|quickscorer|simd overrides the evaluation
+  // mode stored in a tree ensemble artifact, and NATIVE_NODE_LAYOUT with
+  // NATIVE_SHARED_TOP_LEVELS reorders its nodes for traversal.
+  // NATIVE_SVM_EVALUATION=exact|rff selects how an SVM is scored.
+  // NATIVE_KNN_INDEX attaches an HNSW index to a KNN model, searched with
+  // NATIVE_KNN_EF.
+  // NATIVE_THREADS caps the shared pool threads a batch is split across
+  // (default all of them, 1 keeps batches on the calling thread). The pool
+  // runs one batch at a time: a batch submitted while another backend's is
+  // in progress runs on the calling thread alone.
+  bool initialize() override;
+
+  ModelInfo info() override;
+  PredictionResult predict(const std::vector<float>& features) override;
+  std::vector<PredictionResult> predictBatch(const std::vector<std::vector<float>>& rows) override;
+
+private:
+  std::unique_ptr<Native::Model> loadModelFile(const std::string& scalerPath) const;
+  std::vector<PredictionResult> fail(size_t rowCount, const std::string& message);
+
+  std::unique_ptr<Native::Model> model;
+  std::string modelPath;
+  std::string metadataPath;
+  size_t threads = 0;
+  std::vector<float> rowBuffer;
+  std::vector<Native::Prediction> predictionBuffer;
+};
+
+#endif // NATIVE_BACKEND_H
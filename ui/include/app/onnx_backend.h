@@ -0,0 +1,71 @@
+#pragma once
+#ifndef ONNX_BACKEND_H
+#define ONNX_BACKEND_H
+
+#include <QObject>
+#include <QString>
+#include <QDebug>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include "env_loader.h"
+#include "inference_backend.h"
+#include "model_info.h"
+#include "onnx_model.h"
+#include "prediction_result.h"
+
+// Runs best_model.onnx in-process. The model is expected as exported by
+// model_training.ipynb: one float input of shape [N, features] and, with
+// zipmap disabled, an int64 label tensor plus a float probability tensor of
+// shape [N, classes].
+//
+// ONNX Runtime is used when it was found at configure time
+// (HAVE_ONNXRUNTIME). Otherwise, or with ONNX_ENGINE=builtin, the model runs
+// on the interpreter in include/native/onnx_model.h, which implements the
+// ai.onnx.ml operators the tree, linear and SVM models export to.
+class OnnxBackend : public InferenceBackend {
+  Q_OBJECT
+
+public:
+  explicit OnnxBackend(QObject *parent = nullptr);
+  ~OnnxBackend();
+
+  // Whether ONNX Runtime was compiled in.
+  static bool hasRuntime();
+
+  std::string name() const override;
+
+  // Loads ONNX_MODEL_PATH, or the given file. ONNX_ENGINE=runtime|builtin
+  // picks the engine (runtime when compiled in); an ONNX Runtime session
+  // uses ONNX_INTRA_OP_THREADS intra-op threads (default 1), the built-in
+  // interpreter splits batches across NATIVE_THREADS shared pool threads
+  // (default all; a batch arriving while the pool runs another backend's
+  // is scored on the calling thread alone). Model metadata is read from
+  // METADATA_PATH.
+  bool initialize() override;
+  bool initialize(const QString& modelPath);
+
+  ModelInfo info() override;
+  PredictionResult predict(const std::vector<float>& features) override;
+  std::vector<PredictionResult> predictBatch(const std::vector<std::vector<float>>& rows) override;
+
+  void shutdown();
+
+private:
+  struct Session;
+
+  std::vector<PredictionResult> score(const std::vector<std::vector<float>>& rows, bool batch);
+  std::vector<PredictionResult> scoreBuiltin(const std::vector<std::vector<float>>& rows, bool batch);
+  std::vector<PredictionResult> fail(size_t rowCount, const std::string& message);
+
+  std::unique_ptr<Session> session;
+  std::unique_ptr<Native::OnnxModel> interpreter;
+  size_t builtinThreads = 0;
+  std::vector<float> rowBuffer;
+  std::vector<Native::Prediction> predictionBuffer;
+  QString metadataPath;
+  QString modelPath;
+};
+
+#endif // ONNX_BACKEND_H
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef PREDICTION_CACHE_H
+#define PREDICTION_CACHE_H
+
+#include <QtGlobal>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "feature_limits.h"
+#include "prediction_result.h"
+
+// Bounded LRU cache of single-row predictions plus single-flight tracking of
+// rows already on their way to a worker. Features are quantized before
+// keying: integer features (per featureLimits()) are rounded to whole
+// numbers, all others to multiples of the configured resolution.
+class PredictionCache {
+public:
+  using Key = std::vector<int64_t>;
+
+  struct Stats {
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 coalesced = 0;
+    size_t entries = 0;
+    size_t capacity = 0;
+    size_t memoryBytes = 0;
+
+    double hitRate() const;
+  };
+
+  PredictionCache();
+
+  // capacity 0 disables caching and coalescing; resolution 0 keys
+  // non-integer features by their exact float value.
+  void configure(size_t capacity, double resolution);
+  void setFeatures(const std::vector<std::string>& names);
+  bool enabled() const;
+
+  Key makeKey(const std::vector<float>& features) const;
+
+  std::optional<PredictionResult> lookup(const Key& key);
+
+  // Single flight: the first request for a key becomes the leader and is
+  // sent; later identical requests join it until the leader finishes.
+  bool join(const Key& key, quint64 requestId);
+  void lead(const Key& key, quint64 requestId);
+
+  // Stores a successful result (unless the cache was invalidated while the
+  // leader was in flight) and returns the followers to fan it out to.
+  std::vector<quint64> finish(quint64 leaderId, const PredictionResult& result);
+
+  // Forgets a waiter that gave up. Returns the follower promoted in place of
+  // a leader, or 0.
+  quint64 drop(quint64 requestId);
+
+  // The leader a coalesced request is waiting on, or 0.
+  quint64 leaderOf(quint64 requestId) const;
+
+  // Drops all cached results, e.g. after a model change. Flights already on
+  // the wire still deliver to their waiters but are not cached.
+  void invalidate();
+  void reset();
+
+  Stats stats() const;
+
+private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  struct Entry {
+    Key key;
+    PredictionResult result;
+  };
+
+  struct Flight {
+    Key key;
+    quint64 generation;
+    std::vector<quint64> followers;
+  };
+
+  size_t capacity;
+  double resolution;
+  std::vector<bool> integerColumns;
+  quint64 generation;
+
+  std::list<Entry> entries;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+  std::unordered_map<quint64, Flight> flights;
+  std::unordered_map<Key, quint64, KeyHash> flightByKey;
+
+  quint64 hits;
+  quint64 misses;
+  quint64 coalesced;
+};
+
+#endif // PREDICTION_CACHE_H
@@ -3,40 +3,157 @@
 #define PYTHON_BRIDGE_H
 
 #include <QObject>
-#include <QProcess>
 #include <QString>
 #include <QDebug>
 #include <vector>
 #include <string>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "env_loader.h"
+#include "inference_backend.h"
+#include "python_worker.h"
+#include "micro_batcher.h"
+#include "prediction_cache.h"
 #include "model_info.h"
 #include "prediction_result.h"
 #include "json.hpp"
 
 using nmjson = nlohmann::json;
 
-class PythonBridge : public QObject {
+class PythonBridge : public InferenceBackend {
   Q_OBJECT
 
 public:
+  using Protocol = PythonWorker::Protocol;
+  using Transport = PythonWorker::Transport;
+
   explicit PythonBridge(QObject *parent = nullptr);
   ~PythonBridge();
 
+  std::string name() const override;
+
+  // Uses PYTHON_SERVICE_PATH as the script.
+  bool initialize() override;
+
+  // Starts PYTHON_WORKERS service processes (default 1) and negotiates the
+  // wire protocol with each. Binary framing is used unless
+  // PYTHON_PROTOCOL=json is set or the service does not support it, in which
+  // case newline-delimited JSON is kept. PYTHON_TRANSPORT=shm additionally
+  // moves binary frames from the pipes to shared memory.
   bool initialize(const QString& pythonScript = "predict_service.py");
-  ModelInfo getModelInfo();
-  PredictionResult predict(const std::vector<float>& features);
+  Protocol protocol() const;
+  Transport transport() const;
+  size_t workerCount() const;
+
+  ModelInfo info() override;
+  PredictionResult predict(const std::vector<float>& features) override;
+
+  // Queues a prediction and returns immediately. The result is delivered
+  // through predictionReady() with the returned request id (0 if the bridge
+  // is not running). Single predictions pass through a MicroBatcher, tuned
+  // with PYTHON_BATCH_WINDOW_US (default 200) and PYTHON_BATCH_MAX
+  // (default 32, 1 disables batching).
+  //
+  // Single predictions are also answered from an LRU cache
+  // (PYTHON_CACHE_SIZE entries, default 4096, 0 disables) and identical
+  // requests in flight share one call to Python. The cache is dropped when
+  // the model fingerprint changes or a worker is restarted.
+  quint64 predictAsync(const std::vector<float>& features) override;
+
+  // Scores all rows with BATCH commands: one round trip and one vectorized
+  // predict_proba call per worker, large batches being split across workers.
+  std::vector<PredictionResult> predictBatch(const std::vector<std::vector<float>>& rows) override;
+  quint64 predictBatchAsync(const std::vector<std::vector<float>>& rows);
+
+  // With ordered delivery, predictionReady()/batchReady() are emitted in
+  // submission order even when workers finish out of order.
+  void setOrderedDelivery(bool ordered);
+
+  size_t pendingRequests() const;
+  const MicroBatcher::Stats& batchingStats() const;
+  PredictionCache::Stats cacheStats() const;
+  Stats stats() const override;
+  void invalidateCache();
+
   void shutdown();
 
   signals:
-      void errorOccurred(const QString& error);
+      void batchReady(quint64 requestId, const std::vector<PredictionResult>& results);
+
+private slots:
+  void onWorkerReply(quint64 requestId, const PythonWorker::Reply& reply);
+  void onWorkerExited(int index, const std::vector<quint64>& orphanedRequests);
+  void onMicroBatchReady(const std::vector<MicroBatcher::Entry>& entries);
 
 private:
-  QString sendCommand(const QString& command);
-  nmjson parseResponse(const QString& response);
+  using RequestKind = PythonWorker::RequestKind;
+  using Reply = PythonWorker::Reply;
+
+  // A request sent to one worker. Shards of a split batch point at their
+  // parent and know where their rows start in the parent's result; a
+  // micro-batch lists the caller ids of its rows in members.
+  struct Request {
+    RequestKind kind;
+    size_t rowCount;
+    int worker;
+    bool async;
+    quint64 parent;
+    size_t offset;
+    std::vector<quint64> members;
+  };
+
+  struct BatchGroup {
+    size_t remainingShards;
+    std::vector<PredictionResult> results;
+    bool async;
+  };
 
-  QProcess* process;
+  struct OrderedDelivery {
+    RequestKind kind;
+    bool ready;
+    std::vector<PredictionResult> results;
+  };
+
+  PythonWorker* pickWorker();
+  void scheduleRestart(int index);
+  void restartWorker(int index);
+  quint64 submit(const std::vector<std::vector<float>>& rows, RequestKind kind, bool async);
+  bool send(quint64 requestId, const std::vector<std::vector<float>>& rows, RequestKind kind,
+            bool async, quint64 parent, size_t offset, std::vector<quint64> members = {});
+  quint64 enqueueSingle(const std::vector<float>& features, bool async);
+  void deliverSingle(quint64 requestId, PredictionResult result);
+  void deliverFlight(quint64 requestId, const PredictionResult& result);
+  PythonWorker* workerFor(quint64 requestId);
+  Reply waitForResponse(quint64 requestId, int timeoutMs);
+  void abandon(quint64 requestId);
+  void complete(quint64 requestId, Reply reply);
+  void finishAsync(quint64 requestId, RequestKind kind, std::vector<PredictionResult> results);
+  void flushOrderedDeliveries();
+  void emitResults(quint64 requestId, RequestKind kind, const std::vector<PredictionResult>& results);
+  PredictionResult toPredictionResult(const nmjson& json);
+  std::vector<PredictionResult> toBatchResults(const nmjson& json, size_t rowCount);
+  std::vector<PredictionResult> toResults(Reply reply, RequestKind kind, size_t rowCount);
+
+  std::vector<PythonWorker*> workers;
+  std::vector<PythonWorker::Options> workerOptions;
+  std::vector<int> restartDelays;
+  std::vector<bool> restartPending;
   bool initialized;
+  bool orderedDelivery;
+  quint64 nextRequestId;
+  size_t asyncOutstanding;
+  MicroBatcher* batcher;
+  PredictionCache cache;
+  std::string modelFingerprint;
+
+  std::unordered_map<quint64, Request> requests;
+  std::unordered_map<quint64, BatchGroup> batchGroups;
+  std::unordered_map<quint64, Reply> completedRequests;
+  std::map<quint64, OrderedDelivery> orderedDeliveries;
+  std::unordered_set<quint64> blockingRequests;
+  std::unordered_map<quint64, qint64> asyncStartedNs;
 };
 
 
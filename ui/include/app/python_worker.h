@@ -0,0 +1,108 @@
+#pragma once
+#ifndef PYTHON_WORKER_H
+#define PYTHON_WORKER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QByteArray>
+#include <QDebug>
+#include <vector>
+#include <string>
+#include <unordered_set>
+
+#include "binary_frame.h"
+#include "shm_transport.h"
+#include "prediction_result.h"
+#include "json.hpp"
+
+using nmjson = nlohmann::json;
+
+// One predict_service.py process together with its transport. The worker
+// only encodes requests and decodes replies; request ids are allocated by
+// PythonBridge, which also decides which worker gets which request.
+class PythonWorker : public QObject {
+  Q_OBJECT
+
+public:
+  enum class Protocol { Json, Binary };
+  enum class Transport { Pipe, SharedMemory };
+  enum class RequestKind { Single, Batch, Info };
+
+  struct Options {
+    QString pythonPath;
+    QString script;
+    Protocol protocol = Protocol::Binary;
+    bool sharedMemory = false;
+    size_t sharedMemoryRingBytes = 4 * 1024 * 1024;
+    int cpu = -1;      // CPU the worker pins itself to, -1 to leave unpinned
+    int threads = 1;   // OMP/MKL/OpenBLAS threads inside the worker
+  };
+
+  // A decoded response: binary RESULT frames fill results directly, every
+  // other response carries its JSON document.
+  struct Reply {
+    nmjson json;
+    std::vector<PredictionResult> results;
+    bool hasResults = false;
+  };
+
+  explicit PythonWorker(int index, QObject *parent = nullptr);
+  ~PythonWorker();
+
+  bool start(const Options& options);
+  void stop();
+
+  int index() const;
+  bool isRunning() const;
+  Protocol protocol() const;
+  Transport transport() const;
+  size_t outstanding() const;
+  bool owns(quint64 requestId) const;
+
+  // Return false when the request was not sent. A frame that could not be
+  // written whole leaves the stream unusable, so the worker is then stopped
+  // and exited() reports its other requests, as if the process had died.
+  bool sendInfo(quint64 requestId);
+  bool sendPredict(quint64 requestId, const std::vector<std::vector<float>>& rows, RequestKind kind);
+
+  // Blocks until more response data has been read (and replies emitted) or
+  // the timeout expires.
+  bool waitForReadyRead(int timeoutMs);
+
+  signals:
+      void replyReady(quint64 requestId, const PythonWorker::Reply& reply);
+      void errorOccurred(const QString& error);
+      void exited(int index, const std::vector<quint64>& orphanedRequests);
+
+private slots:
+  void onReadyRead();
+  void onReadyReadStandardError();
+  void onSharedMemoryReadyRead();
+  void onProcessFinished();
+
+private:
+  bool prepareSharedMemory(QProcessEnvironment& environment);
+  bool negotiateProtocol();
+  bool writeFrame(const QByteArray& frame);
+  bool sendFrame(quint64 requestId, const QByteArray& frame);
+  void abandon(const QString& reason);
+  bool sendJson(quint64 requestId, nmjson request);
+  void readJsonLines();
+  void readBinaryFrames();
+  void dispatchResponse(const nmjson& json);
+  void deliver(quint64 requestId, const Reply& reply);
+  nmjson parseResponse(const QString& response);
+
+  int workerIndex;
+  Options options;
+  QProcess* process;
+  ShmTransport* sharedMemory;
+  bool running;
+  Protocol activeProtocol;
+  Transport activeTransport;
+  QByteArray readBuffer;
+  std::unordered_set<quint64> inFlight;
+};
+
+#endif // PYTHON_WORKER_H
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef SHM_TRANSPORT_H
+#define SHM_TRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QProcessEnvironment>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+
+class QSocketNotifier;
+
+// Shared-memory alternative to the stdin/stdout pipes of the Python worker.
+//
+// The region holds two single-producer/single-consumer byte rings: requests
+// (C++ -> Python) and responses (Python -> C++). Both rings carry the same
+// binary frames as the pipe transport (see binary_frame.h), so framing code
+// is shared. Each ring has an eventfd for wake-ups; the consumer spins for a
+// short while before sleeping, and the producer only signals when the
+// consumer has announced that it is about to sleep.
+//
+// Region layout (offsets in bytes, all counters little-endian uint64):
+//   0      magic "MLSH", version, ring capacity
+//   64     request tail    128  request head    192  request consumer waiting
+//   256    response tail   320  response head   384  response consumer waiting
+//   512    request data  [capacity]
+//   512+capacity response data [capacity]
+//
+// predict_service.py maps the same layout with mmap. Only available on Linux.
+class ShmTransport : public QObject {
+  Q_OBJECT
+
+public:
+  explicit ShmTransport(QObject *parent = nullptr);
+  ~ShmTransport();
+
+  static bool isSupported();
+
+  // Creates the region and both eventfds. ringBytes is rounded up to a power
+  // of two.
+  bool create(size_t ringBytes);
+  void close();
+  bool isOpen() const;
+
+  // Exposes the region name and the (inheritable) eventfds to the child.
+  void exportTo(QProcessEnvironment& environment) const;
+
+  // Removes the region name once the worker has mapped it.
+  void unlinkName();
+
+  // Streams data into the request ring, waiting for free space if the ring
+  // is full. Responses arriving meanwhile are buffered, never dropped.
+  bool write(const QByteArray& data, int timeoutMs);
+
+  QByteArray readAll();
+
+  // Spins briefly, then sleeps on the response eventfd. Emits readyRead()
+  // when response bytes are available.
+  bool waitForReadyRead(int timeoutMs);
+
+  signals:
+      void readyRead();
+
+private slots:
+  void onResponseNotified();
+
+private:
+  struct Ring;
+
+  Ring requestRing() const;
+  Ring responseRing() const;
+  size_t drainResponses();
+  bool waitForEvent(int fd, int timeoutMs);
+
+  QString regionName;
+  unsigned char* region;
+  size_t regionSize;
+  size_t capacity;
+  int requestEventFd;
+  int responseEventFd;
+  QSocketNotifier* notifier;
+  QByteArray inbox;
+};
+
+#endif // SHM_TRANSPORT_H
@@ -1,10 +1,34 @@
 #ifndef FEATURE_LIMITS_H
 #define FEATURE_LIMITS_H
 
+#include <map>
+#include <string>
+
 struct FeatureLimit {
   float min;
   float max;
   bool isInteger;
 };
 
+// Valid input ranges of the heart disease features, shared by the input
+// validation and the prediction cache.
+inline const std::map<std::string, FeatureLimit>& featureLimits() {
+  static const std::map<std::string, FeatureLimit> rules = {
+    {"age",      {0,   120, true}},
+    {"sex",      {0,   1,   true}},
+    {"cp",       {0,   3,   true}},
+    {"trestbps", {50,  250, false}},
+    {"chol",     {100, 600, false}},
+    {"fbs",      {0,   1,   true}},
+    {"restecg",  {0,   2,   true}},
+    {"thalch",   {50,  250, false}},
+    {"exang",    {0,   1,   true}},
+    {"oldpeak",  {0.0, 10.0, false}},
+    {"slope",    {0,   2,   true}},
+    {"ca",       {0,   4,   true}},
+    {"thal",     {0,   3,   true}}
+  };
+  return rules;
+}
+
 #endif // FEATURE_LIMITS_H
@@ -13,6 +13,8 @@ struct ModelInfo {
   double precision;
   double recall;
   double f1_score;
+  bool uses_scaling;
+  std::string model_fingerprint;
 };
 
 #endif // MODEL_INFO_H
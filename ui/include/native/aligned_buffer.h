@@ -0,0 +1,65 @@
+#pragma once
+#ifndef ALIGNED_BUFFER_H
+#define ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace Native {
+
+// Heap array aligned to a cache line, for matrices the SIMD kernels stream
+// through with aligned loads. Contents are zeroed on resize.
+template <typename T, size_t Alignment = 64>
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(size_t count) { resize(count); }
+    ~AlignedBuffer() { release(); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : values(std::exchange(other.values, nullptr)), count(std::exchange(other.count, 0)) {}
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            values = std::exchange(other.values, nullptr);
+            count = std::exchange(other.count, 0);
+        }
+        return *this;
+    }
+
+    void resize(size_t newCount) {
+        release();
+        if (newCount == 0) return;
+
+        values = static_cast<T*>(::operator new[](newCount * sizeof(T), std::align_val_t(Alignment)));
+        count = newCount;
+        for (size_t i = 0; i < count; ++i) values[i] = T{};
+    }
+
+    T* data() { return values; }
+    const T* data() const { return values; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T& operator[](size_t index) { return values[index]; }
+    const T& operator[](size_t index) const { return values[index]; }
+
+private:
+    void release() {
+        if (values) ::operator delete[](values, std::align_val_t(Alignment));
+        values = nullptr;
+        count = 0;
+    }
+
+    T* values = nullptr;
+    size_t count = 0;
+};
+
+}
+
+#endif // ALIGNED_BUFFER_H
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <cstddef>
+
+// x86 kernels are compiled with per-function target attributes, which only
+// GCC and Clang support; everything else uses the scalar code paths.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ML_NATIVE_X86_KERNELS
+#endif
+
+namespace Native {
+
+namespace Cpu {
+
+// Avx2 implies FMA as well; every AVX-512 CPU also has Avx2.
+enum class Isa { None, Avx2, Avx512 };
+
+// Widest instruction set supported by both the compiler and this CPU.
+Isa detect();
+
+// float lanes per vector.
+size_t lanes(Isa isa);
+
+}
+
+}
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef GENERATED_MODEL_H
+#define GENERATED_MODEL_H
+
+#include <memory>
+
+#include "native_model.h"
+
+// Implemented by the source that tools/generate_model.py writes at build
+// time from the artifact named by ML_GENERATED_MODEL, with every tree
+// compiled to a function with constant thresholds. Only available when the
+// app is built with HAVE_GENERATED_MODEL.
+namespace Native {
+
+std::unique_ptr<Model> makeGeneratedModel();
+
+// Digest of the artifact the code was generated from.
+const char* generatedModelFingerprint();
+
+}
+
+#endif // GENERATED_MODEL_H
@@ -0,0 +1,78 @@
+#pragma once
+#ifndef HNSW_INDEX_H
+#define HNSW_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "knn_model.h"
+#include "mapped_file.h"
+
+namespace Native {
+
+// Hierarchical navigable small world graph (Malkov & Yashunin) over a KNN
+// reference cohort too large to search exactly.
+//
+// The graph is built offline by knn-index-builder and memory-mapped at
+// load, so opening an index of millions of rows is immediate and the pages
+// are shared between processes. Rows are stored scaled, row-major, next to
+// their class index; every node has up to 2M links on level 0 and up to M
+// on each level above. A query descends greedily from the top level and
+// then keeps the ef best candidates on level 0: a larger ef gives better
+// recall for more distance evaluations. The file is little-endian with
+// every section aligned to 64 bytes.
+class HnswIndex {
+public:
+    using Neighbour = KnnModel::Neighbour;
+
+    struct BuildOptions {
+        size_t m = 16;
+        size_t efConstruction = 200;
+        uint64_t seed = 42;
+    };
+
+    // Builds the graph over count scaled rows (row-major) and their class
+    // indices and writes it to path. Throws std::runtime_error when the
+    // file cannot be written.
+    static void build(const float* vectors, const uint8_t* labels, size_t count, size_t features,
+                      const BuildOptions& options, const std::string& path);
+
+    // Maps an index written by build(). Throws std::runtime_error when the
+    // file is missing, truncated or not an index.
+    static std::shared_ptr<const HnswIndex> open(const std::string& path);
+
+    size_t size() const;
+    size_t numFeatures() const;
+    size_t levels() const;
+    const uint8_t* labels() const;
+
+    // The k (approximately) nearest rows to a scaled query, nearest first.
+    // ef is raised to k when smaller.
+    void search(const float* query, size_t k, size_t ef, Neighbour* out) const;
+
+    // The exact k nearest rows by brute force, for measuring recall.
+    void searchExact(const float* query, size_t k, Neighbour* out) const;
+
+private:
+    HnswIndex() = default;
+
+    std::unique_ptr<MappedFile> file;
+    size_t count = 0;
+    size_t features = 0;
+    size_t m = 0;
+    size_t maxLevel = 0;
+    uint32_t entryPoint = 0;
+    const float* vectors = nullptr;
+    const uint8_t* rowLabels = nullptr;
+    const uint8_t* rowLevels = nullptr;
+    const uint32_t* baseLinks = nullptr;    // count blocks of 1 + 2M: size, then ids
+    const uint32_t* upperIndex = nullptr;   // first upper block of every row
+    const uint32_t* upperLinks = nullptr;   // blocks of 1 + M, levels 1.. of a row in order
+
+    friend struct IndexGraph;
+};
+
+}
+
+#endif // HNSW_INDEX_H
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef KNN_MODEL_H
+#define KNN_MODEL_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "aligned_buffer.h"
+#include "cpu_features.h"
+#include "native_model.h"
+#include "scaler.h"
+#include "json.hpp"
+
+namespace Native {
+
+class HnswIndex;
+class ModelBundle;
+
+// Exact k-nearest-neighbour classifier over the scaled training matrix,
+// equivalent to KNeighborsClassifier with the Euclidean metric.
+//
+// The reference rows are stored feature-major in a 64-byte aligned float32
+// matrix, padded to whole vectors with columns the scan masks out. Queries are
+// scanned four at a time against eight references per step; each query
+// keeps its k best in a small sorted array and only the lanes that beat its
+// current k-th distance are inserted. Large batches are split across the
+// shared ThreadPool.
+//
+// Ties follow sklearn's documented behaviour: among equal distances the
+// earlier training row wins, and a tied vote goes to the first class.
+// Distances are float32, so references whose float64 distances differ only
+// in the last bits can swap places at the k-th position.
+//
+// For reference cohorts too large for exact search an HnswIndex built
+// offline can be attached; queries then go to the index, whose rows and
+// labels replace the exported ones, and searchBreadth trades recall for
+// latency.
+//
+// Loaded from a bundle, the model scans the mapped reference section in
+// place, so processes serving the same bundle share one copy of it.
+class KnnModel : public Model {
+public:
+    enum class Weighting { Uniform, Distance };
+
+    struct Neighbour {
+        float distance;   // squared Euclidean distance in scaled space
+        uint32_t index;   // training row
+    };
+
+    static std::unique_ptr<KnnModel> fromJson(const nlohmann::json& artifact);
+    static std::unique_ptr<KnnModel> fromBundle(const std::shared_ptr<const ModelBundle>& bundle);
+
+    std::string kind() const override;
+    size_t numFeatures() const override;
+    size_t numReferences() const;
+    size_t neighbours() const;
+
+    // Pool threads used for large batches, 0 for all of them.
+    void setThreads(size_t threads);
+
+    // Searches index instead of the exported references. Throws
+    // std::runtime_error when it has a different number of features or
+    // fewer than k rows. Pass nullptr to go back to exact search.
+    void attachIndex(std::shared_ptr<const HnswIndex> index);
+    bool hasIndex() const;
+
+    // The ef of index searches, at least k; 64 by default.
+    void setSearchBreadth(size_t ef);
+    size_t searchBreadth() const;
+
+    void predictBatch(const float* rows, size_t count, Prediction* out) const override;
+
+    // The k nearest references of one unscaled row, nearest first, found
+    // through the index when one is attached.
+    void kneighbours(const float* row, Neighbour* out) const;
+
+    // Same by brute force over the index or the exported references.
+    void exactNeighbours(const float* row, Neighbour* out) const;
+
+private:
+    static std::unique_ptr<KnnModel> create(const nlohmann::json& artifact, size_t references);
+
+    void scaleRows(const float* rows, size_t count, float* scaled) const;
+    void search(const float* scaled, size_t count, Neighbour* nearest) const;
+    void predictRange(const float* rows, size_t count, Prediction* out) const;
+    Prediction vote(const Neighbour* nearest, const uint8_t* labels) const;
+
+    size_t features = 0;
+    size_t references = 0;
+    size_t stride = 0;                  // padded reference count
+    size_t k = 5;
+    Weighting weighting = Weighting::Uniform;
+    const float* matrix = nullptr;      // features x stride, feature-major, 32-byte aligned
+    const uint8_t* targets = nullptr;   // class index of every reference
+    int classes[2] = {0, 1};
+    Scaler scaler;
+    Cpu::Isa isa = Cpu::Isa::None;
+    size_t threads = 0;
+    std::shared_ptr<const HnswIndex> index;
+    size_t ef = 64;
+
+    // Storage behind matrix and targets for JSON artifacts; bundles are
+    // used where they are mapped and only kept alive.
+    AlignedBuffer<float> ownedMatrix;
+    std::vector<uint8_t> ownedTargets;
+    std::shared_ptr<const ModelBundle> bundle;
+};
+
+}
+
+#endif // KNN_MODEL_H
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace Native {
+
+// Read-only memory mapping of a whole file. Pages are loaded on first
+// touch and shared with every other process mapping the same file, so large
+// indexes open instantly and cost no private memory.
+class MappedFile {
+public:
+    // Throws std::runtime_error when the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+}
+
+#endif // MAPPED_FILE_H
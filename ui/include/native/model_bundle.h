@@ -0,0 +1,88 @@
+#pragma once
+#ifndef MODEL_BUNDLE_H
+#define MODEL_BUNDLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aligned_buffer.h"
+#include "mapped_file.h"
+#include "json.hpp"
+
+namespace Native {
+
+// Binary form of a native model artifact, written by export_native_bundle
+// in model/src/native_export.py and memory-mapped at load.
+//
+// A 64-byte header (magic "MLBUNDLE", version, section count, file size,
+// directory offset and the CRC32 of everything after the header) is
+// followed by a directory of 64-byte entries (name, element type, offset,
+// rows, columns) and the sections themselves, each aligned to 64 bytes.
+// The "metadata" section is the JSON artifact with its arrays taken out;
+// every array is its own section, stored in the layout the engine scans
+// (support vectors and KNN references feature-major and padded to whole
+// vectors), so models can use them in place and processes loading the same
+// bundle share its pages. All values are little-endian.
+//
+// Loaders that convert other formats at load time (sklearn_pickle.h) build
+// the same sections in memory with create() and add().
+class ModelBundle {
+public:
+    template <typename T>
+    struct Array {
+        const T* data = nullptr;
+        size_t rows = 0;
+        size_t columns = 0;
+
+        size_t size() const { return rows * columns; }
+    };
+
+    // Maps a bundle and checks its structure and checksum. Throws
+    // std::runtime_error when it is missing, truncated or corrupt.
+    static std::shared_ptr<const ModelBundle> open(const std::string& path);
+
+    // True when path starts with the bundle magic.
+    static bool isBundle(const std::string& path);
+
+    // An empty in-memory bundle, filled with add() and setMetadata().
+    static std::shared_ptr<ModelBundle> create();
+
+    // Adds a zeroed, 64-byte aligned rows x columns section to an in-memory
+    // bundle and returns it for filling. Same types as array().
+    template <typename T>
+    T* add(const std::string& name, size_t rows, size_t columns);
+    void setMetadata(nlohmann::json metadata);
+
+    const nlohmann::json& metadata() const;
+    bool contains(const std::string& name) const;
+
+    // A section by name; instantiated for float, double, int32_t and
+    // uint8_t. Throws std::runtime_error when it is missing or holds
+    // another type.
+    template <typename T>
+    Array<T> array(const std::string& name) const;
+
+private:
+    ModelBundle() = default;
+
+    struct Section {
+        std::string name;
+        uint32_t type;
+        const unsigned char* data;
+        size_t rows;
+        size_t columns;
+    };
+
+    const Section* find(const std::string& name) const;
+
+    std::unique_ptr<MappedFile> file;
+    std::vector<AlignedBuffer<unsigned char>> buffers;   // sections of in-memory bundles
+    std::vector<Section> sections;
+    nlohmann::json meta;
+};
+
+}
+
+#endif // MODEL_BUNDLE_H
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef NAIVE_BAYES_MODEL_H
+#define NAIVE_BAYES_MODEL_H
+
+#include <vector>
+
+#include "cpu_features.h"
+#include "native_model.h"
+#include "json.hpp"
+
+namespace Native {
+
+class ModelBundle;
+struct Scaler;
+
+// Binary Gaussian naive Bayes, as fitted by GaussianNB.
+//
+// The per-class log prior and -0.5 * log(2 pi var) terms are summed into
+// one constant and every variance is turned into 1 / (2 var) at load time,
+// with the StandardScaler, if any, folded into the means and variances. A
+// row then costs two subtractions and two FMAs per feature. For two
+// classes the log-sum-exp normalization of the joint log likelihoods is a
+// sigmoid of their difference, so the kernel accumulates that difference
+// directly. Batches are scored eight rows per vector in feature-major
+// blocks like LinearModel, and predict() gives the same bits as
+// predictBatch().
+class NaiveBayesModel : public Model {
+public:
+    static std::unique_ptr<NaiveBayesModel> fromJson(const nlohmann::json& artifact);
+    static std::unique_ptr<NaiveBayesModel> fromBundle(const std::shared_ptr<const ModelBundle>& bundle);
+
+    std::string kind() const override;
+    size_t numFeatures() const override;
+
+    Prediction predict(const float* row) const override;
+    void predictBatch(const float* rows, size_t count, Prediction* out) const override;
+
+private:
+    // means and variances are class-major, two rows of numFeatures().
+    static std::unique_ptr<NaiveBayesModel> create(const nlohmann::json& artifact, const double* means,
+                                                   const double* variances, const double* priors,
+                                                   const Scaler& scaler);
+
+    // Per feature: mean and 1 / (2 var) of each class, interleaved as
+    // mean0, inverse0, mean1, inverse1.
+    std::vector<float> parameters;
+    float bias = 0.0f;   // difference of the class constants, class 1 minus class 0
+    size_t features = 0;
+    int classes[2] = {0, 1};
+    Cpu::Isa isa = Cpu::Isa::None;
+};
+
+}
+
+#endif // NAIVE_BAYES_MODEL_H
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef NATIVE_MODEL_H
+#define NATIVE_MODEL_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Dependency-free inference for the models exported by
+// model/src/native_export.py. Nothing in here uses Qt so the engine can be
+// linked into tools and benchmarks as well as the UI.
+namespace Native {
+
+struct Prediction {
+    int label;
+    double probability;   // probability of the positive class
+};
+
+class Model {
+public:
+    virtual ~Model() = default;
+
+    virtual std::string kind() const = 0;
+    virtual size_t numFeatures() const = 0;
+
+    // Feature names in column order, as listed in the artifact.
+    const std::vector<std::string>& featureNames() const { return names; }
+    void setFeatureNames(std::vector<std::string> featureNames) { names = std::move(featureNames); }
+
+    // rows is row-major, count * numFeatures() floats.
+    virtual void predictBatch(const float* rows, size_t count, Prediction* out) const = 0;
+
+    virtual Prediction predict(const float* row) const {
+        Prediction prediction{};
+        predictBatch(row, 1, &prediction);
+        return prediction;
+    }
+
+private:
+    std::vector<std::string> names;
+};
+
+// Loads a native_model.json artifact, a native_model.bin bundle (see
+// ModelBundle) or, by its .onnx extension, a best_model.onnx run by the
+// built-in interpreter (see OnnxModel). Throws std::runtime_error when the
+// file is missing, malformed or of an unsupported format version.
+std::unique_ptr<Model> loadModel(const std::string& path);
+
+// Rows per block when a batch is split across threads: a few KB of input
+// and output, small enough to stay in cache while the block is scored.
+constexpr size_t kParallelBlockRows = 256;
+
+// predictBatch on the shared ThreadPool, one block of kParallelBlockRows
+// rows at a time, each written straight to its place in out. Uses up to
+// threads threads (0 for all); batches of a single block stay on the
+// calling thread. Models keep no scratch state, so disjoint rows can be
+// scored concurrently.
+void predictParallel(const Model& model, const float* rows, size_t count, Prediction* out, size_t threads = 0);
+
+}
+
+#endif // NATIVE_MODEL_H
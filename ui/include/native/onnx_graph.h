@@ -0,0 +1,119 @@
+#pragma once
+#ifndef ONNX_GRAPH_H
+#define ONNX_GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Native {
+
+// The parts of an ONNX ModelProto the interpreter in onnx_model.h needs,
+// read with a small protobuf wire-format decoder so that no protobuf or
+// ONNX library is linked. Field numbers follow onnx/onnx.proto; fields this
+// reader does not use are skipped.
+
+// TensorProto.DataType values.
+enum class OnnxType : int32_t {
+    Undefined = 0,
+    Float = 1,
+    Uint8 = 2,
+    Int8 = 3,
+    Uint16 = 4,
+    Int16 = 5,
+    Int32 = 6,
+    Int64 = 7,
+    String = 8,
+    Bool = 9,
+    Float16 = 10,
+    Double = 11,
+};
+
+// A constant tensor. Numeric contents are widened to double whatever the
+// stored type, which is exact for the float, double and 32-bit integer
+// tensors converters write.
+struct OnnxTensor {
+    std::string name;
+    OnnxType type = OnnxType::Undefined;
+    std::vector<int64_t> dims;
+    std::vector<double> values;
+};
+
+struct OnnxAttribute {
+    // AttributeProto.AttributeType values.
+    enum class Type : int32_t {
+        Undefined = 0,
+        Float = 1,
+        Int = 2,
+        String = 3,
+        Tensor = 4,
+        Graph = 5,
+        Floats = 6,
+        Ints = 7,
+        Strings = 8,
+    };
+
+    std::string name;
+    Type type = Type::Undefined;
+    float number = 0.0f;
+    int64_t integer = 0;
+    std::string text;
+    OnnxTensor tensor;
+    std::vector<float> numbers;
+    std::vector<int64_t> integers;
+    std::vector<std::string> texts;
+};
+
+struct OnnxNode {
+    std::string name;
+    std::string opType;
+    std::string domain;                 // "" for the default ai.onnx domain
+    std::vector<std::string> inputs;    // "" marks an omitted optional input
+    std::vector<std::string> outputs;
+    std::vector<OnnxAttribute> attributes;
+
+    const OnnxAttribute* attribute(const std::string& attributeName) const;
+
+    // Typed lookups; a missing attribute gives the fallback (or an empty
+    // list), one of the wrong type throws std::runtime_error.
+    int64_t integer(const std::string& attributeName, int64_t fallback) const;
+    std::string text(const std::string& attributeName, const std::string& fallback) const;
+    std::vector<float> numbers(const std::string& attributeName) const;
+    std::vector<int64_t> integers(const std::string& attributeName) const;
+    std::vector<std::string> texts(const std::string& attributeName) const;
+    // A FLOATS attribute, or the TENSOR attribute named attributeName +
+    // "_as_tensor" that newer ai.onnx.ml opsets use for double precision.
+    std::vector<double> values(const std::string& attributeName) const;
+};
+
+// A graph input or output. Only tensors are described in detail; a
+// sequence or map (ZipMap's output) just reports its kind.
+struct OnnxValueInfo {
+    enum class Kind { Tensor, Sequence, Map, Other };
+
+    std::string name;
+    Kind kind = Kind::Other;
+    OnnxType type = OnnxType::Undefined;    // element type of a tensor
+    std::vector<int64_t> shape;             // -1 for a symbolic dimension
+};
+
+struct OnnxGraph {
+    int64_t irVersion = 0;
+    std::string producer;
+    std::map<std::string, int64_t> opsets;   // domain -> version, "" for ai.onnx
+    std::vector<OnnxNode> nodes;             // topologically sorted, as required by ONNX
+    std::vector<OnnxTensor> initializers;
+    std::vector<OnnxValueInfo> inputs;       // without the initializers older IR versions list
+    std::vector<OnnxValueInfo> outputs;
+
+    // Throws std::runtime_error on malformed or truncated input, or on
+    // tensors stored as external data.
+    static OnnxGraph parse(const unsigned char* bytes, size_t size);
+    static OnnxGraph load(const std::string& path);
+};
+
+}
+
+#endif // ONNX_GRAPH_H
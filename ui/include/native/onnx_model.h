@@ -0,0 +1,63 @@
+#pragma once
+#ifndef ONNX_MODEL_H
+#define ONNX_MODEL_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "native_model.h"
+
+namespace Native {
+
+struct OnnxGraph;
+
+// Runs best_model.onnx, as written by convert_sklearn in the notebook,
+// without ONNX Runtime. Only the operators the converter emits for the
+// tree, linear and SVM candidates are implemented: the ai.onnx.ml Scaler,
+// LinearClassifier, TreeEnsembleClassifier, SVMClassifier (binary),
+// Normalizer and ZipMap, plus Cast and Identity. Graphs using anything
+// else (KNN and naive Bayes export to generic tensor operators) are
+// rejected at load.
+//
+// The graph is checked and simplified once, at load: element types and
+// widths are propagated so kernels never check them per batch, Identity,
+// ZipMap and no-op Casts become aliases of their input, nodes that do not
+// lead to the label or probability outputs are dropped, and a Scaler whose
+// only consumer is a LinearClassifier is folded into the coefficients.
+// Rows then go through the remaining kernels in cache-sized blocks.
+//
+// The label comes from the graph's int64 output and the probability from
+// column 1 of its probability output, which may be a tensor or ZipMap's
+// sequence of maps.
+class OnnxModel : public Model {
+public:
+    ~OnnxModel() override;
+
+    static std::unique_ptr<OnnxModel> load(const std::string& path);
+    static std::unique_ptr<OnnxModel> fromGraph(const OnnxGraph& graph);
+
+    std::string kind() const override;
+    size_t numFeatures() const override;
+
+    // Operators run per block after simplification, in order, fused ones
+    // written as "Scaler+LinearClassifier".
+    std::vector<std::string> operators() const;
+
+    void predictBatch(const float* rows, size_t count, Prediction* out) const override;
+
+    struct Tensor;
+    class Operator;
+
+private:
+    std::vector<std::unique_ptr<Operator>> steps;
+    size_t features = 0;
+    size_t slotCount = 0;
+    size_t inputSlot = 0;
+    size_t labelSlot = 0;
+    size_t probabilitySlot = 0;
+};
+
+}
+
+#endif // ONNX_MODEL_H
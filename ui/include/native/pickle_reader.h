@@ -0,0 +1,92 @@
+#pragma once
+#ifndef PICKLE_READER_H
+#define PICKLE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Native {
+
+struct PickleValue;
+using PickleRef = std::shared_ptr<PickleValue>;
+
+// A value read from a Python pickle. Nothing is imported or called: a
+// global is kept as its dotted name, and REDUCE, NEWOBJ and BUILD only
+// record the callable, its arguments and the state for the caller to
+// interpret, so loading an untrusted file cannot run code.
+struct PickleValue {
+    enum class Type { None, Bool, Int, Float, String, Bytes, Tuple, List, Dict, Set, Global, Object };
+
+    Type type = Type::None;
+    int64_t integer = 0;                    // Bool and Int
+    double number = 0.0;                    // Float
+    std::string text;                       // String, and module.name of a Global
+    const unsigned char* data = nullptr;    // Bytes, a view into the pickle
+    size_t size = 0;
+    std::vector<PickleRef> items;           // Tuple, List and Set; Dict as key, value pairs
+    PickleRef callable;                     // Object: the Global it was made by
+    PickleRef arguments;                    // Object: the argument tuple
+    PickleRef state;                        // Object: what BUILD passed, null without BUILD
+
+    bool isNone() const { return type == Type::None; }
+
+    // Last component of the callable's name, "" for anything but an Object.
+    // Estimators are matched on it since sklearn moves classes between
+    // private modules across releases.
+    std::string className() const;
+
+    // Entry of a Dict with a string key, or attribute of an Object whose
+    // state is a dict; nullptr when missing.
+    const PickleValue* find(const std::string& key) const;
+    // Same, throwing std::runtime_error when missing.
+    const PickleValue& at(const std::string& key) const;
+    // Item of a Tuple or List, throwing std::runtime_error when out of range.
+    const PickleValue& item(size_t index) const;
+};
+
+// Unpickles protocols 2 to 5 as written by pickle.dump. The returned
+// value may point into bytes, which must outlive it. Throws
+// std::runtime_error on truncated input or opcodes it does not know
+// (the text protocols 0 and 1 and out-of-band buffers).
+PickleRef readPickle(const unsigned char* bytes, size_t size);
+
+// A numpy ndarray (or numpy scalar) decoded from the numpy reconstruction
+// calls recorded in a PickleValue. The data is not copied.
+struct NumpyArray {
+    struct Field {
+        std::string name;
+        char kind;
+        size_t itemSize;
+        size_t offset;
+    };
+
+    char kind = 0;                          // 'f', 'i', 'u', 'b', 'O', or 'V' for records
+    size_t itemSize = 0;
+    std::vector<size_t> shape;              // empty for a scalar
+    bool fortranOrder = false;
+    const unsigned char* data = nullptr;    // little-endian, possibly unaligned
+    std::vector<PickleRef> objects;         // elements of an 'O' array
+    std::vector<Field> fields;              // fields of a 'V' array
+
+    // Throws std::runtime_error when value is not an array or scalar this
+    // reader can decode (big-endian, strings, nested records).
+    static NumpyArray from(const PickleValue& value);
+    static bool isArray(const PickleValue& value);
+
+    size_t count() const;
+    // Numeric elements converted to double, in C order.
+    std::vector<double> values() const;
+    // One field of every record of a 'V' array, converted to double.
+    std::vector<double> field(const std::string& name) const;
+};
+
+// A Bool, Int, Float or numpy scalar as a double; throws std::runtime_error
+// for anything else.
+double pickleNumber(const PickleValue& value);
+
+}
+
+#endif // PICKLE_READER_H
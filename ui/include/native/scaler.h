@@ -0,0 +1,33 @@
+#pragma once
+#ifndef NATIVE_SCALER_H
+#define NATIVE_SCALER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "json.hpp"
+
+namespace Native {
+
+class ModelBundle;
+
+// StandardScaler parameters of a model trained on scaled features:
+// x' = (x - mean) / scale. Models fold them into their own parameters at
+// load time where they can, so no separate transform runs per row.
+struct Scaler {
+    std::vector<double> mean;
+    std::vector<double> scale;
+
+    // Reads the optional "scaler" section of an artifact; an absent section
+    // gives the identity (empty vectors).
+    static Scaler fromJson(const nlohmann::json& artifact, size_t features);
+
+    // Same from the scaler.mean and scaler.scale sections of a bundle.
+    static Scaler fromBundle(const ModelBundle& bundle, size_t features);
+
+    bool isIdentity() const { return mean.empty(); }
+};
+
+}
+
+#endif // NATIVE_SCALER_H
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include "cpu_features.h"
+
+#ifdef ML_NATIVE_X86_KERNELS
+#include <immintrin.h>
+
+namespace Native {
+
+namespace SimdMath {
+
+// exp(x) for 8 floats, Cephes expf: range reduction by ln 2 and a degree 5
+// polynomial, within 2 ulp of std::exp over the clamped range.
+__attribute__((target("avx2,fma")))
+inline __m256 exp256(__m256 x) {
+    x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.3365447504f));
+
+    __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+    x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+    __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+    y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+    const __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+}
+
+// cos(x) for 8 floats, Cephes cosf: reduction to [-pi/4, pi/4] in three
+// steps, then the sine or cosine polynomial depending on the octant.
+// Accurate to a few ulp for |x| below about 8192.
+__attribute__((target("avx2,fma")))
+inline __m256 cos256(__m256 x) {
+    x = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+
+    __m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+    octant = _mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    const __m256 y = _mm256_cvtepi32_ps(octant);
+
+    octant = _mm256_sub_epi32(octant, _mm256_set1_epi32(2));
+    const __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(octant, _mm256_set1_epi32(4)), 29));
+    const __m256 useSine = _mm256_castsi256_ps(
+        _mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-0.78515625f), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4f), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-3.77489497744594108e-8f), x);
+    const __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 cosine = _mm256_set1_ps(2.443315711809948e-5f);
+    cosine = _mm256_fmadd_ps(cosine, z, _mm256_set1_ps(-1.388731625493765e-3f));
+    cosine = _mm256_fmadd_ps(cosine, z, _mm256_set1_ps(4.166664568298827e-2f));
+    cosine = _mm256_mul_ps(_mm256_mul_ps(cosine, z), z);
+    cosine = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), cosine);
+    cosine = _mm256_add_ps(cosine, _mm256_set1_ps(1.0f));
+
+    __m256 sine = _mm256_set1_ps(-1.9515295891e-4f);
+    sine = _mm256_fmadd_ps(sine, z, _mm256_set1_ps(8.3321608736e-3f));
+    sine = _mm256_fmadd_ps(sine, z, _mm256_set1_ps(-1.6666654611e-1f));
+    sine = _mm256_fmadd_ps(_mm256_mul_ps(sine, z), x, x);
+
+    return _mm256_xor_ps(_mm256_blendv_ps(cosine, sine, useSine), sign);
+}
+
+// 1 / (1 + exp(-x)) for 8 floats.
+__attribute__((target("avx2,fma")))
+inline __m256 sigmoid256(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    return _mm256_div_ps(one, _mm256_add_ps(one, exp256(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+}
+
+}
+
+}
+#endif
+
+#endif // SIMD_MATH_H
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef SKLEARN_PICKLE_H
+#define SKLEARN_PICKLE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "native_model.h"
+
+namespace Native {
+
+// Loads best_model.pkl as pickled by model_training.ipynb, for models that
+// have no native_model.json yet. The estimator's fitted arrays are read
+// straight out of the pickle (see pickle_reader.h), so no Python is
+// started; they are converted to the sections native_export.py would have
+// written to a bundle and loaded like one, with the same results.
+//
+// Supported: DecisionTreeClassifier, RandomForestClassifier,
+// GradientBoostingClassifier, LogisticRegression, SVC(probability=True)
+// with an RBF kernel, Euclidean KNeighborsClassifier and GaussianNB, all
+// binary. scalerPath is the StandardScaler pickle for models trained on
+// scaled features and empty otherwise. features names the columns, as in
+// model_metadata.json; it may be empty.
+//
+// Throws std::runtime_error when a file cannot be read or holds an
+// estimator or configuration the engine does not support.
+std::unique_ptr<Model> loadPickledModel(const std::string& modelPath, const std::string& scalerPath,
+                                        const std::vector<std::string>& features);
+
+}
+
+#endif // SKLEARN_PICKLE_H
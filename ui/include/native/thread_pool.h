@@ -0,0 +1,72 @@
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Native {
+
+// Fixed set of worker threads for data-parallel loops, created once and
+// shared by every model and backend in the process instead of each batch
+// starting threads of its own.
+//
+// parallelFor cuts [0, count) into chunks and gives each participating
+// thread, the caller included, a contiguous run of them. A thread takes
+// chunks from the front of its own run and, once that is empty, steals
+// from the back of the others', so uneven chunks (KNN queries near dense
+// regions, deep tree paths) still finish together. The runs are single
+// atomic words updated by compare-and-swap; nothing is locked while chunks
+// execute. Idle workers sleep on a condition variable.
+//
+// One loop runs at a time. A call from inside a chunk of this pool, or from
+// another thread while a loop is running, does not wait for the pool: it
+// runs inline on the calling thread, as does one that would use a single
+// thread, and body then gets the whole range in one call. So when two
+// backends score large batches at once, the second one is single-threaded.
+class ThreadPool {
+public:
+    // threads counts the calling thread, so a pool of 1 starts no workers.
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // One thread per hardware thread, started on first use.
+    static ThreadPool& shared();
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Calls body(begin, end) for consecutive chunks of at most grain items
+    // covering [0, count), on up to maxThreads threads (0 for all), and
+    // returns once every chunk has run. body must not throw.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body,
+                     size_t maxThreads = 0);
+
+private:
+    struct Job;
+
+    void work(size_t participant);
+    static void run(Job& job, size_t participant);
+
+    std::vector<std::thread> workers;
+
+    std::mutex busy;               // held by the caller of the running loop
+    std::mutex mutex;              // guards the fields below
+    std::condition_variable wake;
+    std::condition_variable idle;
+    Job* job = nullptr;
+    uint64_t generation = 0;
+    size_t active = 0;             // workers inside the current job
+    bool stopping = false;
+};
+
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,142 @@
+#pragma once
+#ifndef TREE_ENSEMBLE_H
+#define TREE_ENSEMBLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "native_model.h"
+#include "tree_simd.h"
+#include "json.hpp"
+
+namespace Native {
+
+class ModelBundle;
+
+// Decision tree, random forest and gradient boosting classifiers. All trees
+// share one set of structure-of-arrays node buffers; a node is an index into
+// them and a leaf has feature -1. Children are absolute indices, so
+// traversal is a loop over plain arrays with no per-node allocation.
+//
+// Ensembles whose trees have at most 64 leaves can instead be scored with
+// QuickScorer (Lucchese et al., SIGIR 2015): every split is visited feature
+// by feature in ascending threshold order, each false split clears its left
+// subtree's leaves from a per-tree bitvector, and the exit leaf of a tree is
+// the lowest bit left set. There is no per-tree traversal and no branch on
+// which child to take.
+//
+// On x86 CPUs with AVX2 or AVX-512, Simd mode walks 8 or 16 rows down each
+// tree in lockstep (see tree_simd.h), one L1-sized block of rows at a time.
+//
+// Traversal follows the node arrays in whatever order they are laid out;
+// setNodeLayout() reorders them to keep the nodes a row visits close
+// together. QuickScorer and Simd keep their own indexes and are unaffected.
+class TreeEnsemble : public Model {
+public:
+    enum class Aggregation {
+        MeanProbability,  // leaves hold P(class 1), averaged over trees
+        SumLogit          // leaves hold scaled log-odds, summed onto baseScore
+    };
+
+    enum class Evaluation { Traversal, QuickScorer, Simd };
+
+    enum class NodeLayout {
+        DepthFirst,    // preorder, left child first; the order sklearn exports
+        BreadthFirst,  // level by level
+        VanEmdeBoas,   // recursive split at half height, cache-oblivious
+        HotPath        // preorder taking the more frequently visited child first
+    };
+
+    static std::unique_ptr<TreeEnsemble> fromJson(const nlohmann::json& artifact);
+    static std::unique_ptr<TreeEnsemble> fromBundle(const std::shared_ptr<const ModelBundle>& bundle);
+
+    std::string kind() const override;
+    size_t numFeatures() const override;
+    size_t numTrees() const;
+    size_t numNodes() const;
+
+    Evaluation evaluation() const;
+    bool supportsQuickScorer() const;
+    bool supportsSimd() const;
+    // Returns false, keeping the current mode, when QuickScorer is requested
+    // for trees with more than 64 leaves or Simd on a CPU without AVX2.
+    bool setEvaluation(Evaluation mode);
+
+    // Rows per vector in Simd mode. Lanes can be lowered from 16 to 8 to
+    // compare AVX-512 with AVX2; returns false for widths the CPU lacks.
+    size_t simdLanes() const;
+    bool setSimdLanes(size_t lanes);
+
+    NodeLayout nodeLayout() const;
+    size_t sharedTopLevels() const;
+    // Reorders the node arrays of every tree. sharedTopLevels > 0 first
+    // moves that many levels of all trees into one block at the front, so
+    // the nodes every row visits share cache lines. HotPath needs branch
+    // frequencies and returns false without them.
+    bool setNodeLayout(NodeLayout layout, size_t sharedTopLevels = 0);
+
+    // Branch frequencies come from the "samples" node counts in the artifact
+    // (training rows reaching each node) or from calibrate(), which replaces
+    // them with the visits of count rows.
+    bool hasBranchFrequencies() const;
+    void calibrate(const float* rows, size_t count);
+
+    void predictBatch(const float* rows, size_t count, Prediction* out) const override;
+
+private:
+    // Splits grouped by feature, each group sorted by threshold. masks has
+    // zeros for the leaves of the split's left subtree.
+    struct QuickScorerIndex {
+        std::vector<uint32_t> featureOffsets;
+        std::vector<float> thresholds;
+        std::vector<uint32_t> trees;
+        std::vector<uint64_t> masks;
+        std::vector<uint32_t> leafOffsets;   // first leaf of each tree in leafValues
+        std::vector<double> leafValues;      // leaves of each tree, left to right
+    };
+
+    // Loading: classes and aggregation, then one addTree() per tree with
+    // child indices local to the tree, then the evaluation mode.
+    static std::unique_ptr<TreeEnsemble> create(const nlohmann::json& artifact);
+    void addTree(const int32_t* treeFeature, const float* treeThreshold, const int32_t* treeLeft,
+                 const int32_t* treeRight, const double* treeValue, const double* treeSamples, size_t nodes);
+    void finishLoading(const nlohmann::json& section);
+
+    double leafValue(int32_t root, const float* row) const;
+    void appendTreeOrder(int32_t root, NodeLayout layout, std::vector<int32_t>& order) const;
+    void appendVanEmdeBoas(int32_t node, int32_t levels, const std::vector<int32_t>& heights,
+                           std::vector<int32_t>& order) const;
+    void applyNodeOrder(const std::vector<int32_t>& order);
+    Prediction finish(double sum) const;
+    void buildQuickScorer();
+    uint32_t indexLeaves(int32_t node, uint32_t& nextLeaf,
+                         std::vector<std::pair<int32_t, uint64_t>>& splits);
+    void predictTraversal(const float* rows, size_t count, Prediction* out) const;
+    void predictQuickScorer(const float* rows, size_t count, Prediction* out) const;
+    void predictSimd(const float* rows, size_t count, Prediction* out) const;
+
+    Aggregation aggregation = Aggregation::MeanProbability;
+    double baseScore = 0.0;
+    size_t features = 0;
+    int classes[2] = {0, 1};
+
+    std::vector<int32_t> roots;
+    std::vector<int32_t> feature;
+    std::vector<float> threshold;
+    std::vector<int32_t> left;
+    std::vector<int32_t> right;
+    std::vector<double> value;
+    std::vector<double> visits;   // branch frequencies, empty when unknown
+
+    Evaluation mode = Evaluation::Traversal;
+    NodeLayout layout = NodeLayout::DepthFirst;
+    size_t topLevels = 0;
+    size_t maxLeaves = 0;
+    QuickScorerIndex quickScorer;
+    Cpu::Isa simdIsa = Cpu::Isa::None;
+    TreeSimd::Layout simd;
+};
+
+}
+
+#endif // TREE_ENSEMBLE_H
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef TREE_SIMD_H
+#define TREE_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace Native {
+
+// Lockstep traversal for TreeEnsemble: 8 (AVX2) or 16 (AVX-512) rows walk
+// the same tree together, one gather per node array per level. The kernels
+// are compiled with per-function target attributes and picked at runtime,
+// so the library itself needs no -mavx flags.
+namespace TreeSimd {
+
+// Nodes re-laid out breadth first with the two children of a split in
+// adjacent slots, so the next node is left + (x > threshold). A leaf is its
+// own left child, which lets finished lanes idle while the others descend.
+struct Layout {
+    std::vector<int32_t> roots;
+    std::vector<int32_t> depths;     // levels below the root of each tree
+    std::vector<int32_t> feature;    // -1 for leaves
+    std::vector<float> threshold;
+    std::vector<int32_t> left;
+    std::vector<double> value;
+};
+
+// Builds the layout from TreeEnsemble's depth-first arrays.
+Layout build(const std::vector<int32_t>& roots, const std::vector<int32_t>& feature,
+             const std::vector<float>& threshold, const std::vector<int32_t>& left,
+             const std::vector<int32_t>& right, const std::vector<double>& value);
+
+// Rows per block: the block's features stay in L1 while every tree is
+// applied to it.
+size_t blockRows(Cpu::Isa isa, size_t features);
+
+// Adds the leaf value of every tree, in tree order, to sums[row] for each
+// of count rows. Rows that do not fill a whole vector are walked one by one.
+void accumulate(Cpu::Isa isa, const Layout& layout, const float* rows, size_t count,
+                size_t features, double* sums);
+
+}
+
+}
+
+#endif // TREE_SIMD_H
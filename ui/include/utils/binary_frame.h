@@ -0,0 +1,95 @@
+#pragma once
+#ifndef BINARY_FRAME_H
+#define BINARY_FRAME_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+// Length-prefixed frames exchanged with predict_service.py once the binary
+// protocol has been negotiated. Every frame starts with a fixed 24 byte
+// little-endian header followed by payloadBytes of payload:
+//
+//   offset  size  field
+//   0       4     magic ("MLBF")
+//   4       1     type (FrameType)
+//   5       1     flags (reserved, 0)
+//   6       2     columns (features per row, PREDICT only)
+//   8       4     count (rows for PREDICT/RESULT)
+//   12      4     payloadBytes
+//   16      8     requestId
+//
+// PREDICT payload: count * columns float32 features, row-major.
+// RESULT payload:  count float32 probabilities followed by count int8 classes.
+// JSON payload:    UTF-8 JSON document (INFO replies and errors).
+namespace BinaryFrame {
+
+constexpr uint32_t kMagic = 0x46424C4D; // "MLBF" read as little-endian
+constexpr size_t kHeaderSize = 24;
+
+enum class FrameType : uint8_t {
+    Predict = 0x01,
+    Info = 0x02,
+    Exit = 0x03,
+    Result = 0x81,
+    Json = 0x82
+};
+
+struct Header {
+    uint32_t magic = kMagic;
+    FrameType type = FrameType::Predict;
+    uint8_t flags = 0;
+    uint16_t columns = 0;
+    uint32_t count = 0;
+    uint32_t payloadBytes = 0;
+    uint64_t requestId = 0;
+};
+
+inline void storeLE(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+inline uint64_t loadLE(const unsigned char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline void encodeHeader(const Header& header, unsigned char* out) {
+    storeLE(out, header.magic, 4);
+    out[4] = static_cast<unsigned char>(header.type);
+    out[5] = header.flags;
+    storeLE(out + 6, header.columns, 2);
+    storeLE(out + 8, header.count, 4);
+    storeLE(out + 12, header.payloadBytes, 4);
+    storeLE(out + 16, header.requestId, 8);
+}
+
+inline bool decodeHeader(const unsigned char* in, Header& header) {
+    header.magic = static_cast<uint32_t>(loadLE(in, 4));
+    header.type = static_cast<FrameType>(in[4]);
+    header.flags = in[5];
+    header.columns = static_cast<uint16_t>(loadLE(in + 6, 2));
+    header.count = static_cast<uint32_t>(loadLE(in + 8, 4));
+    header.payloadBytes = static_cast<uint32_t>(loadLE(in + 12, 4));
+    header.requestId = loadLE(in + 16, 8);
+    return header.magic == kMagic;
+}
+
+// float32 values are sent in host order; every platform we build for is
+// little-endian, which is what the Python side decodes with np.frombuffer.
+inline void storeFloats(unsigned char* out, const float* values, size_t count) {
+    std::memcpy(out, values, count * sizeof(float));
+}
+
+inline void loadFloats(const unsigned char* in, float* values, size_t count) {
+    std::memcpy(values, in, count * sizeof(float));
+}
+
+} // namespace BinaryFrame
+
+#endif // BINARY_FRAME_H
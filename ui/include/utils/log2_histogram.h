@@ -0,0 +1,67 @@
+#pragma once
+#ifndef LOG2_HISTOGRAM_H
+#define LOG2_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Fixed-size histogram with power-of-two buckets: bucket 0 counts zeros and
+// bucket i counts values in [2^(i-1), 2^i). Cheap enough to record on every
+// request and precise enough for batch sizes and microsecond latencies.
+class Log2Histogram {
+public:
+    static constexpr size_t kBuckets = 33;
+
+    void record(uint64_t value) {
+        size_t bucket = 0;
+        while (value != 0 && bucket + 1 < kBuckets) {
+            value >>= 1;
+            ++bucket;
+        }
+        ++buckets[bucket];
+        ++total;
+    }
+
+    void clear() {
+        buckets.fill(0);
+        total = 0;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t bucketCount(size_t bucket) const { return buckets[bucket]; }
+
+    // Exclusive upper bound of the bucket holding the given quantile.
+    uint64_t quantileUpperBound(double quantile) const {
+        if (total == 0) return 0;
+
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            seen += buckets[bucket];
+            if (seen >= rank) return upperBound(bucket);
+        }
+        return upperBound(kBuckets - 1);
+    }
+
+    // "[lo, hi): n" for every non-empty bucket, separated by spaces.
+    std::string toString() const {
+        std::string text;
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            if (buckets[bucket] == 0) continue;
+            if (!text.empty()) text += ' ';
+            text += '[' + std::to_string(lowerBound(bucket)) + ',' + std::to_string(upperBound(bucket)) +
+                    "):" + std::to_string(buckets[bucket]);
+        }
+        return text;
+    }
+
+private:
+    static uint64_t lowerBound(size_t bucket) { return bucket == 0 ? 0 : uint64_t{1} << (bucket - 1); }
+    static uint64_t upperBound(size_t bucket) { return bucket == 0 ? 1 : uint64_t{1} << bucket; }
+
+    std::array<uint64_t, kBuckets> buckets{};
+    uint64_t total = 0;
+};
+
+#endif // LOG2_HISTOGRAM_H
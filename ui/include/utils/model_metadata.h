@@ -0,0 +1,59 @@
+#pragma once
+#ifndef MODEL_METADATA_H
+#define MODEL_METADATA_H
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#include "model_info.h"
+#include "json.hpp"
+
+// model_metadata.json as written by model_training.ipynb, for backends that
+// do not go through predict_service.py.
+class ModelMetadata {
+public:
+    static std::optional<ModelInfo> load(const std::string& path) {
+        std::ifstream file(path);
+        nlohmann::json metadata = nlohmann::json::parse(file, nullptr, false);
+
+        if (!metadata.is_object()) {
+            return std::nullopt;
+        }
+
+        ModelInfo info{};
+        info.model_name = metadata.value("best_model", "Unknown");
+        info.num_features = metadata.value("num_features", 0);
+        info.uses_scaling = metadata.value("uses_scaling", false);
+
+        auto metrics = metadata.value("metrics", nlohmann::json::object());
+        info.accuracy = metrics.value("accuracy", 0.0);
+        info.precision = metrics.value("precision", 0.0);
+        info.recall = metrics.value("recall", 0.0);
+        info.f1_score = metrics.value("f1_score", 0.0);
+
+        if (metadata.contains("features")) {
+            for (const auto& f : metadata["features"])
+                info.features.push_back(f.get<std::string>());
+        }
+
+        return info;
+    }
+
+    // Size and modification time of a model file; changes whenever the file
+    // is replaced. Matches the fingerprint reported by predict_service.py
+    // in format, not in value.
+    static std::string fingerprint(const std::string& path) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) return "";
+
+        auto modified = std::filesystem::last_write_time(path, error);
+        if (error) return "";
+
+        return std::to_string(size) + "-" + std::to_string(modified.time_since_epoch().count());
+    }
+};
+
+#endif // MODEL_METADATA_H
@@ -0,0 +1,38 @@
+#include "backend_factory.h"
+#include <QDebug>
+
+#include "embedded_python_backend.h"
+#include "env_loader.h"
+#include "native_backend.h"
+#include "onnx_backend.h"
+#include "python_bridge.h"
+
+std::unique_ptr<InferenceBackend> BackendFactory::create(const std::string& name, QObject* parent) {
+    if (name.empty() || name == "python") {
+        return std::make_unique<PythonBridge>(parent);
+    }
+
+    if (name == "embedded") {
+        if (!EmbeddedPythonBackend::isAvailable()) {
+            qWarning() << "INFERENCE_BACKEND=embedded but embedded Python support was not compiled in";
+            return nullptr;
+        }
+        return std::make_unique<EmbeddedPythonBackend>(parent);
+    }
+
+    if (name == "onnx") {
+        return std::make_unique<OnnxBackend>(parent);
+    }
+
+    if (name == "native") {
+        return std::make_unique<NativeBackend>(parent);
+    }
+
+    qWarning() << "Unknown inference backend:" << QString::fromStdString(name);
+    return nullptr;
+}
+
+std::unique_ptr<InferenceBackend> BackendFactory::fromEnv(QObject* parent) {
+    auto env = EnvLoader::load();
+    return create(env["INFERENCE_BACKEND"], parent);
+}
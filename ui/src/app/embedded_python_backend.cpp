@@ -0,0 +1,363 @@
+#include "embedded_python_backend.h"
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+
+#include "model_metadata.h"
+
+#ifdef HAVE_EMBEDDED_PYTHON
+// Python's headers use "slots" as a member name, which Qt defines as a macro.
+#pragma push_macro("slots")
+#undef slots
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#pragma pop_macro("slots")
+#endif
+
+#ifdef HAVE_EMBEDDED_PYTHON
+
+namespace {
+
+// Holds the GIL for its lifetime, from any thread.
+class GilLock {
+public:
+    GilLock() : state(PyGILState_Ensure()) {}
+    ~GilLock() { PyGILState_Release(state); }
+
+    GilLock(const GilLock&) = delete;
+    GilLock& operator=(const GilLock&) = delete;
+
+private:
+    PyGILState_STATE state;
+};
+
+// An owned reference. It must be released with the GIL held.
+struct Release {
+    void operator()(PyObject* object) const { Py_XDECREF(object); }
+};
+using PyRef = std::unique_ptr<PyObject, Release>;
+
+PyRef borrowed(PyObject* object) {
+    Py_XINCREF(object);
+    return PyRef(object);
+}
+
+// "Type: message" of the pending Python exception, which is cleared.
+std::string pythonError() {
+    PyObject* type = nullptr;
+    PyObject* value = nullptr;
+    PyObject* traceback = nullptr;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyRef typeRef(type), valueRef(value), tracebackRef(traceback);
+
+    std::string message = type ? reinterpret_cast<PyTypeObject*>(type)->tp_name : "unknown Python error";
+    if (value) {
+        PyRef text(PyObject_Str(value));
+        const char* utf8 = text ? PyUnicode_AsUTF8(text.get()) : nullptr;
+        if (utf8 && *utf8) message += std::string(": ") + utf8;
+    }
+
+    PyErr_Clear();
+    return message;
+}
+
+// Starts the interpreter on first use, imports numpy's C API and releases
+// the GIL, which backends then take only around their calls. Returns an
+// empty string on success, or the error, which is final: CPython is started
+// once per process and never finalized.
+std::string startInterpreter(const std::string& program) {
+    static const std::string error = [&program]() -> std::string {
+        PyConfig config;
+        PyConfig_InitPythonConfig(&config);
+        config.parse_argv = 0;
+        // Ctrl+C and other signals stay with Qt.
+        config.install_signal_handlers = 0;
+
+        // Resolving the prefix from a virtualenv's python makes its
+        // site-packages importable, as if that executable were running.
+        if (!program.empty()) {
+            PyStatus status = PyConfig_SetBytesString(&config, &config.program_name, program.c_str());
+            if (PyStatus_Exception(status)) {
+                PyConfig_Clear(&config);
+                return std::string("Invalid Python interpreter path: ") + program;
+            }
+        }
+
+        PyStatus status = Py_InitializeFromConfig(&config);
+        PyConfig_Clear(&config);
+        if (PyStatus_Exception(status)) {
+            return std::string("Failed to start Python: ") + (status.err_msg ? status.err_msg : "unknown error");
+        }
+
+        std::string numpyError;
+        if (_import_array() < 0) {
+            numpyError = "Failed to import numpy: " + pythonError();
+        }
+
+        PyEval_SaveThread();
+        return numpyError;
+    }();
+
+    return error;
+}
+
+}
+
+struct EmbeddedPythonBackend::Service {
+    PyRef predictMatrix;
+    PyRef model;
+    PyRef scaler;
+    PyRef usesScaling;
+
+    size_t columns = 0;
+    // Rows widened to float64, as predict_service.py does with binary
+    // frames. Python sees this buffer through a numpy view, not a copy.
+    std::vector<double> input;
+
+    ~Service() {
+        GilLock lock;
+        predictMatrix.reset();
+        model.reset();
+        scaler.reset();
+        usesScaling.reset();
+    }
+
+    // Imports the service script as a module and runs its load_model(),
+    // which reads the artifact paths from os.environ. Returns an empty
+    // string on success. Called with the GIL held.
+    std::string load(const QFileInfo& script, const std::unordered_map<std::string, std::string>& env) {
+        PyObject* path = PySys_GetObject("path");
+        PyRef directory(PyUnicode_FromString(script.absolutePath().toStdString().c_str()));
+        if (!path || !directory) return pythonError();
+
+        const int known = PySequence_Contains(path, directory.get());
+        if (known < 0 || (known == 0 && PyList_Insert(path, 0, directory.get()) < 0)) return pythonError();
+
+        PyRef os(PyImport_ImportModule("os"));
+        PyRef environment(os ? PyObject_GetAttrString(os.get(), "environ") : nullptr);
+        if (!environment) return pythonError();
+
+        for (const char* key : {"MODEL_PATH", "SCALER_PATH", "METADATA_PATH"}) {
+            auto it = env.find(key);
+            if (it == env.end()) continue;
+
+            PyRef value(PyUnicode_FromString(it->second.c_str()));
+            if (!value || PyMapping_SetItemString(environment.get(), key, value.get()) < 0) return pythonError();
+        }
+
+        PyRef module(PyImport_ImportModule(script.completeBaseName().toStdString().c_str()));
+        if (!module) return pythonError();
+
+        predictMatrix.reset(PyObject_GetAttrString(module.get(), "predict_matrix"));
+        if (!predictMatrix) return pythonError();
+
+        PyRef loaded(PyObject_CallMethod(module.get(), "load_model", nullptr));
+        if (!loaded) return pythonError();
+
+        PyObject* loadedModel = nullptr;
+        PyObject* loadedScaler = nullptr;
+        PyObject* metadata = nullptr;
+        if (!PyArg_ParseTuple(loaded.get(), "OOO", &loadedModel, &loadedScaler, &metadata)) return pythonError();
+
+        PyObject* uses = PyDict_Check(metadata) ? PyDict_GetItemString(metadata, "uses_scaling") : nullptr;
+        if (!uses) return "model metadata has no uses_scaling";
+
+        model = borrowed(loadedModel);
+        scaler = borrowed(loadedScaler);
+        usesScaling = borrowed(uses);
+        return {};
+    }
+
+    // Runs predict_matrix on the first rowCount rows of input. Returns an
+    // empty string on success. Called with the GIL held.
+    std::string run(size_t rowCount, std::vector<PredictionResult>& results) {
+        npy_intp dims[] = {static_cast<npy_intp>(rowCount), static_cast<npy_intp>(columns)};
+
+        // Read-only, so that nothing on the Python side can write to the
+        // backend's buffer.
+        PyRef features(PyArray_SimpleNewFromData(2, dims, NPY_FLOAT64, input.data()));
+        if (!features) return pythonError();
+        PyArray_CLEARFLAGS(reinterpret_cast<PyArrayObject*>(features.get()), NPY_ARRAY_WRITEABLE);
+
+        PyRef output(PyObject_CallFunctionObjArgs(predictMatrix.get(), features.get(), model.get(),
+                                                  scaler.get(), usesScaling.get(), nullptr));
+        if (!output) return pythonError();
+
+        PyObject* predictions = nullptr;
+        PyObject* probabilities = nullptr;
+        if (!PyArg_ParseTuple(output.get(), "OO", &predictions, &probabilities)) return pythonError();
+
+        const int flags = NPY_ARRAY_CARRAY_RO | NPY_ARRAY_FORCECAST;
+        PyRef labels(PyArray_FROMANY(predictions, NPY_INT64, 1, 1, flags));
+        PyRef scores(PyArray_FROMANY(probabilities, NPY_FLOAT64, 1, 1, flags));
+        if (!labels || !scores) return pythonError();
+
+        auto* labelArray = reinterpret_cast<PyArrayObject*>(labels.get());
+        auto* scoreArray = reinterpret_cast<PyArrayObject*>(scores.get());
+        if (static_cast<size_t>(PyArray_SIZE(labelArray)) != rowCount ||
+            static_cast<size_t>(PyArray_SIZE(scoreArray)) != rowCount) {
+            return "predict_matrix returned the wrong number of rows";
+        }
+
+        const auto* label = static_cast<const int64_t*>(PyArray_DATA(labelArray));
+        const auto* probability = static_cast<const double*>(PyArray_DATA(scoreArray));
+        for (size_t i = 0; i < rowCount; ++i) {
+            results[i].success = true;
+            results[i].prediction = static_cast<int>(label[i]);
+            results[i].probability = probability[i];
+        }
+
+        return {};
+    }
+};
+
+#else
+
+struct EmbeddedPythonBackend::Service {};
+
+#endif
+
+EmbeddedPythonBackend::EmbeddedPythonBackend(QObject* parent) : InferenceBackend(parent) {}
+
+EmbeddedPythonBackend::~EmbeddedPythonBackend() {
+    shutdown();
+}
+
+bool EmbeddedPythonBackend::isAvailable() {
+#ifdef HAVE_EMBEDDED_PYTHON
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string EmbeddedPythonBackend::name() const {
+    return "embedded";
+}
+
+bool EmbeddedPythonBackend::initialize() {
+    shutdown();
+
+    auto env = EnvLoader::load();
+    modelPath = env["MODEL_PATH"];
+    metadataPath = env["METADATA_PATH"];
+    const QString script = QString::fromStdString(env["PYTHON_SERVICE_PATH"]);
+
+    if (!QFile::exists(script)) {
+        emit errorOccurred("Python service not found at: " + script);
+        return false;
+    }
+
+#ifdef HAVE_EMBEDDED_PYTHON
+    std::optional<ModelInfo> metadata = ModelMetadata::load(metadataPath);
+    if (!metadata || metadata->num_features <= 0) {
+        emit errorOccurred("Failed to read model metadata at: " + QString::fromStdString(metadataPath));
+        return false;
+    }
+
+    std::string program = env["PYTHON_INTERPRETER_PATH"];
+    if (!program.empty() && !QFile::exists(QString::fromStdString(program))) {
+        qWarning() << "Venv not found at:" << QString::fromStdString(program)
+                   << "using the Python the application was built with";
+        program.clear();
+    }
+
+    const std::string startError = startInterpreter(program);
+    if (!startError.empty()) {
+        emit errorOccurred(QString::fromStdString(startError));
+        return false;
+    }
+
+    auto loaded = std::make_unique<Service>();
+    loaded->columns = static_cast<size_t>(metadata->num_features);
+
+    std::string error;
+    {
+        GilLock lock;
+        error = loaded->load(QFileInfo(script), env);
+    }
+
+    if (!error.empty()) {
+        emit errorOccurred(QString("Failed to load model in embedded Python: %1").arg(QString::fromStdString(error)));
+        return false;
+    }
+
+    service = std::move(loaded);
+    qDebug() << "Embedded Python backend initialized with:" << script << "Python" << Py_GetVersion();
+    return true;
+#else
+    emit errorOccurred("Embedded Python support was not compiled in");
+    return false;
+#endif
+}
+
+ModelInfo EmbeddedPythonBackend::info() {
+    std::optional<ModelInfo> info = ModelMetadata::load(metadataPath);
+
+    if (!info) {
+        emit errorOccurred("Failed to retrieve model info");
+        return ModelInfo{};
+    }
+
+    info->model_fingerprint = ModelMetadata::fingerprint(modelPath);
+    return *info;
+}
+
+std::vector<PredictionResult> EmbeddedPythonBackend::fail(size_t rowCount, const std::string& message) {
+    PredictionResult failed{};
+    failed.success = false;
+    failed.error_message = message;
+    emit errorOccurred(QString::fromStdString(message));
+    return std::vector<PredictionResult>(rowCount, failed);
+}
+
+PredictionResult EmbeddedPythonBackend::predict(const std::vector<float>& features) {
+    return score({features}, false).front();
+}
+
+std::vector<PredictionResult> EmbeddedPythonBackend::predictBatch(const std::vector<std::vector<float>>& rows) {
+    return score(rows, true);
+}
+
+std::vector<PredictionResult> EmbeddedPythonBackend::score(const std::vector<std::vector<float>>& rows, bool batch) {
+    if (rows.empty()) return {};
+
+#ifdef HAVE_EMBEDDED_PYTHON
+    const qint64 started = nowNs();
+
+    if (!service) return fail(rows.size(), "Embedded Python backend is not initialized");
+
+    for (const auto& row : rows) {
+        if (row.size() != service->columns) {
+            return fail(rows.size(), "Expected " + std::to_string(service->columns) + " features");
+        }
+    }
+
+    service->input.resize(rows.size() * service->columns);
+    double* destination = service->input.data();
+    for (const auto& row : rows) {
+        destination = std::copy(row.begin(), row.end(), destination);
+    }
+
+    std::vector<PredictionResult> results(rows.size());
+    std::string error;
+    {
+        GilLock lock;
+        error = service->run(rows.size(), results);
+    }
+
+    if (!error.empty()) return fail(rows.size(), "Python inference failed: " + error);
+
+    recordCall(rows.size(), batch, started);
+    return results;
+#else
+    Q_UNUSED(batch);
+    return fail(rows.size(), "Embedded Python backend is not initialized");
+#endif
+}
+
+void EmbeddedPythonBackend::shutdown() {
+    service.reset();
+}
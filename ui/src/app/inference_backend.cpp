@@ -0,0 +1,38 @@
+#include "inference_backend.h"
+#include <QTimer>
+#include <algorithm>
+
+InferenceBackend::InferenceBackend(QObject* parent)
+    : QObject(parent), nextAsyncId(1) {
+    statsClock.start();
+}
+
+quint64 InferenceBackend::predictAsync(const std::vector<float>& features) {
+    const quint64 requestId = nextAsyncId++;
+    PredictionResult result = predict(features);
+
+    QTimer::singleShot(0, this, [this, requestId, result]() {
+        emit predictionReady(requestId, result);
+    });
+    return requestId;
+}
+
+InferenceBackend::Stats InferenceBackend::stats() const {
+    Stats stats = callStats;
+    stats.backend = name();
+    return stats;
+}
+
+qint64 InferenceBackend::nowNs() const {
+    return statsClock.nsecsElapsed();
+}
+
+void InferenceBackend::recordCall(size_t rows, bool batch, qint64 startedNs) {
+    if (batch) {
+        ++callStats.batches;
+    } else {
+        ++callStats.requests;
+    }
+    callStats.rows += rows;
+    callStats.latencyUs.record(static_cast<uint64_t>(std::max<qint64>(0, nowNs() - startedNs) / 1000));
+}
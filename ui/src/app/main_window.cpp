@@ -1,19 +1,20 @@
 #include "main_window.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
-    bridge = std::make_unique<PythonBridge>(this);
-    connect(bridge.get(), &PythonBridge::errorOccurred, this, &MainWindow::onPythonError);
+    backend = BackendFactory::fromEnv(this);
 
-    auto env = EnvLoader::load();
-    QString pythonService = QString::fromStdString(env["PYTHON_SERVICE_PATH"]);
+    if (backend) {
+        connect(backend.get(), &InferenceBackend::errorOccurred, this, &MainWindow::onBackendError);
+        connect(backend.get(), &InferenceBackend::predictionReady, this, &MainWindow::onPredictionReady);
+    }
 
-    if (!bridge->initialize(pythonService)) {
-        QMessageBox::critical(this, "System Error", "Could not initialize Python Bridge.\nCheck logs.");
+    if (!backend || !backend->initialize()) {
+        QMessageBox::critical(this, "System Error", "Could not initialize inference backend.\nCheck logs.");
         QTimer::singleShot(0, this, &MainWindow::close);
         return;
     }
 
-    modelInfo = bridge->getModelInfo();
+    modelInfo = backend->info();
     if (modelInfo.features.empty()) {
         QMessageBox::critical(this, "Model Error", "Failed to load model metadata.");
         QTimer::singleShot(0, this, &MainWindow::close);
@@ -217,21 +218,7 @@ std::optional<std::vector<float>> MainWindow::validateAndCollect() {
     std::vector<float> data;
     bool hasError = false;
 
-    static const std::map<std::string, FeatureLimit> rules = {
-        {"age",      {0,   120, true}},
-        {"sex",      {0,   1,   true}},
-        {"cp",       {0,   3,   true}},
-        {"trestbps", {50,  250, false}},
-        {"chol",     {100, 600, false}},
-        {"fbs",      {0,   1,   true}},
-        {"restecg",  {0,   2,   true}},
-        {"thalch",   {50,  250, false}},
-        {"exang",    {0,   1,   true}},
-        {"oldpeak",  {0.0, 10.0, false}},
-        {"slope",    {0,   2,   true}},
-        {"ca",       {0,   4,   true}},
-        {"thal",     {0,   3,   true}}
-    };
+    const auto& rules = featureLimits();
 
     for (const auto& feature : modelInfo.features) {
         QLineEdit* field = inputFields[feature];
@@ -292,8 +279,24 @@ void MainWindow::onPredictClicked() {
     predictButton->setEnabled(false);
     resultLabel->setText(currentLang == "en" ? "Thinking..." : "Аналіз...");
 
-    PredictionResult result = bridge->predict(featuresOpt.value());
+    pendingPredictionId = backend->predictAsync(featuresOpt.value());
+
+    if (pendingPredictionId == 0) {
+        PredictionResult result{};
+        result.success = false;
+        result.error_message = "Inference backend is not running";
+        showPrediction(result);
+    }
+}
+
+void MainWindow::onPredictionReady(quint64 requestId, const PredictionResult& result) {
+    if (requestId != pendingPredictionId) return;
+
+    pendingPredictionId = 0;
+    showPrediction(result);
+}
 
+void MainWindow::showPrediction(const PredictionResult& result) {
     if (!result.success) {
         resultLabel->setText("Error: " + QString::fromStdString(result.error_message));
         resultLabel->setStyleSheet("background: #34495e; color: white; padding: 15px;");
@@ -328,6 +331,6 @@ void MainWindow::onClearClicked() {
     updateTexts();
 }
 
-void MainWindow::onPythonError(const QString& error) {
-    qWarning() << "Bridge Error:" << error;
+void MainWindow::onBackendError(const QString& error) {
+    qWarning() << "Backend Error:" << error;
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "micro_batcher.h"
+#include <algorithm>
+
+MicroBatcher::MicroBatcher(QObject* parent)
+    : QObject(parent), inFlight(0) {
+    clock.start();
+
+    // QTimer has millisecond resolution, so windows below 1 ms round up.
+    windowTimer.setSingleShot(true);
+    windowTimer.setTimerType(Qt::PreciseTimer);
+    connect(&windowTimer, &QTimer::timeout, this, &MicroBatcher::flush);
+}
+
+void MicroBatcher::configure(const Options& newOptions) {
+    options = newOptions;
+    options.maxBatch = std::max<size_t>(1, options.maxBatch);
+    options.maxInFlight = std::max<size_t>(1, options.maxInFlight);
+    options.windowUs = std::max(0, options.windowUs);
+}
+
+void MicroBatcher::setMaxInFlight(size_t maxInFlight) {
+    options.maxInFlight = std::max<size_t>(1, maxInFlight);
+
+    while (!queue.empty() && inFlight < options.maxInFlight) {
+        flushUpTo(options.maxBatch);
+    }
+}
+
+void MicroBatcher::enqueue(quint64 requestId, std::vector<float> features) {
+    queue.push_back({requestId, std::move(features), clock.nsecsElapsed()});
+
+    if (inFlight < options.maxInFlight || queue.size() >= options.maxBatch) {
+        flushUpTo(options.maxBatch);
+        return;
+    }
+
+    if (!windowTimer.isActive()) {
+        windowTimer.start((options.windowUs + 999) / 1000);
+    }
+}
+
+void MicroBatcher::flush() {
+    while (!queue.empty()) {
+        flushUpTo(options.maxBatch);
+    }
+}
+
+void MicroBatcher::batchCompleted() {
+    if (inFlight > 0) --inFlight;
+
+    if (!queue.empty() && inFlight < options.maxInFlight) {
+        flushUpTo(options.maxBatch);
+    }
+}
+
+void MicroBatcher::flushUpTo(size_t count) {
+    const size_t size = std::min(count, queue.size());
+    if (size == 0) return;
+
+    const qint64 now = clock.nsecsElapsed();
+    std::vector<Entry> batch(std::make_move_iterator(queue.begin()),
+                             std::make_move_iterator(queue.begin() + size));
+    queue.erase(queue.begin(), queue.begin() + size);
+
+    batchStats.batchSizes.record(size);
+    for (const Entry& entry : batch) {
+        batchStats.queueWaitUs.record(static_cast<uint64_t>((now - entry.enqueuedNs) / 1000));
+    }
+
+    if (queue.empty()) {
+        windowTimer.stop();
+    }
+
+    ++inFlight;
+    emit batchReady(batch);
+}
+
+void MicroBatcher::clear() {
+    windowTimer.stop();
+    queue.clear();
+    inFlight = 0;
+}
+
+size_t MicroBatcher::queued() const {
+    return queue.size();
+}
+
+const MicroBatcher::Stats& MicroBatcher::stats() const {
+    return batchStats;
+}
@@ -0,0 +1,247 @@
+#include "native_backend.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include "hnsw_index.h"
+#include "knn_model.h"
+#include "model_metadata.h"
+#include "sklearn_pickle.h"
+#include "svm_model.h"
+#include "thread_pool.h"
+#include "tree_ensemble.h"
+
+#ifdef HAVE_GENERATED_MODEL
+#include "generated_model.h"
+#endif
+
+NativeBackend::NativeBackend(QObject* parent) : InferenceBackend(parent) {}
+
+std::string NativeBackend::name() const {
+    return "native";
+}
+
+bool NativeBackend::initialize() {
+    auto env = EnvLoader::load();
+    modelPath = env["NATIVE_MODEL_PATH"];
+    metadataPath = env["METADATA_PATH"];
+
+    try {
+#ifdef HAVE_GENERATED_MODEL
+        if (modelPath.empty()) {
+            model = Native::makeGeneratedModel();
+        } else {
+            model = loadModelFile(env["SCALER_PATH"]);
+        }
+#else
+        model = loadModelFile(env["SCALER_PATH"]);
+#endif
+    } catch (const std::exception& e) {
+        emit errorOccurred(QString("Failed to load native model: %1").arg(e.what()));
+        return false;
+    }
+
+    const std::string evaluation = env["NATIVE_TREE_EVALUATION"];
+    if (auto* trees = dynamic_cast<Native::TreeEnsemble*>(model.get()); trees && !evaluation.empty()) {
+        bool applied = false;
+        if (evaluation == "quickscorer") {
+            applied = trees->setEvaluation(Native::TreeEnsemble::Evaluation::QuickScorer);
+        } else if (evaluation == "simd") {
+            applied = trees->setEvaluation(Native::TreeEnsemble::Evaluation::Simd);
+        } else if (evaluation == "traversal") {
+            applied = trees->setEvaluation(Native::TreeEnsemble::Evaluation::Traversal);
+        }
+
+        if (!applied) {
+            qWarning() << "Ignoring NATIVE_TREE_EVALUATION=" << QString::fromStdString(evaluation)
+                       << "for this model";
+        }
+    }
+
+    const std::string svmEvaluation = env["NATIVE_SVM_EVALUATION"];
+    if (auto* svm = dynamic_cast<Native::SvmModel*>(model.get()); svm && !svmEvaluation.empty()) {
+        bool applied = false;
+        if (svmEvaluation == "rff") {
+            applied = svm->setEvaluation(Native::SvmModel::Evaluation::RandomFeatures);
+            if (applied) {
+                qDebug() << "SVM scored with random Fourier features, agreement with the exact SVC at export:"
+                         << svm->randomFeatureAgreement();
+            }
+        } else if (svmEvaluation == "exact") {
+            applied = svm->setEvaluation(Native::SvmModel::Evaluation::Exact);
+        }
+
+        if (!applied) {
+            qWarning() << "Ignoring NATIVE_SVM_EVALUATION=" << QString::fromStdString(svmEvaluation)
+                       << "for this model";
+        }
+    }
+
+    if (auto* knn = dynamic_cast<Native::KnnModel*>(model.get())) {
+        const std::string indexPath = env["NATIVE_KNN_INDEX"];
+        if (!indexPath.empty()) {
+            try {
+                knn->attachIndex(Native::HnswIndex::open(indexPath));
+            } catch (const std::exception& e) {
+                emit errorOccurred(QString("Failed to load KNN index: %1").arg(e.what()));
+                return false;
+            }
+        }
+
+        if (!env["NATIVE_KNN_EF"].empty()) {
+            try {
+                knn->setSearchBreadth(static_cast<size_t>(std::max(1, std::stoi(env["NATIVE_KNN_EF"]))));
+            } catch (const std::exception&) {
+                qWarning() << "Ignoring invalid NATIVE_KNN_EF value:"
+                           << QString::fromStdString(env["NATIVE_KNN_EF"]);
+            }
+        }
+
+        if (knn->hasIndex()) {
+            qDebug() << "KNN searches" << QString::fromStdString(indexPath)
+                     << "with ef" << knn->searchBreadth();
+        }
+    }
+
+    const std::string layout = env["NATIVE_NODE_LAYOUT"];
+    if (auto* trees = dynamic_cast<Native::TreeEnsemble*>(model.get()); trees && !layout.empty()) {
+        const std::map<std::string, Native::TreeEnsemble::NodeLayout> layouts = {
+            {"depthfirst", Native::TreeEnsemble::NodeLayout::DepthFirst},
+            {"breadthfirst", Native::TreeEnsemble::NodeLayout::BreadthFirst},
+            {"veb", Native::TreeEnsemble::NodeLayout::VanEmdeBoas},
+            {"hotpath", Native::TreeEnsemble::NodeLayout::HotPath},
+        };
+
+        size_t topLevels = 0;
+        if (!env["NATIVE_SHARED_TOP_LEVELS"].empty()) {
+            try {
+                topLevels = static_cast<size_t>(std::max(0, std::stoi(env["NATIVE_SHARED_TOP_LEVELS"])));
+            } catch (const std::exception&) {
+                qWarning() << "Ignoring invalid NATIVE_SHARED_TOP_LEVELS value:"
+                           << QString::fromStdString(env["NATIVE_SHARED_TOP_LEVELS"]);
+            }
+        }
+
+        auto it = layouts.find(layout);
+        if (it == layouts.end() || !trees->setNodeLayout(it->second, topLevels)) {
+            qWarning() << "Ignoring NATIVE_NODE_LAYOUT=" << QString::fromStdString(layout)
+                       << "for this model";
+        }
+    }
+
+    threads = 0;
+    if (!env["NATIVE_THREADS"].empty()) {
+        try {
+            threads = static_cast<size_t>(std::max(1, std::stoi(env["NATIVE_THREADS"])));
+        } catch (const std::exception&) {
+            qWarning() << "Ignoring invalid NATIVE_THREADS value:"
+                       << QString::fromStdString(env["NATIVE_THREADS"]);
+        }
+    }
+
+    qDebug() << "Native backend initialized with:"
+             << (modelPath.empty() ? QString("compiled-in model") : QString::fromStdString(modelPath))
+             << "model:" << QString::fromStdString(model->kind())
+             << "batch threads:" << (threads != 0 ? threads : Native::ThreadPool::shared().size());
+    return true;
+}
+
+std::unique_ptr<Native::Model> NativeBackend::loadModelFile(const std::string& scalerPath) const {
+    const std::string pickleSuffix = ".pkl";
+    const bool pickled = modelPath.size() >= pickleSuffix.size() &&
+                         modelPath.compare(modelPath.size() - pickleSuffix.size(), pickleSuffix.size(),
+                                           pickleSuffix) == 0;
+    if (!pickled) return Native::loadModel(modelPath);
+
+    // The pickle has neither feature names nor the scaler; both come from
+    // what the notebook saved next to it.
+    std::optional<ModelInfo> metadata = ModelMetadata::load(metadataPath);
+    if (!metadata) {
+        throw std::runtime_error("METADATA_PATH is required to load " + modelPath);
+    }
+    return Native::loadPickledModel(modelPath, metadata->uses_scaling ? scalerPath : std::string(),
+                                    metadata->features);
+}
+
+ModelInfo NativeBackend::info() {
+    std::optional<ModelInfo> info = ModelMetadata::load(metadataPath);
+
+    if (!info) {
+        emit errorOccurred("Failed to retrieve model info");
+        return ModelInfo{};
+    }
+
+#ifdef HAVE_GENERATED_MODEL
+    if (modelPath.empty()) {
+        info->model_fingerprint = std::string("generated-") + Native::generatedModelFingerprint();
+        return *info;
+    }
+#endif
+
+    info->model_fingerprint = ModelMetadata::fingerprint(modelPath);
+    return *info;
+}
+
+std::vector<PredictionResult> NativeBackend::fail(size_t rowCount, const std::string& message) {
+    PredictionResult failed{};
+    failed.success = false;
+    failed.error_message = message;
+    emit errorOccurred(QString::fromStdString(message));
+    return std::vector<PredictionResult>(rowCount, failed);
+}
+
+PredictionResult NativeBackend::predict(const std::vector<float>& features) {
+    if (!model) return fail(1, "Native backend is not initialized").front();
+
+    if (features.size() != model->numFeatures()) {
+        return fail(1, "Expected " + std::to_string(model->numFeatures()) + " features").front();
+    }
+
+    const qint64 started = nowNs();
+    Native::Prediction prediction = model->predict(features.data());
+    recordCall(1, false, started);
+
+    PredictionResult result{};
+    result.success = true;
+    result.prediction = prediction.label;
+    result.probability = prediction.probability;
+    return result;
+}
+
+std::vector<PredictionResult> NativeBackend::predictBatch(const std::vector<std::vector<float>>& rows) {
+    if (rows.empty()) return {};
+    if (!model) return fail(rows.size(), "Native backend is not initialized");
+
+    const size_t columns = model->numFeatures();
+    for (const auto& row : rows) {
+        if (row.size() != columns) {
+            return fail(rows.size(), "Expected " + std::to_string(columns) + " features");
+        }
+    }
+
+    const qint64 started = nowNs();
+
+    rowBuffer.resize(rows.size() * columns);
+    predictionBuffer.resize(rows.size());
+    std::vector<PredictionResult> results(rows.size());
+
+    // A block is gathered, scored and converted by one thread while it is
+    // still in cache. Blocks own disjoint parts of every buffer.
+    Native::ThreadPool::shared().parallelFor(rows.size(), Native::kParallelBlockRows, [&](size_t begin, size_t end) {
+        float* destination = rowBuffer.data() + begin * columns;
+        for (size_t i = begin; i < end; ++i) {
+            destination = std::copy(rows[i].begin(), rows[i].end(), destination);
+        }
+
+        model->predictBatch(rowBuffer.data() + begin * columns, end - begin, predictionBuffer.data() + begin);
+
+        for (size_t i = begin; i < end; ++i) {
+            results[i].success = true;
+            results[i].prediction = predictionBuffer[i].label;
+            results[i].probability = predictionBuffer[i].probability;
+        }
+    }, threads);
+
+    recordCall(rows.size(), true, started);
+    return results;
+}
@@ -0,0 +1,342 @@
+#include "onnx_backend.h"
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+
+#include "model_metadata.h"
+#include "thread_pool.h"
+
+#ifdef HAVE_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace {
+constexpr int kDefaultIntraOpThreads = 1;
+}
+
+#ifdef HAVE_ONNXRUNTIME
+
+// Input and output buffers bound once to an IoBinding. Run() writes straight
+// into labels/probabilities; the binding is only rebuilt when the row count
+// changes, so repeated calls of the same shape allocate nothing.
+struct TensorBinding {
+    std::vector<float> input;
+    std::vector<int64_t> labels;
+    std::vector<float> probabilities;
+    std::unique_ptr<Ort::IoBinding> io;
+    size_t rows = 0;
+};
+
+struct OnnxBackend::Session {
+    Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "course-work-ml-evaluation"};
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    std::unique_ptr<Ort::Session> session;
+
+    std::string inputName;
+    std::string labelName;
+    std::string probabilityName;
+    size_t columns = 0;
+    size_t classes = 2;
+
+    // Single-row calls keep their own binding so that interleaved batches
+    // never force it to be rebuilt.
+    TensorBinding single;
+    TensorBinding batch;
+
+    void bind(TensorBinding& binding, size_t rows) {
+        if (binding.io && binding.rows == rows) return;
+
+        binding.input.resize(rows * columns);
+        binding.labels.resize(rows);
+        binding.probabilities.resize(rows * classes);
+
+        const int64_t inputShape[] = {static_cast<int64_t>(rows), static_cast<int64_t>(columns)};
+        const int64_t labelShape[] = {static_cast<int64_t>(rows)};
+        const int64_t probabilityShape[] = {static_cast<int64_t>(rows), static_cast<int64_t>(classes)};
+
+        if (!binding.io) {
+            binding.io = std::make_unique<Ort::IoBinding>(*session);
+        } else {
+            binding.io->ClearBoundInputs();
+            binding.io->ClearBoundOutputs();
+        }
+
+        binding.io->BindInput(inputName.c_str(), Ort::Value::CreateTensor<float>(
+            memoryInfo, binding.input.data(), binding.input.size(), inputShape, 2));
+        binding.io->BindOutput(labelName.c_str(), Ort::Value::CreateTensor<int64_t>(
+            memoryInfo, binding.labels.data(), binding.labels.size(), labelShape, 1));
+        binding.io->BindOutput(probabilityName.c_str(), Ort::Value::CreateTensor<float>(
+            memoryInfo, binding.probabilities.data(), binding.probabilities.size(), probabilityShape, 2));
+
+        binding.rows = rows;
+    }
+
+    void run(TensorBinding& binding) {
+        session->Run(Ort::RunOptions{nullptr}, *binding.io);
+    }
+};
+
+#else
+
+struct OnnxBackend::Session {};
+
+#endif
+
+OnnxBackend::OnnxBackend(QObject* parent) : InferenceBackend(parent) {}
+
+OnnxBackend::~OnnxBackend() {
+    shutdown();
+}
+
+bool OnnxBackend::hasRuntime() {
+#ifdef HAVE_ONNXRUNTIME
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string OnnxBackend::name() const {
+    return "onnx";
+}
+
+bool OnnxBackend::initialize() {
+    return initialize(QString());
+}
+
+bool OnnxBackend::initialize(const QString& path) {
+    shutdown();
+
+    auto env = EnvLoader::load();
+    modelPath = path.isEmpty() ? QString::fromStdString(env["ONNX_MODEL_PATH"]) : path;
+    metadataPath = QString::fromStdString(env["METADATA_PATH"]);
+
+    if (!QFile::exists(modelPath)) {
+        emit errorOccurred("ONNX model not found at: " + modelPath);
+        return false;
+    }
+
+    const std::string engine = env["ONNX_ENGINE"];
+    if (!engine.empty() && engine != "runtime" && engine != "builtin") {
+        qWarning() << "Ignoring invalid ONNX_ENGINE value:" << QString::fromStdString(engine);
+    }
+
+    if (engine == "builtin" || !hasRuntime()) {
+        builtinThreads = 0;
+        if (!env["NATIVE_THREADS"].empty()) {
+            try {
+                builtinThreads = static_cast<size_t>(std::max(1, std::stoi(env["NATIVE_THREADS"])));
+            } catch (const std::exception&) {
+                qWarning() << "Ignoring invalid NATIVE_THREADS value:"
+                           << QString::fromStdString(env["NATIVE_THREADS"]);
+            }
+        }
+
+        try {
+            interpreter = Native::OnnxModel::load(modelPath.toStdString());
+        } catch (const std::exception& e) {
+            emit errorOccurred(QString("Failed to load ONNX model: %1").arg(e.what()));
+            return false;
+        }
+
+        QStringList operators;
+        for (const std::string& op : interpreter->operators()) operators << QString::fromStdString(op);
+        qDebug() << "ONNX backend initialized with:" << modelPath
+                 << "built-in interpreter:" << operators.join(" -> ");
+        return true;
+    }
+
+#ifdef HAVE_ONNXRUNTIME
+
+    int threads = kDefaultIntraOpThreads;
+    if (!env["ONNX_INTRA_OP_THREADS"].empty()) {
+        try {
+            threads = std::max(1, std::stoi(env["ONNX_INTRA_OP_THREADS"]));
+        } catch (const std::exception&) {
+            qWarning() << "Ignoring invalid ONNX_INTRA_OP_THREADS value:"
+                       << QString::fromStdString(env["ONNX_INTRA_OP_THREADS"]);
+        }
+    }
+
+    try {
+        auto loaded = std::make_unique<Session>();
+
+        Ort::SessionOptions options;
+        options.SetIntraOpNumThreads(threads);
+        options.SetInterOpNumThreads(1);
+        options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+
+#ifdef _WIN32
+        std::wstring file = modelPath.toStdWString();
+#else
+        std::string file = modelPath.toStdString();
+#endif
+        loaded->session = std::make_unique<Ort::Session>(loaded->env, file.c_str(), options);
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        Ort::Session& model = *loaded->session;
+
+        if (model.GetInputCount() != 1) {
+            emit errorOccurred("ONNX model must have exactly one input");
+            return false;
+        }
+
+        loaded->inputName = model.GetInputNameAllocated(0, allocator).get();
+        std::vector<int64_t> inputShape = model.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        if (inputShape.size() != 2 || inputShape[1] <= 0) {
+            emit errorOccurred("ONNX model input must be [N, features]");
+            return false;
+        }
+        loaded->columns = static_cast<size_t>(inputShape[1]);
+
+        for (size_t i = 0; i < model.GetOutputCount(); ++i) {
+            Ort::TypeInfo type = model.GetOutputTypeInfo(i);
+            if (type.GetONNXType() != ONNX_TYPE_TENSOR) continue;
+
+            auto tensor = type.GetTensorTypeAndShapeInfo();
+            std::string name = model.GetOutputNameAllocated(i, allocator).get();
+
+            if (tensor.GetElementType() == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64) {
+                loaded->labelName = name;
+            } else if (tensor.GetElementType() == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+                loaded->probabilityName = name;
+                std::vector<int64_t> shape = tensor.GetShape();
+                if (shape.size() == 2 && shape[1] > 0) {
+                    loaded->classes = static_cast<size_t>(shape[1]);
+                }
+            }
+        }
+
+        if (loaded->labelName.empty() || loaded->probabilityName.empty() || loaded->classes < 2) {
+            emit errorOccurred("ONNX model needs int64 label and float probability tensors "
+                               "(export with zipmap disabled)");
+            return false;
+        }
+
+        loaded->bind(loaded->single, 1);
+        session = std::move(loaded);
+    } catch (const Ort::Exception& e) {
+        emit errorOccurred(QString("Failed to load ONNX model: %1").arg(e.what()));
+        return false;
+    }
+
+    qDebug() << "ONNX backend initialized with:" << modelPath << "intra-op threads:" << threads;
+    return true;
+#else
+    emit errorOccurred("ONNX Runtime support was not compiled in");
+    return false;
+#endif
+}
+
+ModelInfo OnnxBackend::info() {
+    std::optional<ModelInfo> info = ModelMetadata::load(metadataPath.toStdString());
+
+    if (!info) {
+        emit errorOccurred("Failed to retrieve model info");
+        return ModelInfo{};
+    }
+
+    info->model_fingerprint = ModelMetadata::fingerprint(modelPath.toStdString());
+    return *info;
+}
+
+std::vector<PredictionResult> OnnxBackend::fail(size_t rowCount, const std::string& message) {
+    PredictionResult failed{};
+    failed.success = false;
+    failed.error_message = message;
+    emit errorOccurred(QString::fromStdString(message));
+    return std::vector<PredictionResult>(rowCount, failed);
+}
+
+PredictionResult OnnxBackend::predict(const std::vector<float>& features) {
+    return score({features}, false).front();
+}
+
+std::vector<PredictionResult> OnnxBackend::predictBatch(const std::vector<std::vector<float>>& rows) {
+    return score(rows, true);
+}
+
+std::vector<PredictionResult> OnnxBackend::score(const std::vector<std::vector<float>>& rows, bool batch) {
+    if (rows.empty()) return {};
+    if (interpreter) return scoreBuiltin(rows, batch);
+
+#ifdef HAVE_ONNXRUNTIME
+    const qint64 started = nowNs();
+
+    if (!session) return fail(rows.size(), "ONNX backend is not initialized");
+
+    for (const auto& row : rows) {
+        if (row.size() != session->columns) {
+            return fail(rows.size(), "Expected " + std::to_string(session->columns) + " features");
+        }
+    }
+
+    TensorBinding& binding = rows.size() == 1 ? session->single : session->batch;
+
+    try {
+        session->bind(binding, rows.size());
+
+        float* input = binding.input.data();
+        for (const auto& row : rows) {
+            input = std::copy(row.begin(), row.end(), input);
+        }
+
+        session->run(binding);
+    } catch (const Ort::Exception& e) {
+        return fail(rows.size(), std::string("ONNX inference failed: ") + e.what());
+    }
+
+    std::vector<PredictionResult> results(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        results[i].success = true;
+        results[i].prediction = static_cast<int>(binding.labels[i]);
+        results[i].probability = binding.probabilities[i * session->classes + 1];
+    }
+
+    recordCall(rows.size(), batch, started);
+    return results;
+#else
+    Q_UNUSED(batch);
+    return fail(rows.size(), "ONNX backend is not initialized");
+#endif
+}
+
+std::vector<PredictionResult> OnnxBackend::scoreBuiltin(const std::vector<std::vector<float>>& rows, bool batch) {
+    const qint64 started = nowNs();
+
+    const size_t columns = interpreter->numFeatures();
+    for (const auto& row : rows) {
+        if (row.size() != columns) {
+            return fail(rows.size(), "Expected " + std::to_string(columns) + " features");
+        }
+    }
+
+    rowBuffer.resize(rows.size() * columns);
+    predictionBuffer.resize(rows.size());
+    std::vector<PredictionResult> results(rows.size());
+
+    // Blocks run on the shared pool, as in NativeBackend::predictBatch.
+    Native::ThreadPool::shared().parallelFor(rows.size(), Native::kParallelBlockRows, [&](size_t begin, size_t end) {
+        float* destination = rowBuffer.data() + begin * columns;
+        for (size_t i = begin; i < end; ++i) {
+            destination = std::copy(rows[i].begin(), rows[i].end(), destination);
+        }
+
+        interpreter->predictBatch(rowBuffer.data() + begin * columns, end - begin, predictionBuffer.data() + begin);
+
+        for (size_t i = begin; i < end; ++i) {
+            results[i].success = true;
+            results[i].prediction = predictionBuffer[i].label;
+            results[i].probability = predictionBuffer[i].probability;
+        }
+    }, builtinThreads);
+
+    recordCall(rows.size(), batch, started);
+    return results;
+}
+
+void OnnxBackend::shutdown() {
+    session.reset();
+    interpreter.reset();
+}
@@ -0,0 +1,200 @@
+#include "prediction_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+double PredictionCache::Stats::hitRate() const {
+    quint64 lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+}
+
+PredictionCache::PredictionCache()
+    : capacity(0), resolution(0.0), generation(0), hits(0), misses(0), coalesced(0) {}
+
+void PredictionCache::configure(size_t newCapacity, double newResolution) {
+    capacity = newCapacity;
+    resolution = std::max(0.0, newResolution);
+    reset();
+}
+
+void PredictionCache::setFeatures(const std::vector<std::string>& names) {
+    const auto& rules = featureLimits();
+
+    std::vector<bool> columns(names.size(), false);
+    for (size_t i = 0; i < names.size(); ++i) {
+        auto rule = rules.find(names[i]);
+        columns[i] = rule != rules.end() && rule->second.isInteger;
+    }
+
+    if (columns != integerColumns) {
+        integerColumns = std::move(columns);
+        invalidate();
+    }
+}
+
+bool PredictionCache::enabled() const {
+    return capacity > 0;
+}
+
+PredictionCache::Key PredictionCache::makeKey(const std::vector<float>& features) const {
+    Key key(features.size());
+
+    for (size_t i = 0; i < features.size(); ++i) {
+        const bool integer = i < integerColumns.size() && integerColumns[i];
+
+        if (integer) {
+            key[i] = std::llround(features[i]);
+        } else if (resolution > 0.0) {
+            key[i] = std::llround(static_cast<double>(features[i]) / resolution);
+        } else {
+            // +0.0 so that -0.0 and 0.0 share a key.
+            float value = features[i] + 0.0f;
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            key[i] = bits;
+        }
+    }
+
+    return key;
+}
+
+size_t PredictionCache::KeyHash::operator()(const Key& key) const {
+    // FNV-1a over the quantized values.
+    uint64_t hash = 14695981039346656037ull;
+    for (int64_t value : key) {
+        uint64_t bits = static_cast<uint64_t>(value);
+        for (int byte = 0; byte < 8; ++byte) {
+            hash ^= (bits >> (byte * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return static_cast<size_t>(hash);
+}
+
+std::optional<PredictionResult> PredictionCache::lookup(const Key& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++misses;
+        return std::nullopt;
+    }
+
+    ++hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->result;
+}
+
+bool PredictionCache::join(const Key& key, quint64 requestId) {
+    auto it = flightByKey.find(key);
+    if (it == flightByKey.end()) return false;
+
+    flights[it->second].followers.push_back(requestId);
+    ++coalesced;
+    return true;
+}
+
+void PredictionCache::lead(const Key& key, quint64 requestId) {
+    flights[requestId] = {key, generation, {}};
+    flightByKey[key] = requestId;
+}
+
+std::vector<quint64> PredictionCache::finish(quint64 leaderId, const PredictionResult& result) {
+    auto it = flights.find(leaderId);
+    if (it == flights.end()) return {};
+
+    Flight flight = std::move(it->second);
+    flights.erase(it);
+
+    auto byKey = flightByKey.find(flight.key);
+    if (byKey != flightByKey.end() && byKey->second == leaderId) {
+        flightByKey.erase(byKey);
+    }
+
+    if (result.success && flight.generation == generation && capacity > 0) {
+        auto existing = index.find(flight.key);
+        if (existing != index.end()) {
+            existing->second->result = result;
+            entries.splice(entries.begin(), entries, existing->second);
+        } else {
+            entries.push_front({flight.key, result});
+            index[flight.key] = entries.begin();
+
+            if (entries.size() > capacity) {
+                index.erase(entries.back().key);
+                entries.pop_back();
+            }
+        }
+    }
+
+    return std::move(flight.followers);
+}
+
+quint64 PredictionCache::drop(quint64 requestId) {
+    auto it = flights.find(requestId);
+    if (it == flights.end()) {
+        for (auto& [leader, flight] : flights) {
+            auto& followers = flight.followers;
+            followers.erase(std::remove(followers.begin(), followers.end(), requestId), followers.end());
+        }
+        return 0;
+    }
+
+    Flight flight = std::move(it->second);
+    flights.erase(it);
+
+    auto byKey = flightByKey.find(flight.key);
+    const bool current = byKey != flightByKey.end() && byKey->second == requestId;
+
+    if (flight.followers.empty()) {
+        if (current) flightByKey.erase(byKey);
+        return 0;
+    }
+
+    const quint64 successor = flight.followers.front();
+    flight.followers.erase(flight.followers.begin());
+    if (current) byKey->second = successor;
+    flights[successor] = std::move(flight);
+    return successor;
+}
+
+quint64 PredictionCache::leaderOf(quint64 requestId) const {
+    for (const auto& [leader, flight] : flights) {
+        if (std::find(flight.followers.begin(), flight.followers.end(), requestId) != flight.followers.end()) {
+            return leader;
+        }
+    }
+    return 0;
+}
+
+void PredictionCache::invalidate() {
+    ++generation;
+    entries.clear();
+    index.clear();
+    flightByKey.clear();
+}
+
+void PredictionCache::reset() {
+    invalidate();
+    flights.clear();
+    hits = 0;
+    misses = 0;
+    coalesced = 0;
+}
+
+PredictionCache::Stats PredictionCache::stats() const {
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.coalesced = coalesced;
+    stats.entries = entries.size();
+    stats.capacity = capacity;
+
+    // Each entry holds its key twice (list node and index node) plus the
+    // node and bucket overhead of both containers. Only successful results
+    // are stored, so error messages are empty.
+    const size_t columns = integerColumns.size();
+    const size_t perEntry = 2 * (sizeof(Key) + columns * sizeof(int64_t)) + sizeof(Entry) +
+                            sizeof(std::list<Entry>::iterator) + 4 * sizeof(void*);
+    stats.memoryBytes = entries.size() * perEntry + index.bucket_count() * sizeof(void*);
+
+    return stats;
+}
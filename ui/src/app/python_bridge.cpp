@@ -1,19 +1,74 @@
 #include "python_bridge.h"
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QTimer>
+#include <algorithm>
+#include <thread>
+
+namespace {
+constexpr int kResponseTimeoutMs = 5000;
+constexpr int kBatchRowsPerTimeoutMs = 10;
+constexpr int kDefaultShmRingBytes = 4 * 1024 * 1024;
+
+// Below this many rows per worker the extra round trips cost more than the
+// parallel predict_proba calls save.
+constexpr size_t kMinRowsPerShard = 1024;
+
+constexpr int kDefaultBatchWindowUs = 200;
+constexpr int kDefaultBatchMax = 32;
+
+constexpr int kDefaultCacheSize = 4096;
+constexpr double kDefaultCacheResolution = 0.001;
+
+constexpr int kInitialRestartDelayMs = 250;
+constexpr int kMaxRestartDelayMs = 5000;
+
+int batchTimeoutMs(size_t rowCount) {
+    return kResponseTimeoutMs + static_cast<int>(rowCount / kBatchRowsPerTimeoutMs);
+}
+
+int envInt(const std::unordered_map<std::string, std::string>& env, const std::string& key, int fallback) {
+    auto it = env.find(key);
+    if (it == env.end() || it->second.empty()) return fallback;
+
+    try {
+        return std::stoi(it->second);
+    } catch (const std::exception&) {
+        qWarning() << "Ignoring invalid" << QString::fromStdString(key) << "value:"
+                   << QString::fromStdString(it->second);
+        return fallback;
+    }
+}
+
+PythonWorker::Reply errorReply(const std::string& message) {
+    PythonWorker::Reply reply;
+    reply.json = {{"status", "error"}, {"message", message}};
+    return reply;
+}
+}
 
 PythonBridge::PythonBridge(QObject* parent)
-    : QObject(parent), process(nullptr), initialized(false) {}
+    : InferenceBackend(parent), initialized(false), orderedDelivery(false),
+      nextRequestId(1), asyncOutstanding(0), batcher(new MicroBatcher(this)) {
+    connect(batcher, &MicroBatcher::batchReady, this, &PythonBridge::onMicroBatchReady);
+}
 
 PythonBridge::~PythonBridge() {
     shutdown();
 }
 
-bool PythonBridge::initialize(const QString& pythonScript) {
-    process = new QProcess(this);
+std::string PythonBridge::name() const {
+    return "python";
+}
+
+bool PythonBridge::initialize() {
+    auto env = EnvLoader::load();
+    return initialize(QString::fromStdString(env["PYTHON_SERVICE_PATH"]));
+}
 
-    process->setProcessChannelMode(QProcess::MergedChannels);
+bool PythonBridge::initialize(const QString& pythonScript) {
     auto env = EnvLoader::load();
 
     QString pythonPath = QString::fromStdString(env["PYTHON_INTERPRETER_PATH"]);
@@ -23,50 +78,436 @@ bool PythonBridge::initialize(const QString& pythonScript) {
         pythonPath = "python3";
     }
 
-    process->start(pythonPath, QStringList() << pythonScript);
+    PythonWorker::Options options;
+    options.pythonPath = pythonPath;
+    options.script = pythonScript;
+    options.protocol = env["PYTHON_PROTOCOL"] == "json" ? Protocol::Json : Protocol::Binary;
+    options.sharedMemory = env["PYTHON_TRANSPORT"] == "shm";
+    options.sharedMemoryRingBytes = static_cast<size_t>(
+        std::max(4096, envInt(env, "PYTHON_SHM_RING_BYTES", kDefaultShmRingBytes)));
+    options.threads = std::max(1, envInt(env, "PYTHON_WORKER_THREADS", 1));
+
+    const int count = std::max(1, envInt(env, "PYTHON_WORKERS", 1));
+    const bool pinWorkers = envInt(env, "PYTHON_PIN_WORKERS", count > 1 ? 1 : 0) != 0;
+    const int cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < count; ++i) {
+        auto* worker = new PythonWorker(i, this);
+        connect(worker, &PythonWorker::replyReady, this, &PythonBridge::onWorkerReply);
+        connect(worker, &PythonWorker::errorOccurred, this, &PythonBridge::errorOccurred);
+        connect(worker, &PythonWorker::exited, this, &PythonBridge::onWorkerExited);
+
+        workers.push_back(worker);
+        workerOptions.push_back(options);
+        workerOptions.back().cpu = pinWorkers ? i % cpus : -1;
+        restartDelays.push_back(kInitialRestartDelayMs);
+        restartPending.push_back(false);
+
+        if (!worker->start(workerOptions.back())) {
+            emit errorOccurred(QString("Failed to start Python worker %1").arg(i));
+            shutdown();
+            return false;
+        }
+    }
+
+    MicroBatcher::Options batching;
+    batching.windowUs = envInt(env, "PYTHON_BATCH_WINDOW_US", kDefaultBatchWindowUs);
+    batching.maxBatch = static_cast<size_t>(std::max(1, envInt(env, "PYTHON_BATCH_MAX", kDefaultBatchMax)));
+    batching.maxInFlight = static_cast<size_t>(count);
+    batcher->configure(batching);
 
-    if (!process->waitForStarted(5000)) {
-        emit errorOccurred("Failed to start Python process: " + process->errorString());
-        return false;
+    double resolution = kDefaultCacheResolution;
+    if (!env["PYTHON_CACHE_RESOLUTION"].empty()) {
+        try {
+            resolution = std::stod(env["PYTHON_CACHE_RESOLUTION"]);
+        } catch (const std::exception&) {
+            qWarning() << "Ignoring invalid PYTHON_CACHE_RESOLUTION value:"
+                       << QString::fromStdString(env["PYTHON_CACHE_RESOLUTION"]);
+        }
     }
+    cache.configure(static_cast<size_t>(std::max(0, envInt(env, "PYTHON_CACHE_SIZE", kDefaultCacheSize))),
+                    resolution);
 
     initialized = true;
-    qDebug() << "Python bridge initialized using:" << pythonPath;
+    qDebug() << "Python bridge initialized using:" << pythonPath
+             << "workers:" << count
+             << "batch window us:" << batching.windowUs << "max batch:" << batching.maxBatch
+             << "protocol:" << (protocol() == Protocol::Binary ? "binary" : "json")
+             << "transport:" << (transport() == Transport::SharedMemory ? "shm" : "pipe");
     return true;
 }
 
-QString PythonBridge::sendCommand(const QString& command) {
-    if (!initialized || !process) return {};
+PythonBridge::Protocol PythonBridge::protocol() const {
+    return workers.empty() ? Protocol::Json : workers.front()->protocol();
+}
 
-    process->write(command.toUtf8() + "\n");
+PythonBridge::Transport PythonBridge::transport() const {
+    return workers.empty() ? Transport::Pipe : workers.front()->transport();
+}
 
-    if (!process->waitForReadyRead(5000)) {
-        QByteArray crashLog = process->readAll();
-        if (!crashLog.isEmpty()) {
-            qDebug() << "Python Crash Log:" << crashLog;
+size_t PythonBridge::workerCount() const {
+    return workers.size();
+}
+
+PythonWorker* PythonBridge::pickWorker() {
+    PythonWorker* best = nullptr;
+    for (PythonWorker* worker : workers) {
+        if (!worker->isRunning()) continue;
+        if (!best || worker->outstanding() < best->outstanding()) {
+            best = worker;
         }
-        emit errorOccurred("Timeout waiting for response");
-        return {};
+    }
+    return best;
+}
+
+void PythonBridge::onWorkerExited(int index, const std::vector<quint64>& orphanedRequests) {
+    if (!initialized) return;
+
+    emit errorOccurred(QString("Python worker %1 exited unexpectedly").arg(index));
+
+    for (quint64 requestId : orphanedRequests) {
+        complete(requestId, errorReply("Python process exited"));
     }
 
-    return QString::fromUtf8(process->readAll()).trimmed();
+    scheduleRestart(index);
 }
 
-nmjson PythonBridge::parseResponse(const QString& response) {
-    if (response.isEmpty()) return nmjson{};
+void PythonBridge::scheduleRestart(int index) {
+    if (restartPending[index]) return;
+    restartPending[index] = true;
 
-    try {
-        return nmjson::parse(response.toStdString());
-    } catch (const nmjson::parse_error& e) {
-        qWarning() << "JSON Parse Error. Raw Output:" << response;
-        return nmjson{};
+    const int delay = restartDelays[index];
+    restartDelays[index] = std::min(delay * 2, kMaxRestartDelayMs);
+
+    QTimer::singleShot(delay, this, [this, index]() { restartWorker(index); });
+}
+
+void PythonBridge::restartWorker(int index) {
+    if (!initialized || index >= static_cast<int>(workers.size())) return;
+
+    restartPending[index] = false;
+    if (workers[index]->isRunning()) return;
+
+    if (workers[index]->start(workerOptions[index])) {
+        restartDelays[index] = kInitialRestartDelayMs;
+        // The new process may have loaded a retrained model.
+        cache.invalidate();
+        qDebug() << "Python worker" << index << "restarted";
+    } else {
+        scheduleRestart(index);
+    }
+}
+
+quint64 PythonBridge::submit(const std::vector<std::vector<float>>& rows, RequestKind kind, bool async) {
+    if (!initialized || !pickWorker()) return 0;
+
+    const quint64 requestId = nextRequestId++;
+
+    if (async) {
+        ++asyncOutstanding;
+        asyncStartedNs[requestId] = nowNs();
+        if (orderedDelivery) {
+            orderedDeliveries[requestId] = {kind, false, {}};
+        }
+    }
+
+    size_t running = static_cast<size_t>(std::count_if(workers.begin(), workers.end(),
+        [](const PythonWorker* worker) { return worker->isRunning(); }));
+    size_t shards = std::min(running, rows.size() / kMinRowsPerShard);
+
+    if (kind != RequestKind::Batch || shards < 2) {
+        send(requestId, rows, kind, async, 0, 0);
+        return requestId;
+    }
+
+    batchGroups[requestId] = {shards, std::vector<PredictionResult>(rows.size()), async};
+
+    for (size_t shard = 0; shard < shards; ++shard) {
+        const size_t begin = rows.size() * shard / shards;
+        const size_t end = rows.size() * (shard + 1) / shards;
+        std::vector<std::vector<float>> shardRows(rows.begin() + begin, rows.begin() + end);
+
+        send(nextRequestId++, shardRows, kind, async, requestId, begin);
+    }
+
+    return requestId;
+}
+
+bool PythonBridge::send(quint64 requestId, const std::vector<std::vector<float>>& rows, RequestKind kind,
+                        bool async, quint64 parent, size_t offset, std::vector<quint64> members) {
+    PythonWorker* worker = pickWorker();
+    requests[requestId] = {kind, rows.size(), worker ? worker->index() : -1, async, parent, offset,
+                           std::move(members)};
+
+    bool sent = false;
+    if (worker) {
+        sent = kind == RequestKind::Info ? worker->sendInfo(requestId)
+                                         : worker->sendPredict(requestId, rows, kind);
+    }
+
+    if (!sent) {
+        complete(requestId, errorReply("Python bridge is not running"));
+    }
+    return sent;
+}
+
+quint64 PythonBridge::enqueueSingle(const std::vector<float>& features, bool async) {
+    if (!initialized || !pickWorker()) return 0;
+
+    const quint64 requestId = nextRequestId++;
+
+    if (async) {
+        ++asyncOutstanding;
+        asyncStartedNs[requestId] = nowNs();
+        if (orderedDelivery) {
+            orderedDeliveries[requestId] = {RequestKind::Single, false, {}};
+        }
+    } else {
+        blockingRequests.insert(requestId);
+    }
+
+    if (cache.enabled()) {
+        PredictionCache::Key key = cache.makeKey(features);
+
+        if (auto cached = cache.lookup(key)) {
+            if (async) {
+                // Deliver after the caller has seen the request id.
+                QTimer::singleShot(0, this, [this, requestId, result = *cached]() {
+                    if (initialized) deliverSingle(requestId, result);
+                });
+            } else {
+                deliverSingle(requestId, *cached);
+            }
+            return requestId;
+        }
+
+        if (cache.join(key, requestId)) return requestId;
+        cache.lead(key, requestId);
+    }
+
+    batcher->enqueue(requestId, features);
+    return requestId;
+}
+
+void PythonBridge::onMicroBatchReady(const std::vector<MicroBatcher::Entry>& entries) {
+    std::vector<std::vector<float>> rows;
+    std::vector<quint64> members;
+    rows.reserve(entries.size());
+    members.reserve(entries.size());
+
+    for (const MicroBatcher::Entry& entry : entries) {
+        rows.push_back(entry.features);
+        members.push_back(entry.requestId);
+    }
+
+    // A lone request keeps the single-row command.
+    RequestKind kind = rows.size() == 1 ? RequestKind::Single : RequestKind::Batch;
+    send(nextRequestId++, rows, kind, false, 0, 0, std::move(members));
+}
+
+void PythonBridge::deliverFlight(quint64 requestId, const PredictionResult& result) {
+    if (requestId == 0) return;
+
+    for (quint64 follower : cache.finish(requestId, result)) {
+        deliverSingle(follower, result);
+    }
+    deliverSingle(requestId, result);
+}
+
+void PythonBridge::deliverSingle(quint64 requestId, PredictionResult result) {
+    if (requestId == 0) return;
+
+    if (blockingRequests.erase(requestId) > 0) {
+        Reply reply;
+        reply.hasResults = true;
+        reply.results.push_back(std::move(result));
+        completedRequests[requestId] = std::move(reply);
+    } else {
+        finishAsync(requestId, RequestKind::Single, {std::move(result)});
+    }
+}
+
+PythonWorker* PythonBridge::workerFor(quint64 requestId) {
+    int index = -1;
+
+    if (quint64 leader = cache.leaderOf(requestId)) {
+        requestId = leader;
+    }
+
+    auto it = requests.find(requestId);
+    if (it != requests.end()) {
+        index = it->second.worker;
+    } else {
+        for (const auto& [id, request] : requests) {
+            if (request.parent == requestId ||
+                std::find(request.members.begin(), request.members.end(), requestId) != request.members.end()) {
+                index = request.worker;
+                break;
+            }
+        }
+    }
+
+    if (index < 0 || index >= static_cast<int>(workers.size())) return nullptr;
+    return workers[index];
+}
+
+PythonBridge::Reply PythonBridge::waitForResponse(quint64 requestId, int timeoutMs) {
+    if (requestId == 0) return Reply{};
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (completedRequests.count(requestId) == 0) {
+        PythonWorker* worker = workerFor(requestId);
+        qint64 remaining = timeoutMs - timer.elapsed();
+
+        if (!worker || remaining <= 0 || !worker->waitForReadyRead(static_cast<int>(remaining))) {
+            if (completedRequests.count(requestId) > 0) break;
+
+            emit errorOccurred("Timeout waiting for response");
+            abandon(requestId);
+            return Reply{};
+        }
+    }
+
+    Reply reply = std::move(completedRequests[requestId]);
+    completedRequests.erase(requestId);
+    return reply;
+}
+
+void PythonBridge::abandon(quint64 requestId) {
+    // Late replies for these ids are dropped by complete(). A micro-batch
+    // stays in flight for its other members; only this caller's slot is
+    // cleared.
+    // A coalesced request waiting on it takes over the slot.
+    const quint64 successor = cache.drop(requestId);
+
+    for (auto it = requests.begin(); it != requests.end();) {
+        std::replace(it->second.members.begin(), it->second.members.end(), requestId, successor);
+
+        if (it->first == requestId || it->second.parent == requestId) {
+            it = requests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    batchGroups.erase(requestId);
+    blockingRequests.erase(requestId);
+}
+
+void PythonBridge::onWorkerReply(quint64 requestId, const PythonWorker::Reply& reply) {
+    complete(requestId, reply);
+}
+
+void PythonBridge::complete(quint64 requestId, Reply reply) {
+    auto it = requests.find(requestId);
+    if (it == requests.end()) return;
+
+    const Request request = std::move(it->second);
+    requests.erase(it);
+
+    if (!request.members.empty()) {
+        std::vector<PredictionResult> results = toResults(std::move(reply), request.kind, request.rowCount);
+        for (size_t i = 0; i < request.members.size(); ++i) {
+            deliverFlight(request.members[i], results[i]);
+        }
+        batcher->batchCompleted();
+        return;
+    }
+
+    if (request.parent != 0) {
+        auto group = batchGroups.find(request.parent);
+        if (group == batchGroups.end()) return;
+
+        std::vector<PredictionResult> results = toResults(std::move(reply), request.kind, request.rowCount);
+        std::move(results.begin(), results.end(), group->second.results.begin() + request.offset);
+
+        if (--group->second.remainingShards > 0) return;
+
+        BatchGroup finished = std::move(group->second);
+        batchGroups.erase(group);
+
+        if (finished.async) {
+            finishAsync(request.parent, RequestKind::Batch, std::move(finished.results));
+        } else {
+            Reply merged;
+            merged.hasResults = true;
+            merged.results = std::move(finished.results);
+            completedRequests[request.parent] = std::move(merged);
+        }
+        return;
+    }
+
+    if (request.async) {
+        finishAsync(requestId, request.kind, toResults(std::move(reply), request.kind, request.rowCount));
+    } else {
+        completedRequests[requestId] = std::move(reply);
+    }
+}
+
+void PythonBridge::finishAsync(quint64 requestId, RequestKind kind, std::vector<PredictionResult> results) {
+    auto it = orderedDeliveries.find(requestId);
+    if (it == orderedDeliveries.end()) {
+        emitResults(requestId, kind, results);
+        return;
+    }
+
+    it->second.ready = true;
+    it->second.results = std::move(results);
+    flushOrderedDeliveries();
+}
+
+void PythonBridge::flushOrderedDeliveries() {
+    while (!orderedDeliveries.empty() && orderedDeliveries.begin()->second.ready) {
+        const quint64 requestId = orderedDeliveries.begin()->first;
+        OrderedDelivery delivery = std::move(orderedDeliveries.begin()->second);
+        orderedDeliveries.erase(orderedDeliveries.begin());
+
+        emitResults(requestId, delivery.kind, delivery.results);
+    }
+}
+
+void PythonBridge::emitResults(quint64 requestId, RequestKind kind, const std::vector<PredictionResult>& results) {
+    if (asyncOutstanding > 0) --asyncOutstanding;
+
+    auto started = asyncStartedNs.find(requestId);
+    if (started != asyncStartedNs.end()) {
+        recordCall(results.size(), kind == RequestKind::Batch, started->second);
+        asyncStartedNs.erase(started);
+    }
+
+    if (kind == RequestKind::Batch) {
+        emit batchReady(requestId, results);
+    } else {
+        emit predictionReady(requestId, results.front());
+    }
+}
+
+void PythonBridge::setOrderedDelivery(bool ordered) {
+    orderedDelivery = ordered;
+    if (ordered) return;
+
+    // Results still held back are released now; later ones arrive unordered.
+    auto held = std::move(orderedDeliveries);
+    orderedDeliveries.clear();
+
+    for (auto& [requestId, delivery] : held) {
+        if (delivery.ready) {
+            emitResults(requestId, delivery.kind, delivery.results);
+        }
     }
 }
 
-ModelInfo PythonBridge::getModelInfo() {
+ModelInfo PythonBridge::info() {
     ModelInfo info{};
-    QString response = sendCommand("INFO");
-    nmjson json = parseResponse(response);
+
+    quint64 requestId = 0;
+    if (initialized) {
+        requestId = nextRequestId++;
+        send(requestId, {}, RequestKind::Info, false, 0, 0);
+    }
+
+    nmjson json = waitForResponse(requestId, kResponseTimeoutMs).json;
 
     if (!json.is_object() || json.value("status", "") != "success") {
         emit errorOccurred("Failed to retrieve model info");
@@ -75,6 +516,7 @@ ModelInfo PythonBridge::getModelInfo() {
 
     auto data = json["data"];
     info.model_name = data.value("model_name", "Unknown");
+    info.model_fingerprint = data.value("model_fingerprint", "");
     info.num_features = data.value("num_features", 0);
     info.accuracy = data.value("metrics", nmjson::object()).value("accuracy", 0.0);
 
@@ -83,18 +525,18 @@ ModelInfo PythonBridge::getModelInfo() {
             info.features.push_back(f.get<std::string>());
     }
 
+    cache.setFeatures(info.features);
+    if (info.model_fingerprint != modelFingerprint) {
+        modelFingerprint = info.model_fingerprint;
+        cache.invalidate();
+    }
+
     return info;
 }
 
-PredictionResult PythonBridge::predict(const std::vector<float>& features) {
+PredictionResult PythonBridge::toPredictionResult(const nmjson& json) {
     PredictionResult result{};
 
-    nmjson request;
-    request["features"] = features;
-
-    QString response = sendCommand(QString::fromStdString(request.dump()));
-    nmjson json = parseResponse(response);
-
     if (!json.is_object()) {
         result.success = false;
         result.error_message = "Invalid response from Python (check logs)";
@@ -114,12 +556,177 @@ PredictionResult PythonBridge::predict(const std::vector<float>& features) {
     return result;
 }
 
+std::vector<PredictionResult> PythonBridge::toBatchResults(const nmjson& json, size_t rowCount) {
+    PredictionResult failed{};
+    failed.success = false;
+
+    if (!json.is_object()) {
+        failed.error_message = "Invalid response from Python (check logs)";
+        return std::vector<PredictionResult>(rowCount, failed);
+    }
+
+    if (json.value("status", "") != "success") {
+        failed.error_message = json.value("message", "Unknown error");
+        emit errorOccurred(QString::fromStdString(failed.error_message));
+        return std::vector<PredictionResult>(rowCount, failed);
+    }
+
+    auto predictions = json.find("predictions");
+    auto probabilities = json.find("probabilities");
+
+    if (predictions == json.end() || probabilities == json.end() ||
+        !predictions->is_array() || !probabilities->is_array() ||
+        predictions->size() != rowCount || probabilities->size() != rowCount) {
+        failed.error_message = "Batch response size mismatch";
+        emit errorOccurred(QString::fromStdString(failed.error_message));
+        return std::vector<PredictionResult>(rowCount, failed);
+    }
+
+    std::vector<PredictionResult> results(rowCount);
+    for (size_t i = 0; i < rowCount; ++i) {
+        results[i].success = true;
+        results[i].prediction = (*predictions)[i].get<int>();
+        results[i].probability = (*probabilities)[i].get<double>();
+    }
+
+    return results;
+}
+
+std::vector<PredictionResult> PythonBridge::toResults(Reply reply, RequestKind kind, size_t rowCount) {
+    if (reply.hasResults) {
+        if (reply.results.size() == rowCount) return std::move(reply.results);
+
+        PredictionResult failed{};
+        failed.success = false;
+        failed.error_message = "Batch response size mismatch";
+        emit errorOccurred(QString::fromStdString(failed.error_message));
+        return std::vector<PredictionResult>(rowCount, failed);
+    }
+
+    // JSON PREDICT replies use the single-row keys; binary error frames and
+    // BATCH replies share the batch layout.
+    if (kind == RequestKind::Single && reply.json.is_object() && !reply.json.contains("predictions")) {
+        return {toPredictionResult(reply.json)};
+    }
+
+    return toBatchResults(reply.json, rowCount);
+}
+
+PredictionResult PythonBridge::predict(const std::vector<float>& features) {
+    const qint64 started = nowNs();
+    quint64 requestId = enqueueSingle(features, false);
+    // A blocking caller cannot wait for the window, but it still picks up
+    // whatever async requests are queued.
+    batcher->flush();
+
+    if (requestId == 0) {
+        PredictionResult result{};
+        result.success = false;
+        result.error_message = "Python bridge is not running";
+        return result;
+    }
+
+    PredictionResult result = toResults(waitForResponse(requestId, kResponseTimeoutMs), RequestKind::Single, 1).front();
+    recordCall(1, false, started);
+    return result;
+}
+
+quint64 PythonBridge::predictAsync(const std::vector<float>& features) {
+    return enqueueSingle(features, true);
+}
+
+std::vector<PredictionResult> PythonBridge::predictBatch(const std::vector<std::vector<float>>& rows) {
+    if (rows.empty()) return {};
+
+    const qint64 started = nowNs();
+    quint64 requestId = submit(rows, RequestKind::Batch, false);
+    if (requestId == 0) {
+        PredictionResult failed{};
+        failed.success = false;
+        failed.error_message = "Python bridge is not running";
+        return std::vector<PredictionResult>(rows.size(), failed);
+    }
+
+    std::vector<PredictionResult> results =
+        toResults(waitForResponse(requestId, batchTimeoutMs(rows.size())), RequestKind::Batch, rows.size());
+    recordCall(rows.size(), true, started);
+    return results;
+}
+
+quint64 PythonBridge::predictBatchAsync(const std::vector<std::vector<float>>& rows) {
+    return submit(rows, RequestKind::Batch, true);
+}
+
+size_t PythonBridge::pendingRequests() const {
+    return asyncOutstanding;
+}
+
+const MicroBatcher::Stats& PythonBridge::batchingStats() const {
+    return batcher->stats();
+}
+
+PredictionCache::Stats PythonBridge::cacheStats() const {
+    return cache.stats();
+}
+
+PythonBridge::Stats PythonBridge::stats() const {
+    Stats stats = InferenceBackend::stats();
+
+    const PredictionCache::Stats cached = cache.stats();
+    stats.details.emplace_back("workers", static_cast<double>(workers.size()));
+    stats.details.emplace_back("cache_hit_rate", cached.hitRate());
+    stats.details.emplace_back("cache_coalesced", static_cast<double>(cached.coalesced));
+    stats.details.emplace_back("cache_entries", static_cast<double>(cached.entries));
+    stats.details.emplace_back("cache_bytes", static_cast<double>(cached.memoryBytes));
+
+    const MicroBatcher::Stats& batching = batcher->stats();
+    stats.details.emplace_back("micro_batches", static_cast<double>(batching.batchSizes.count()));
+    stats.details.emplace_back("micro_batch_p50_rows", static_cast<double>(batching.batchSizes.quantileUpperBound(0.5)));
+    stats.details.emplace_back("queue_wait_p99_us", static_cast<double>(batching.queueWaitUs.quantileUpperBound(0.99)));
+    return stats;
+}
+
+void PythonBridge::invalidateCache() {
+    cache.invalidate();
+}
+
 void PythonBridge::shutdown() {
-    if (process) {
-        process->write("EXIT\n");
-        process->waitForFinished(1000);
-        process->kill();
-        delete process;
-        process = nullptr;
-    }
-}
\ No newline at end of file
+    const MicroBatcher::Stats& stats = batcher->stats();
+    if (initialized && stats.batchSizes.count() > 0) {
+        qDebug() << "Micro-batching: batches" << stats.batchSizes.count()
+                 << "p50 size <" << stats.batchSizes.quantileUpperBound(0.5)
+                 << "p99 wait us <" << stats.queueWaitUs.quantileUpperBound(0.99);
+        qDebug() << "Batch sizes:" << QString::fromStdString(stats.batchSizes.toString());
+        qDebug() << "Queue wait us:" << QString::fromStdString(stats.queueWaitUs.toString());
+    }
+
+    const PredictionCache::Stats cached = cache.stats();
+    if (initialized && cached.hits + cached.misses > 0) {
+        qDebug() << "Prediction cache: hit rate" << cached.hitRate()
+                 << "coalesced" << cached.coalesced
+                 << "entries" << cached.entries << "/" << cached.capacity
+                 << "bytes" << cached.memoryBytes;
+    }
+
+    initialized = false;
+    batcher->clear();
+
+    for (PythonWorker* worker : workers) {
+        disconnect(worker, nullptr, this, nullptr);
+        delete worker;
+    }
+
+    workers.clear();
+    workerOptions.clear();
+    restartDelays.clear();
+    restartPending.clear();
+    requests.clear();
+    batchGroups.clear();
+    completedRequests.clear();
+    orderedDeliveries.clear();
+    blockingRequests.clear();
+    asyncStartedNs.clear();
+    cache.reset();
+    modelFingerprint.clear();
+    asyncOutstanding = 0;
+}
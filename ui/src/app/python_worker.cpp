@@ -0,0 +1,473 @@
+#include "python_worker.h"
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+#include <QTimer>
+
+namespace {
+constexpr int kStartTimeoutMs = 5000;
+constexpr int kHandshakeTimeoutMs = 5000;
+constexpr int kWriteTimeoutMs = 5000;
+
+// HELLO is exchanged before the worker is handed any bridge request, so it
+// can use an id the bridge never allocates.
+constexpr quint64 kHelloRequestId = 0;
+
+QByteArray commandFrame(BinaryFrame::FrameType type, quint64 requestId) {
+    BinaryFrame::Header header;
+    header.type = type;
+    header.requestId = requestId;
+
+    QByteArray frame(static_cast<int>(BinaryFrame::kHeaderSize), '\0');
+    BinaryFrame::encodeHeader(header, reinterpret_cast<unsigned char*>(frame.data()));
+    return frame;
+}
+}
+
+PythonWorker::PythonWorker(int index, QObject* parent)
+    : QObject(parent), workerIndex(index), process(nullptr), sharedMemory(nullptr),
+      running(false), activeProtocol(Protocol::Json), activeTransport(Transport::Pipe) {}
+
+PythonWorker::~PythonWorker() {
+    stop();
+}
+
+bool PythonWorker::start(const Options& workerOptions) {
+    stop();
+    options = workerOptions;
+
+    process = new QProcess(this);
+
+    // stderr is kept separate so tracebacks and warnings cannot corrupt the
+    // binary frame stream on stdout.
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    connect(process, &QProcess::readyReadStandardOutput, this, &PythonWorker::onReadyRead);
+    connect(process, &QProcess::readyReadStandardError, this, &PythonWorker::onReadyReadStandardError);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &PythonWorker::onProcessFinished);
+
+    // One native thread per worker: N workers already use N cores, letting
+    // every worker's BLAS/OpenMP pool grab all cores only oversubscribes.
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    const QString threads = QString::number(std::max(1, options.threads));
+    environment.insert("OMP_NUM_THREADS", threads);
+    environment.insert("MKL_NUM_THREADS", threads);
+    environment.insert("OPENBLAS_NUM_THREADS", threads);
+    if (options.cpu >= 0) {
+        environment.insert("ML_WORKER_CPU", QString::number(options.cpu));
+    }
+
+    if (options.protocol == Protocol::Binary && options.sharedMemory) {
+        prepareSharedMemory(environment);
+    }
+
+    process->setProcessEnvironment(environment);
+    process->start(options.pythonPath, QStringList() << options.script);
+
+    if (!process->waitForStarted(kStartTimeoutMs)) {
+        emit errorOccurred("Failed to start Python process: " + process->errorString());
+        stop();
+        return false;
+    }
+
+    running = true;
+    activeProtocol = Protocol::Json;
+    activeTransport = Transport::Pipe;
+
+    if (options.protocol == Protocol::Binary && !negotiateProtocol()) {
+        stop();
+        return false;
+    }
+
+    if (sharedMemory && activeTransport != Transport::SharedMemory) {
+        qWarning() << "Python worker" << workerIndex << "did not accept shared memory, using pipes";
+        delete sharedMemory;
+        sharedMemory = nullptr;
+    }
+
+    return true;
+}
+
+bool PythonWorker::prepareSharedMemory(QProcessEnvironment& environment) {
+    if (!ShmTransport::isSupported()) {
+        qWarning() << "Shared-memory transport is not supported on this platform, using pipes";
+        return false;
+    }
+
+    sharedMemory = new ShmTransport(this);
+    if (!sharedMemory->create(options.sharedMemoryRingBytes)) {
+        delete sharedMemory;
+        sharedMemory = nullptr;
+        return false;
+    }
+
+    sharedMemory->exportTo(environment);
+    connect(sharedMemory, &ShmTransport::readyRead, this, &PythonWorker::onSharedMemoryReadyRead);
+    return true;
+}
+
+bool PythonWorker::negotiateProtocol() {
+    nmjson request;
+    request["command"] = "HELLO";
+    request["protocols"] = {"binary", "json"};
+    if (sharedMemory) {
+        request["transports"] = {"shm", "pipe"};
+    }
+
+    if (!sendJson(kHelloRequestId, request)) return false;
+
+    // dispatchResponse() flips activeProtocol as soon as the HELLO reply is
+    // read, before any binary frame can follow it in the same buffer.
+    QElapsedTimer timer;
+    timer.start();
+
+    while (owns(kHelloRequestId)) {
+        qint64 remaining = kHandshakeTimeoutMs - timer.elapsed();
+        if (remaining <= 0 || !running || !process->waitForReadyRead(static_cast<int>(remaining))) {
+            if (!owns(kHelloRequestId)) break;
+            emit errorOccurred("Timeout negotiating protocol with Python worker");
+            return false;
+        }
+    }
+
+    if (!running) return false;
+
+    if (activeProtocol != Protocol::Binary) {
+        qWarning() << "Python service does not support binary framing, falling back to JSON";
+    }
+
+    return true;
+}
+
+void PythonWorker::stop() {
+    if (process) {
+        disconnect(process, nullptr, this, nullptr);
+
+        if (running) {
+            if (activeProtocol == Protocol::Binary) {
+                writeFrame(commandFrame(BinaryFrame::FrameType::Exit, 0));
+            } else {
+                process->write("EXIT\n");
+            }
+            process->waitForFinished(1000);
+        }
+
+        process->kill();
+        process->waitForFinished(1000);
+        // Deferred, since a corrupted frame stops the worker from inside
+        // one of this process's or transport's own signals.
+        process->deleteLater();
+        process = nullptr;
+    }
+
+    if (sharedMemory) {
+        disconnect(sharedMemory, nullptr, this, nullptr);
+        sharedMemory->deleteLater();
+        sharedMemory = nullptr;
+    }
+
+    running = false;
+    activeProtocol = Protocol::Json;
+    activeTransport = Transport::Pipe;
+    readBuffer.clear();
+    inFlight.clear();
+}
+
+int PythonWorker::index() const {
+    return workerIndex;
+}
+
+bool PythonWorker::isRunning() const {
+    return running;
+}
+
+PythonWorker::Protocol PythonWorker::protocol() const {
+    return activeProtocol;
+}
+
+PythonWorker::Transport PythonWorker::transport() const {
+    return activeTransport;
+}
+
+size_t PythonWorker::outstanding() const {
+    return inFlight.size();
+}
+
+bool PythonWorker::owns(quint64 requestId) const {
+    return inFlight.count(requestId) > 0;
+}
+
+bool PythonWorker::writeFrame(const QByteArray& frame) {
+    if (activeTransport == Transport::SharedMemory) {
+        return sharedMemory->write(frame, kWriteTimeoutMs);
+    }
+
+    process->write(frame);
+    return true;
+}
+
+bool PythonWorker::sendFrame(quint64 requestId, const QByteArray& frame) {
+    inFlight.insert(requestId);
+    if (writeFrame(frame)) return true;
+
+    // Part of the frame may already be in the request ring, and the service
+    // would read everything after it as garbage.
+    inFlight.erase(requestId);
+    abandon("Timeout writing to shared-memory transport");
+    return false;
+}
+
+void PythonWorker::abandon(const QString& reason) {
+    emit errorOccurred(reason);
+
+    std::vector<quint64> orphaned(inFlight.begin(), inFlight.end());
+
+    // Not running, so stop() kills the process without writing EXIT into
+    // the broken stream.
+    running = false;
+    stop();
+
+    // Reported from the event loop, like a process exit, rather than from
+    // inside the caller's send.
+    QTimer::singleShot(0, this, [this, orphaned]() {
+        emit exited(workerIndex, orphaned);
+    });
+}
+
+bool PythonWorker::sendJson(quint64 requestId, nmjson request) {
+    if (!running) return false;
+
+    request["id"] = requestId;
+    process->write(QByteArray::fromStdString(request.dump()) + "\n");
+    inFlight.insert(requestId);
+    return true;
+}
+
+bool PythonWorker::sendInfo(quint64 requestId) {
+    if (!running) return false;
+
+    if (activeProtocol == Protocol::Json) {
+        nmjson request;
+        request["command"] = "INFO";
+        return sendJson(requestId, request);
+    }
+
+    return sendFrame(requestId, commandFrame(BinaryFrame::FrameType::Info, requestId));
+}
+
+bool PythonWorker::sendPredict(quint64 requestId, const std::vector<std::vector<float>>& rows, RequestKind kind) {
+    if (!running) return false;
+
+    if (activeProtocol == Protocol::Json) {
+        nmjson request;
+        if (kind == RequestKind::Single) {
+            request["command"] = "PREDICT";
+            request["features"] = rows.front();
+        } else {
+            request["command"] = "BATCH";
+            request["rows"] = rows;
+        }
+        return sendJson(requestId, request);
+    }
+
+    const size_t columns = rows.empty() ? 0 : rows.front().size();
+    for (const auto& row : rows) {
+        if (row.size() != columns) {
+            emit errorOccurred("All rows in a batch must have the same number of features");
+            return false;
+        }
+    }
+
+    BinaryFrame::Header header;
+    header.type = BinaryFrame::FrameType::Predict;
+    header.columns = static_cast<uint16_t>(columns);
+    header.count = static_cast<uint32_t>(rows.size());
+    header.payloadBytes = static_cast<uint32_t>(rows.size() * columns * sizeof(float));
+    header.requestId = requestId;
+
+    QByteArray frame(static_cast<int>(BinaryFrame::kHeaderSize + header.payloadBytes), '\0');
+    auto* out = reinterpret_cast<unsigned char*>(frame.data());
+    BinaryFrame::encodeHeader(header, out);
+    out += BinaryFrame::kHeaderSize;
+
+    for (const auto& row : rows) {
+        BinaryFrame::storeFloats(out, row.data(), columns);
+        out += columns * sizeof(float);
+    }
+
+    return sendFrame(requestId, frame);
+}
+
+bool PythonWorker::waitForReadyRead(int timeoutMs) {
+    if (!running) return false;
+
+    if (activeTransport == Transport::SharedMemory) {
+        return sharedMemory->waitForReadyRead(timeoutMs);
+    }
+    return process->waitForReadyRead(timeoutMs);
+}
+
+void PythonWorker::onReadyRead() {
+    if (!process) return;
+
+    readBuffer.append(process->readAllStandardOutput());
+
+    if (activeProtocol == Protocol::Binary) {
+        readBinaryFrames();
+    } else {
+        readJsonLines();
+    }
+}
+
+void PythonWorker::onSharedMemoryReadyRead() {
+    if (!sharedMemory) return;
+
+    readBuffer.append(sharedMemory->readAll());
+    readBinaryFrames();
+}
+
+void PythonWorker::onReadyReadStandardError() {
+    if (!process) return;
+
+    QByteArray log = process->readAllStandardError();
+    if (!log.isEmpty()) {
+        qDebug() << "Python worker" << workerIndex << "stderr:" << log;
+    }
+}
+
+void PythonWorker::readJsonLines() {
+    int newline;
+    while ((newline = readBuffer.indexOf('\n')) >= 0) {
+        QString line = QString::fromUtf8(readBuffer.left(newline)).trimmed();
+        readBuffer.remove(0, newline + 1);
+
+        if (line.isEmpty()) continue;
+
+        nmjson json = parseResponse(line);
+        if (json.is_object()) {
+            dispatchResponse(json);
+        }
+
+        // The HELLO reply is the last JSON line; everything after it is framed.
+        if (activeProtocol == Protocol::Binary) {
+            readBinaryFrames();
+            return;
+        }
+    }
+}
+
+void PythonWorker::readBinaryFrames() {
+    while (static_cast<size_t>(readBuffer.size()) >= BinaryFrame::kHeaderSize) {
+        const auto* data = reinterpret_cast<const unsigned char*>(readBuffer.constData());
+
+        BinaryFrame::Header header;
+        if (!BinaryFrame::decodeHeader(data, header)) {
+            // The stream cannot be resynchronized, so nothing in flight
+            // would ever be answered.
+            qWarning() << "Corrupted frame from Python worker" << workerIndex << ", restarting it";
+            abandon("Corrupted frame from Python service");
+            return;
+        }
+
+        const size_t frameSize = BinaryFrame::kHeaderSize + header.payloadBytes;
+        if (static_cast<size_t>(readBuffer.size()) < frameSize) return;
+
+        const unsigned char* payload = data + BinaryFrame::kHeaderSize;
+        Reply reply;
+
+        if (header.type == BinaryFrame::FrameType::Result &&
+            header.payloadBytes == header.count * (sizeof(float) + 1)) {
+            std::vector<float> probabilities(header.count);
+            BinaryFrame::loadFloats(payload, probabilities.data(), header.count);
+            const auto* classes = reinterpret_cast<const int8_t*>(payload + header.count * sizeof(float));
+
+            reply.hasResults = true;
+            reply.results.resize(header.count);
+            for (uint32_t i = 0; i < header.count; ++i) {
+                reply.results[i].success = true;
+                reply.results[i].prediction = classes[i];
+                reply.results[i].probability = probabilities[i];
+            }
+        } else if (header.type == BinaryFrame::FrameType::Json) {
+            reply.json = parseResponse(QString::fromUtf8(
+                reinterpret_cast<const char*>(payload), static_cast<int>(header.payloadBytes)));
+        } else {
+            qWarning() << "Unexpected frame type from Python worker:" << static_cast<int>(header.type);
+        }
+
+        readBuffer.remove(0, static_cast<int>(frameSize));
+
+        if (owns(header.requestId)) {
+            deliver(header.requestId, reply);
+        } else if (reply.json.is_object()) {
+            dispatchResponse(reply.json);
+        }
+    }
+}
+
+void PythonWorker::dispatchResponse(const nmjson& json) {
+    if (!json.contains("id") || !json["id"].is_number_unsigned()) {
+        if (json.value("status", "") == "error") {
+            emit errorOccurred(QString::fromStdString(json.value("message", "Unknown error")));
+        } else {
+            qWarning() << "Dropping response without request id:" << QString::fromStdString(json.dump());
+        }
+        return;
+    }
+
+    quint64 requestId = json["id"].get<quint64>();
+
+    if (requestId == kHelloRequestId) {
+        inFlight.erase(requestId);
+
+        if (json.value("status", "") == "success" && json.value("protocol", "") == "binary") {
+            activeProtocol = Protocol::Binary;
+
+            // The worker has mapped the region by the time it answers HELLO.
+            if (sharedMemory && json.value("transport", "") == "shm") {
+                activeTransport = Transport::SharedMemory;
+                sharedMemory->unlinkName();
+            }
+        }
+        return;
+    }
+
+    Reply reply;
+    reply.json = json;
+    deliver(requestId, reply);
+}
+
+void PythonWorker::deliver(quint64 requestId, const Reply& reply) {
+    if (inFlight.erase(requestId) == 0) {
+        qWarning() << "Python worker" << workerIndex << "answered unknown request" << requestId;
+        return;
+    }
+
+    emit replyReady(requestId, reply);
+}
+
+void PythonWorker::onProcessFinished() {
+    onReadyReadStandardError();
+
+    if (!readBuffer.isEmpty()) {
+        qDebug() << "Python Crash Log:" << readBuffer;
+        readBuffer.clear();
+    }
+
+    running = false;
+
+    std::vector<quint64> orphaned(inFlight.begin(), inFlight.end());
+    inFlight.clear();
+
+    emit exited(workerIndex, orphaned);
+}
+
+nmjson PythonWorker::parseResponse(const QString& response) {
+    if (response.isEmpty()) return nmjson{};
+
+    try {
+        return nmjson::parse(response.toStdString());
+    } catch (const nmjson::parse_error& e) {
+        qWarning() << "JSON Parse Error. Raw Output:" << response;
+        return nmjson{};
+    }
+}
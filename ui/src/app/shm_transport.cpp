@@ -0,0 +1,310 @@
+#include "shm_transport.h"
+#include <QElapsedTimer>
+#include <QSocketNotifier>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr uint32_t kRegionMagic = 0x48534C4D; // "MLSH" read as little-endian
+constexpr uint32_t kRegionVersion = 1;
+
+constexpr size_t kRequestTail = 64;
+constexpr size_t kRequestHead = 128;
+constexpr size_t kRequestWaiting = 192;
+constexpr size_t kResponseTail = 256;
+constexpr size_t kResponseHead = 320;
+constexpr size_t kResponseWaiting = 384;
+constexpr size_t kDataOffset = 512;
+
+// Spinning covers the common case where the worker answers within a few
+// microseconds; only slower replies pay for a sleep on the eventfd.
+constexpr qint64 kSpinNs = 50000;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory counters must be lock-free to be shared across processes");
+
+std::atomic<uint64_t>* counterAt(unsigned char* region, size_t offset) {
+    return reinterpret_cast<std::atomic<uint64_t>*>(region + offset);
+}
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 4096;
+    while (result < value) result <<= 1;
+    return result;
+}
+}
+
+struct ShmTransport::Ring {
+    std::atomic<uint64_t>* tail;
+    std::atomic<uint64_t>* head;
+    std::atomic<uint64_t>* waiting;
+    unsigned char* data;
+};
+
+ShmTransport::ShmTransport(QObject* parent)
+    : QObject(parent), region(nullptr), regionSize(0), capacity(0),
+      requestEventFd(-1), responseEventFd(-1), notifier(nullptr) {}
+
+ShmTransport::~ShmTransport() {
+    close();
+}
+
+bool ShmTransport::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ShmTransport::create(size_t ringBytes) {
+#ifdef __linux__
+    static std::atomic<int> regionCounter{0};
+
+    close();
+
+    capacity = roundUpToPowerOfTwo(ringBytes);
+    regionSize = kDataOffset + 2 * capacity;
+    regionName = QString("/ml-bridge-%1-%2").arg(getpid()).arg(regionCounter++);
+
+    QByteArray name = regionName.toLocal8Bit();
+    int fd = shm_open(name.constData(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        qWarning() << "shm_open failed for" << regionName << ":" << strerror(errno);
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(regionSize)) != 0) {
+        qWarning() << "ftruncate failed for" << regionName << ":" << strerror(errno);
+        ::close(fd);
+        shm_unlink(name.constData());
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (mapped == MAP_FAILED) {
+        qWarning() << "mmap failed for" << regionName << ":" << strerror(errno);
+        shm_unlink(name.constData());
+        return false;
+    }
+
+    region = static_cast<unsigned char*>(mapped);
+
+    // No EFD_CLOEXEC: the worker inherits both descriptors across exec.
+    requestEventFd = eventfd(0, EFD_NONBLOCK);
+    responseEventFd = eventfd(0, EFD_NONBLOCK);
+    if (requestEventFd < 0 || responseEventFd < 0) {
+        qWarning() << "eventfd failed:" << strerror(errno);
+        close();
+        return false;
+    }
+
+    std::memcpy(region, &kRegionMagic, sizeof(kRegionMagic));
+    std::memcpy(region + 4, &kRegionVersion, sizeof(kRegionVersion));
+    uint64_t capacity64 = capacity;
+    std::memcpy(region + 8, &capacity64, sizeof(capacity64));
+
+    // The GUI thread consumes responses through a QSocketNotifier, so it
+    // always wants to be woken up.
+    counterAt(region, kResponseWaiting)->store(1, std::memory_order_seq_cst);
+
+    notifier = new QSocketNotifier(responseEventFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &ShmTransport::onResponseNotified);
+
+    return true;
+#else
+    Q_UNUSED(ringBytes);
+    return false;
+#endif
+}
+
+void ShmTransport::close() {
+#ifdef __linux__
+    delete notifier;
+    notifier = nullptr;
+
+    if (region) {
+        munmap(region, regionSize);
+        region = nullptr;
+    }
+
+    unlinkName();
+
+    if (requestEventFd >= 0) ::close(requestEventFd);
+    if (responseEventFd >= 0) ::close(responseEventFd);
+#endif
+    requestEventFd = -1;
+    responseEventFd = -1;
+    regionSize = 0;
+    capacity = 0;
+    inbox.clear();
+}
+
+bool ShmTransport::isOpen() const {
+    return region != nullptr;
+}
+
+void ShmTransport::exportTo(QProcessEnvironment& environment) const {
+    environment.insert("ML_SHM_NAME", regionName);
+    environment.insert("ML_SHM_REQUEST_FD", QString::number(requestEventFd));
+    environment.insert("ML_SHM_RESPONSE_FD", QString::number(responseEventFd));
+}
+
+void ShmTransport::unlinkName() {
+#ifdef __linux__
+    if (!regionName.isEmpty()) {
+        shm_unlink(regionName.toLocal8Bit().constData());
+        regionName.clear();
+    }
+#endif
+}
+
+ShmTransport::Ring ShmTransport::requestRing() const {
+    return {counterAt(region, kRequestTail), counterAt(region, kRequestHead),
+            counterAt(region, kRequestWaiting), region + kDataOffset};
+}
+
+ShmTransport::Ring ShmTransport::responseRing() const {
+    return {counterAt(region, kResponseTail), counterAt(region, kResponseHead),
+            counterAt(region, kResponseWaiting), region + kDataOffset + capacity};
+}
+
+bool ShmTransport::write(const QByteArray& data, int timeoutMs) {
+#ifdef __linux__
+    if (!region) return false;
+
+    Ring ring = requestRing();
+    const auto* source = reinterpret_cast<const unsigned char*>(data.constData());
+    const size_t size = static_cast<size_t>(data.size());
+    size_t written = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (written < size) {
+        uint64_t tail = ring.tail->load(std::memory_order_relaxed);
+        uint64_t head = ring.head->load(std::memory_order_acquire);
+        size_t available = capacity - static_cast<size_t>(tail - head);
+
+        if (available == 0) {
+            // The worker may itself be blocked on a full response ring.
+            drainResponses();
+            if (timer.elapsed() > timeoutMs) return false;
+            std::this_thread::yield();
+            continue;
+        }
+
+        size_t chunk = std::min(available, size - written);
+        size_t position = static_cast<size_t>(tail) & (capacity - 1);
+        size_t first = std::min(chunk, capacity - position);
+
+        std::memcpy(ring.data + position, source + written, first);
+        std::memcpy(ring.data, source + written + first, chunk - first);
+
+        ring.tail->store(tail + chunk, std::memory_order_release);
+        written += chunk;
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring.waiting->load(std::memory_order_relaxed) != 0) {
+            uint64_t one = 1;
+            if (::write(requestEventFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+                qWarning() << "Failed to signal shared-memory worker:" << strerror(errno);
+            }
+        }
+    }
+
+    return true;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(timeoutMs);
+    return false;
+#endif
+}
+
+size_t ShmTransport::drainResponses() {
+    if (!region) return 0;
+
+    Ring ring = responseRing();
+    uint64_t head = ring.head->load(std::memory_order_relaxed);
+    uint64_t tail = ring.tail->load(std::memory_order_acquire);
+    size_t count = static_cast<size_t>(tail - head);
+    if (count == 0) return 0;
+
+    size_t position = static_cast<size_t>(head) & (capacity - 1);
+    size_t first = std::min(count, capacity - position);
+
+    inbox.append(reinterpret_cast<const char*>(ring.data + position), static_cast<int>(first));
+    inbox.append(reinterpret_cast<const char*>(ring.data), static_cast<int>(count - first));
+
+    ring.head->store(tail, std::memory_order_release);
+    return count;
+}
+
+QByteArray ShmTransport::readAll() {
+    drainResponses();
+
+    QByteArray data;
+    data.swap(inbox);
+    return data;
+}
+
+void ShmTransport::onResponseNotified() {
+#ifdef __linux__
+    uint64_t counter = 0;
+    while (::read(responseEventFd, &counter, sizeof(counter)) == sizeof(counter)) {}
+#endif
+
+    drainResponses();
+    if (!inbox.isEmpty()) {
+        emit readyRead();
+    }
+}
+
+bool ShmTransport::waitForEvent(int fd, int timeoutMs) {
+#ifdef __linux__
+    pollfd descriptor{fd, POLLIN, 0};
+    if (poll(&descriptor, 1, timeoutMs) <= 0) return false;
+
+    uint64_t counter = 0;
+    while (::read(fd, &counter, sizeof(counter)) == sizeof(counter)) {}
+    return true;
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(timeoutMs);
+    return false;
+#endif
+}
+
+bool ShmTransport::waitForReadyRead(int timeoutMs) {
+    if (!region) return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (inbox.isEmpty() && drainResponses() == 0) {
+        qint64 elapsedNs = timer.nsecsElapsed();
+        if (elapsedNs < kSpinNs) continue;
+
+        qint64 remaining = timeoutMs - elapsedNs / 1000000;
+        if (remaining <= 0 || !waitForEvent(responseEventFd, static_cast<int>(remaining))) {
+            if (drainResponses() == 0 && inbox.isEmpty()) return false;
+        }
+    }
+
+    emit readyRead();
+    return true;
+}
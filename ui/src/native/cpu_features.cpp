@@ -0,0 +1,31 @@
+#include "cpu_features.h"
+
+namespace Native {
+
+namespace Cpu {
+
+Isa detect() {
+#ifdef ML_NATIVE_X86_KERNELS
+    static const Isa detected = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return Isa::Avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::Avx2;
+        return Isa::None;
+    }();
+    return detected;
+#else
+    return Isa::None;
+#endif
+}
+
+size_t lanes(Isa isa) {
+    switch (isa) {
+        case Isa::Avx512: return 16;
+        case Isa::Avx2: return 8;
+        default: return 1;
+    }
+}
+
+}
+
+}
@@ -0,0 +1,481 @@
+#include "hnsw_index.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Native {
+
+namespace {
+constexpr char kMagic[8] = {'M', 'L', 'H', 'N', 'S', 'W', '\0', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kSectionAlignment = 64;
+constexpr uint32_t kNoUpperLevels = std::numeric_limits<uint32_t>::max();
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t features;
+    uint64_t count;
+    uint32_t m;
+    uint32_t maxLevel;
+    uint32_t entryPoint;
+    uint32_t reserved;
+    uint64_t upperBlocks;
+    uint64_t vectorsOffset;
+    uint64_t labelsOffset;
+    uint64_t levelsOffset;
+    uint64_t baseLinksOffset;
+    uint64_t upperIndexOffset;
+    uint64_t upperLinksOffset;
+    uint64_t fileSize;
+};
+
+static_assert(sizeof(FileHeader) == 104, "the index header is read and written as raw bytes");
+
+uint64_t alignSection(uint64_t offset) {
+    return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+// Plain multiply-add: without -mfma, std::fma is a library call. Four
+// accumulators keep rows of a dozen features from waiting on one chain of
+// dependent additions.
+inline float squaredDistance(const float* a, const float* b, size_t features) {
+    float partial[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    size_t f = 0;
+    for (; f + 4 <= features; f += 4) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const float d = a[f + lane] - b[f + lane];
+            partial[lane] += d * d;
+        }
+    }
+    for (; f < features; ++f) {
+        const float d = a[f] - b[f];
+        partial[0] += d * d;
+    }
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+// Per-thread visited marks, cleared in O(1) by moving to a new tag.
+class VisitedSet {
+public:
+    void reset(size_t count) {
+        if (marks.size() < count) {
+            marks.assign(count, 0);
+            tag = 0;
+        }
+        if (++tag == 0) {
+            std::fill(marks.begin(), marks.end(), 0);
+            tag = 1;
+        }
+    }
+
+    // True the first time a node is offered since reset().
+    bool insert(uint32_t node) {
+        if (marks[node] == tag) return false;
+        marks[node] = tag;
+        return true;
+    }
+
+private:
+    std::vector<uint16_t> marks;
+    uint16_t tag = 0;
+};
+
+VisitedSet& visitedSet() {
+    thread_local VisitedSet visited;
+    return visited;
+}
+
+using Candidate = std::pair<float, uint32_t>;
+using NearestFirst = std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>>;
+using FarthestFirst = std::priority_queue<Candidate>;
+
+// The graph being built, with the same accessors as the mapped one so both
+// share the search routines below.
+struct BuildGraph {
+    const float* vectors;
+    size_t count;
+    size_t features;
+    size_t m;
+    std::vector<uint8_t> levels;
+    std::vector<uint32_t> baseLinks;
+    std::vector<std::vector<uint32_t>> upperLinks;
+
+    const float* row(uint32_t node) const { return vectors + static_cast<size_t>(node) * features; }
+
+    const uint32_t* links(uint32_t node, size_t level) const {
+        if (level == 0) return baseLinks.data() + static_cast<size_t>(node) * (1 + 2 * m);
+        return upperLinks[node].data() + (level - 1) * (1 + m);
+    }
+
+    uint32_t* links(uint32_t node, size_t level) {
+        return const_cast<uint32_t*>(static_cast<const BuildGraph*>(this)->links(node, level));
+    }
+
+    size_t capacity(size_t level) const { return level == 0 ? 2 * m : m; }
+};
+
+// Greedy walk to the single nearest node on one level.
+template <typename Graph>
+Candidate closestOnLevel(const Graph& graph, const float* query, Candidate current, size_t level) {
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        const uint32_t* links = graph.links(current.second, level);
+        for (uint32_t i = 1; i <= links[0]; ++i) {
+            const uint32_t neighbour = links[i];
+            if (neighbour >= graph.count) continue;
+            const float distance = squaredDistance(query, graph.row(neighbour), graph.features);
+            if (distance < current.first) {
+                current = {distance, neighbour};
+                improved = true;
+            }
+        }
+    }
+    return current;
+}
+
+// Beam search on one level keeping the ef nearest nodes found, returned
+// nearest first.
+template <typename Graph>
+std::vector<Candidate> searchLevel(const Graph& graph, const float* query, Candidate entry, size_t ef, size_t level) {
+    VisitedSet& visited = visitedSet();
+    visited.reset(graph.count);
+    visited.insert(entry.second);
+
+    NearestFirst candidates;
+    FarthestFirst results;
+    candidates.push(entry);
+    results.push(entry);
+
+    while (!candidates.empty()) {
+        const Candidate current = candidates.top();
+        if (current.first > results.top().first && results.size() >= ef) break;
+        candidates.pop();
+
+        const uint32_t* links = graph.links(current.second, level);
+        for (uint32_t i = 1; i <= links[0]; ++i) {
+            if (i < links[0] && links[i + 1] < graph.count) prefetch(graph.row(links[i + 1]));
+
+            const uint32_t neighbour = links[i];
+            if (neighbour >= graph.count || !visited.insert(neighbour)) continue;
+
+            const float distance = squaredDistance(query, graph.row(neighbour), graph.features);
+            if (results.size() < ef || distance < results.top().first) {
+                candidates.push({distance, neighbour});
+                results.push({distance, neighbour});
+                if (results.size() > ef) results.pop();
+            }
+        }
+    }
+
+    std::vector<Candidate> nearest(results.size());
+    for (size_t i = nearest.size(); i-- > 0;) {
+        nearest[i] = results.top();
+        results.pop();
+    }
+    return nearest;
+}
+
+// The neighbour selection heuristic of the paper: a candidate is kept only
+// if it is nearer to the base node than to every neighbour kept so far,
+// which spreads the links over different directions.
+std::vector<uint32_t> selectNeighbours(const BuildGraph& graph, const std::vector<Candidate>& nearestFirst,
+                                       size_t limit) {
+    std::vector<uint32_t> selected;
+    for (const Candidate& candidate : nearestFirst) {
+        if (selected.size() >= limit) break;
+
+        bool diverse = true;
+        for (uint32_t kept : selected) {
+            if (squaredDistance(graph.row(candidate.second), graph.row(kept), graph.features) < candidate.first) {
+                diverse = false;
+                break;
+            }
+        }
+        if (diverse) selected.push_back(candidate.second);
+    }
+    return selected;
+}
+
+void setLinks(uint32_t* links, const std::vector<uint32_t>& neighbours) {
+    links[0] = static_cast<uint32_t>(neighbours.size());
+    std::copy(neighbours.begin(), neighbours.end(), links + 1);
+}
+
+// Adds a back link from neighbour to node, re-running the heuristic over
+// the neighbour's links when it has no room left.
+void linkBack(BuildGraph& graph, uint32_t neighbour, uint32_t node, size_t level) {
+    uint32_t* links = graph.links(neighbour, level);
+    const size_t capacity = graph.capacity(level);
+
+    if (links[0] < capacity) {
+        links[++links[0]] = node;
+        return;
+    }
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(capacity + 1);
+    const float* base = graph.row(neighbour);
+    for (uint32_t i = 1; i <= links[0]; ++i) {
+        candidates.push_back({squaredDistance(base, graph.row(links[i]), graph.features), links[i]});
+    }
+    candidates.push_back({squaredDistance(base, graph.row(node), graph.features), node});
+    std::sort(candidates.begin(), candidates.end());
+
+    setLinks(links, selectNeighbours(graph, candidates, capacity));
+}
+
+template <typename T>
+void writeSection(std::ofstream& out, uint64_t offset, const T* values, size_t count) {
+    out.seekp(static_cast<std::streamoff>(offset));
+    out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+}
+}
+
+// Read-only view of a mapped index for the shared search routines.
+struct IndexGraph {
+    const HnswIndex& index;
+    size_t count;
+    size_t features;
+
+    explicit IndexGraph(const HnswIndex& mapped)
+        : index(mapped), count(mapped.count), features(mapped.features) {}
+
+    const float* row(uint32_t node) const { return index.vectors + static_cast<size_t>(node) * features; }
+
+    const uint32_t* links(uint32_t node, size_t level) const {
+        if (level == 0) return index.baseLinks + static_cast<size_t>(node) * (1 + 2 * index.m);
+        return index.upperLinks + (static_cast<size_t>(index.upperIndex[node]) + level - 1) * (1 + index.m);
+    }
+};
+
+void HnswIndex::build(const float* vectors, const uint8_t* labels, size_t count, size_t features,
+                      const BuildOptions& options, const std::string& path) {
+    if (count == 0 || features == 0) {
+        throw std::runtime_error("Cannot build an index over an empty cohort");
+    }
+    if (count >= kNoUpperLevels) {
+        throw std::runtime_error("Too many rows for an index");
+    }
+    if (options.m < 2) {
+        throw std::runtime_error("HNSW M must be at least 2");
+    }
+
+    BuildGraph graph{vectors, count, features, options.m, {}, {}, {}};
+    graph.levels.resize(count);
+    graph.baseLinks.assign(count * (1 + 2 * options.m), 0);
+    graph.upperLinks.resize(count);
+
+    // Level l holds a fraction M^-l of the rows.
+    std::mt19937_64 generator(options.seed);
+    std::uniform_real_distribution<double> uniform(std::numeric_limits<double>::min(), 1.0);
+    const double levelScale = 1.0 / std::log(static_cast<double>(options.m));
+
+    size_t maxLevel = 0;
+    uint32_t entryPoint = 0;
+
+    for (uint32_t node = 0; node < count; ++node) {
+        const size_t level = std::min<size_t>(static_cast<size_t>(-std::log(uniform(generator)) * levelScale), 255);
+        graph.levels[node] = static_cast<uint8_t>(level);
+        graph.upperLinks[node].assign(level * (1 + options.m), 0);
+
+        if (node == 0) {
+            maxLevel = level;
+            continue;
+        }
+
+        const float* query = graph.row(node);
+        Candidate entry{squaredDistance(query, graph.row(entryPoint), features), entryPoint};
+        for (size_t l = maxLevel; l > level; --l) {
+            entry = closestOnLevel(graph, query, entry, l);
+        }
+
+        for (size_t l = std::min(level, maxLevel) + 1; l-- > 0;) {
+            const std::vector<Candidate> nearest = searchLevel(graph, query, entry, options.efConstruction, l);
+            const std::vector<uint32_t> neighbours = selectNeighbours(graph, nearest, options.m);
+
+            setLinks(graph.links(node, l), neighbours);
+            for (uint32_t neighbour : neighbours) linkBack(graph, neighbour, node, l);
+            entry = nearest.front();
+        }
+
+        if (level > maxLevel) {
+            maxLevel = level;
+            entryPoint = node;
+        }
+    }
+
+    // Upper levels of all rows are packed into one block array.
+    std::vector<uint32_t> upperIndex(count, kNoUpperLevels);
+    std::vector<uint32_t> upperLinks;
+    for (uint32_t node = 0; node < count; ++node) {
+        if (graph.levels[node] == 0) continue;
+        upperIndex[node] = static_cast<uint32_t>(upperLinks.size() / (1 + options.m));
+        upperLinks.insert(upperLinks.end(), graph.upperLinks[node].begin(), graph.upperLinks[node].end());
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.features = static_cast<uint32_t>(features);
+    header.count = count;
+    header.m = static_cast<uint32_t>(options.m);
+    header.maxLevel = static_cast<uint32_t>(maxLevel);
+    header.entryPoint = entryPoint;
+    header.upperBlocks = upperLinks.size() / (1 + options.m);
+    header.vectorsOffset = alignSection(sizeof(FileHeader));
+    header.labelsOffset = alignSection(header.vectorsOffset + count * features * sizeof(float));
+    header.levelsOffset = alignSection(header.labelsOffset + count);
+    header.baseLinksOffset = alignSection(header.levelsOffset + count);
+    header.upperIndexOffset = alignSection(header.baseLinksOffset + graph.baseLinks.size() * sizeof(uint32_t));
+    header.upperLinksOffset = alignSection(header.upperIndexOffset + count * sizeof(uint32_t));
+    header.fileSize = header.upperLinksOffset + upperLinks.size() * sizeof(uint32_t);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not write " + path);
+    }
+
+    // Padding between sections is zero-filled by writing the last byte.
+    out.seekp(static_cast<std::streamoff>(header.fileSize - 1));
+    out.put('\0');
+    writeSection(out, 0, &header, 1);
+    writeSection(out, header.vectorsOffset, vectors, count * features);
+    writeSection(out, header.labelsOffset, labels, count);
+    writeSection(out, header.levelsOffset, graph.levels.data(), count);
+    writeSection(out, header.baseLinksOffset, graph.baseLinks.data(), graph.baseLinks.size());
+    writeSection(out, header.upperIndexOffset, upperIndex.data(), count);
+    writeSection(out, header.upperLinksOffset, upperLinks.data(), upperLinks.size());
+
+    if (!out.flush()) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+std::shared_ptr<const HnswIndex> HnswIndex::open(const std::string& path) {
+    std::shared_ptr<HnswIndex> index(new HnswIndex());
+    index->file = std::make_unique<MappedFile>(path);
+
+    const unsigned char* base = index->file->data();
+    FileHeader header{};
+    if (index->file->size() < sizeof(FileHeader)) {
+        throw std::runtime_error("Not a KNN index: " + path);
+    }
+    std::memcpy(&header, base, sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a KNN index: " + path);
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error("Unsupported KNN index version in " + path);
+    }
+
+    const uint64_t count = header.count;
+    const uint64_t baseLinks = count * (1 + 2 * static_cast<uint64_t>(header.m));
+    const uint64_t upperLinks = header.upperBlocks * (1 + static_cast<uint64_t>(header.m));
+    const bool consistent =
+        count > 0 && count < kNoUpperLevels && header.features > 0 && header.m >= 2 &&
+        header.entryPoint < count && header.fileSize == index->file->size() &&
+        header.vectorsOffset % kSectionAlignment == 0 &&
+        header.baseLinksOffset % kSectionAlignment == 0 &&
+        header.upperIndexOffset % kSectionAlignment == 0 &&
+        header.upperLinksOffset % kSectionAlignment == 0 &&
+        header.vectorsOffset >= sizeof(FileHeader) &&
+        header.vectorsOffset + count * header.features * sizeof(float) <= header.labelsOffset &&
+        header.labelsOffset + count <= header.levelsOffset &&
+        header.levelsOffset + count <= header.baseLinksOffset &&
+        header.baseLinksOffset + baseLinks * sizeof(uint32_t) <= header.upperIndexOffset &&
+        header.upperIndexOffset + count * sizeof(uint32_t) <= header.upperLinksOffset &&
+        header.upperLinksOffset + upperLinks * sizeof(uint32_t) <= header.fileSize;
+    if (!consistent) {
+        throw std::runtime_error("Corrupt KNN index: " + path);
+    }
+
+    index->count = static_cast<size_t>(count);
+    index->features = header.features;
+    index->m = header.m;
+    index->maxLevel = header.maxLevel;
+    index->entryPoint = header.entryPoint;
+    index->vectors = reinterpret_cast<const float*>(base + header.vectorsOffset);
+    index->rowLabels = base + header.labelsOffset;
+    index->rowLevels = base + header.levelsOffset;
+    index->baseLinks = reinterpret_cast<const uint32_t*>(base + header.baseLinksOffset);
+    index->upperIndex = reinterpret_cast<const uint32_t*>(base + header.upperIndexOffset);
+    index->upperLinks = reinterpret_cast<const uint32_t*>(base + header.upperLinksOffset);
+
+    if (index->rowLevels[index->entryPoint] != index->maxLevel) {
+        throw std::runtime_error("Corrupt KNN index: " + path);
+    }
+    return index;
+}
+
+size_t HnswIndex::size() const {
+    return count;
+}
+
+size_t HnswIndex::numFeatures() const {
+    return features;
+}
+
+size_t HnswIndex::levels() const {
+    return maxLevel + 1;
+}
+
+const uint8_t* HnswIndex::labels() const {
+    return rowLabels;
+}
+
+void HnswIndex::search(const float* query, size_t k, size_t ef, Neighbour* out) const {
+    const IndexGraph graph(*this);
+
+    Candidate entry{squaredDistance(query, graph.row(entryPoint), features), entryPoint};
+    for (size_t level = maxLevel; level > 0; --level) {
+        entry = closestOnLevel(graph, query, entry, level);
+    }
+
+    const std::vector<Candidate> nearest = searchLevel(graph, query, entry, std::max(ef, k), 0);
+    for (size_t i = 0; i < k; ++i) {
+        // Only a graph with fewer than k rows reachable runs out; the
+        // remaining slots repeat the farthest row found.
+        const Candidate& candidate = nearest[std::min(i, nearest.size() - 1)];
+        out[i] = {candidate.first, candidate.second};
+    }
+}
+
+void HnswIndex::searchExact(const float* query, size_t k, Neighbour* out) const {
+    // Max-heap of the k best; (distance, row) order keeps the earlier row
+    // on ties.
+    FarthestFirst best;
+    for (uint32_t row = 0; row < count; ++row) {
+        const float distance = squaredDistance(query, vectors + static_cast<size_t>(row) * features, features);
+        if (best.size() < k) {
+            best.push({distance, row});
+        } else if (distance < best.top().first) {
+            best.pop();
+            best.push({distance, row});
+        }
+    }
+
+    for (size_t i = best.size(); i-- > 0;) {
+        out[i] = {best.top().first, best.top().second};
+        best.pop();
+    }
+}
+
+}
@@ -0,0 +1,349 @@
+#include "knn_model.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "hnsw_index.h"
+#include "model_bundle.h"
+#include "thread_pool.h"
+
+#ifdef ML_NATIVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Native {
+
+namespace {
+constexpr size_t kRowBlock = 4;
+constexpr size_t kVectorLanes = 8;
+
+// Rows handed to a pool thread at a time, in whole query blocks. Each row
+// scans every reference, so small chunks are enough to amortize taking one
+// and let the threads finish together.
+constexpr size_t kRowsPerChunk = 16 * kRowBlock;
+
+// Adds a candidate to a query's k best, kept sorted nearest first. The
+// caller only offers candidates strictly nearer than the current k-th, and
+// they arrive in training order, so a candidate goes after any equal
+// distance and the earlier row stays ahead.
+inline void insert(KnnModel::Neighbour* best, size_t& size, size_t k, float distance, uint32_t index) {
+    size_t position = size < k ? size++ : k - 1;
+    while (position > 0 && best[position - 1].distance > distance) {
+        best[position] = best[position - 1];
+        --position;
+    }
+    best[position] = {distance, index};
+}
+
+inline float worstDistance(const KnnModel::Neighbour* best, size_t size, size_t k) {
+    return size < k ? std::numeric_limits<float>::infinity() : best[k - 1].distance;
+}
+
+void searchScalar(const float* x, size_t features, const float* matrix, size_t stride, size_t references,
+                  size_t k, KnnModel::Neighbour* best) {
+    size_t size = 0;
+    for (size_t reference = 0; reference < references; ++reference) {
+        float distance = 0.0f;
+        for (size_t f = 0; f < features; ++f) {
+            const float d = x[f] - matrix[f * stride + reference];
+            distance = std::fma(d, d, distance);
+        }
+        if (distance < worstDistance(best, size, k)) {
+            insert(best, size, k, distance, static_cast<uint32_t>(reference));
+        }
+    }
+}
+
+#ifdef ML_NATIVE_X86_KERNELS
+// Squared distances of Rows queries (row-major in x) to eight references
+// per step, so every reference column loaded is reused by all of them. A
+// vector compare against each query's current k-th distance picks the few
+// lanes that need inserting.
+template <size_t Rows>
+__attribute__((target("avx2,fma")))
+void searchAvx2(const float* x, size_t features, const float* matrix, size_t stride, size_t references,
+                size_t k, KnnModel::Neighbour* best) {
+    size_t sizes[Rows] = {};
+
+    for (size_t first = 0; first < stride; first += kVectorLanes) {
+        __m256 distance[Rows];
+        for (size_t row = 0; row < Rows; ++row) distance[row] = _mm256_setzero_ps();
+
+        for (size_t f = 0; f < features; ++f) {
+            const __m256 column = _mm256_load_ps(matrix + f * stride + first);
+            for (size_t row = 0; row < Rows; ++row) {
+                const __m256 d = _mm256_sub_ps(_mm256_set1_ps(x[row * features + f]), column);
+                distance[row] = _mm256_fmadd_ps(d, d, distance[row]);
+            }
+        }
+
+        // Padding columns past the last reference never take part.
+        const size_t remaining = references - first;
+        const int valid = remaining >= kVectorLanes ? 0xFF : (1 << remaining) - 1;
+
+        for (size_t row = 0; row < Rows; ++row) {
+            KnnModel::Neighbour* rowBest = best + row * k;
+            const __m256 worst = _mm256_set1_ps(worstDistance(rowBest, sizes[row], k));
+            int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance[row], worst, _CMP_LT_OQ)) & valid;
+            if (mask == 0) continue;
+
+            alignas(32) float lanes[kVectorLanes];
+            _mm256_store_ps(lanes, distance[row]);
+            while (mask != 0) {
+                const int lane = __builtin_ctz(static_cast<unsigned>(mask));
+                mask &= mask - 1;
+                if (lanes[lane] < worstDistance(rowBest, sizes[row], k)) {
+                    insert(rowBest, sizes[row], k, lanes[lane], static_cast<uint32_t>(first + lane));
+                }
+            }
+        }
+    }
+}
+#endif
+}
+
+std::unique_ptr<KnnModel> KnnModel::create(const nlohmann::json& artifact, size_t references) {
+    auto model = std::make_unique<KnnModel>();
+
+    model->features = artifact.at("num_features").get<size_t>();
+
+    const auto& classes = artifact.at("classes");
+    if (classes.size() != 2) {
+        throw std::runtime_error("Native KNN models support binary classifiers only");
+    }
+    model->classes[0] = classes[0].get<int>();
+    model->classes[1] = classes[1].get<int>();
+
+    const auto& section = artifact.at("knn");
+    const std::string weights = section.value("weights", "uniform");
+    if (weights == "uniform") {
+        model->weighting = Weighting::Uniform;
+    } else if (weights == "distance") {
+        model->weighting = Weighting::Distance;
+    } else {
+        throw std::runtime_error("Unsupported KNN weights in native model: " + weights);
+    }
+
+    model->references = references;
+    model->k = section.at("n_neighbors").get<size_t>();
+    if (model->references == 0) {
+        throw std::runtime_error("Malformed KNN references in native model");
+    }
+    if (model->k == 0 || model->k > model->references) {
+        throw std::runtime_error("KNN n_neighbors must be between 1 and the number of references");
+    }
+    if (model->references > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Too many KNN references in native model");
+    }
+
+    model->stride = (model->references + kVectorLanes - 1) / kVectorLanes * kVectorLanes;
+    model->isa = Cpu::detect();
+
+    return model;
+}
+
+std::unique_ptr<KnnModel> KnnModel::fromJson(const nlohmann::json& artifact) {
+    const auto& section = artifact.at("knn");
+    const auto& references = section.at("references");
+    const auto targets = section.at("targets").get<std::vector<int>>();
+    if (targets.size() != references.size()) {
+        throw std::runtime_error("Malformed KNN references in native model");
+    }
+
+    auto model = create(artifact, references.size());
+    model->ownedMatrix.resize(model->features * model->stride);
+    model->ownedTargets.resize(model->references);
+
+    for (size_t reference = 0; reference < model->references; ++reference) {
+        const auto values = references[reference].get<std::vector<double>>();
+        if (values.size() != model->features) {
+            throw std::runtime_error("KNN reference does not match the number of features");
+        }
+        for (size_t f = 0; f < model->features; ++f) {
+            model->ownedMatrix[f * model->stride + reference] = static_cast<float>(values[f]);
+        }
+        if (targets[reference] != 0 && targets[reference] != 1) {
+            throw std::runtime_error("KNN target is not a class index");
+        }
+        model->ownedTargets[reference] = static_cast<uint8_t>(targets[reference]);
+    }
+
+    model->matrix = model->ownedMatrix.data();
+    model->targets = model->ownedTargets.data();
+    model->scaler = Scaler::fromJson(artifact, model->features);
+
+    return model;
+}
+
+std::unique_ptr<KnnModel> KnnModel::fromBundle(const std::shared_ptr<const ModelBundle>& bundle) {
+    const nlohmann::json& artifact = bundle->metadata();
+    const auto references = bundle->array<float>("knn.references");
+    const auto targets = bundle->array<uint8_t>("knn.targets");
+
+    auto model = create(artifact, targets.size());
+    if (artifact.at("knn").at("reference_count").get<size_t>() != model->references ||
+        references.rows != model->features || references.columns != model->stride) {
+        throw std::runtime_error("Malformed KNN references in native model");
+    }
+    // Sections start on 64-byte boundaries of a page-aligned mapping; the
+    // AVX2 scan relies on it for aligned loads.
+    if (reinterpret_cast<uintptr_t>(references.data) % 32 != 0) {
+        throw std::runtime_error("KNN references in native model are not aligned");
+    }
+    for (size_t reference = 0; reference < model->references; ++reference) {
+        if (targets.data[reference] > 1) throw std::runtime_error("KNN target is not a class index");
+    }
+
+    model->matrix = references.data;
+    model->targets = targets.data;
+    model->scaler = Scaler::fromBundle(*bundle, model->features);
+    model->bundle = bundle;
+
+    return model;
+}
+
+std::string KnnModel::kind() const {
+    return "knn";
+}
+
+size_t KnnModel::numFeatures() const {
+    return features;
+}
+
+size_t KnnModel::numReferences() const {
+    return references;
+}
+
+size_t KnnModel::neighbours() const {
+    return k;
+}
+
+void KnnModel::setThreads(size_t newThreads) {
+    threads = newThreads;
+}
+
+void KnnModel::attachIndex(std::shared_ptr<const HnswIndex> newIndex) {
+    if (newIndex && newIndex->numFeatures() != features) {
+        throw std::runtime_error("KNN index does not match the number of features");
+    }
+    if (newIndex && newIndex->size() < k) {
+        throw std::runtime_error("KNN index has fewer rows than n_neighbors");
+    }
+    index = std::move(newIndex);
+}
+
+bool KnnModel::hasIndex() const {
+    return index != nullptr;
+}
+
+void KnnModel::setSearchBreadth(size_t newEf) {
+    ef = std::max(newEf, k);
+}
+
+size_t KnnModel::searchBreadth() const {
+    return std::max(ef, k);
+}
+
+void KnnModel::scaleRows(const float* rows, size_t count, float* scaled) const {
+    for (size_t row = 0; row < count; ++row) {
+        const float* input = rows + row * features;
+        for (size_t f = 0; f < features; ++f) {
+            scaled[row * features + f] = scaler.isIdentity()
+                ? input[f]
+                : static_cast<float>((input[f] - scaler.mean[f]) / scaler.scale[f]);
+        }
+    }
+}
+
+void KnnModel::search(const float* scaled, size_t count, Neighbour* nearest) const {
+    // Leftover rows run one at a time; every row's distances, and so its
+    // neighbours, are the same whatever block it lands in.
+#ifdef ML_NATIVE_X86_KERNELS
+    if (isa != Cpu::Isa::None) {
+        if (count == kRowBlock) {
+            searchAvx2<kRowBlock>(scaled, features, matrix, stride, references, k, nearest);
+        } else {
+            for (size_t row = 0; row < count; ++row) {
+                searchAvx2<1>(scaled + row * features, features, matrix, stride, references, k,
+                              nearest + row * k);
+            }
+        }
+        return;
+    }
+#endif
+    for (size_t row = 0; row < count; ++row) {
+        searchScalar(scaled + row * features, features, matrix, stride, references, k, nearest + row * k);
+    }
+}
+
+Prediction KnnModel::vote(const Neighbour* nearest, const uint8_t* labels) const {
+    double votes[2] = {0.0, 0.0};
+
+    if (weighting == Weighting::Distance) {
+        // Like sklearn, exact matches outvote everything else when present.
+        const bool exactMatch = nearest[0].distance == 0.0f;
+        for (size_t i = 0; i < k; ++i) {
+            const double weight = exactMatch
+                ? (nearest[i].distance == 0.0f ? 1.0 : 0.0)
+                : 1.0 / std::sqrt(static_cast<double>(nearest[i].distance));
+            votes[labels[nearest[i].index]] += weight;
+        }
+    } else {
+        for (size_t i = 0; i < k; ++i) votes[labels[nearest[i].index]] += 1.0;
+    }
+
+    // A tied vote goes to the first class, as with argmax in sklearn.
+    return {classes[votes[1] > votes[0] ? 1 : 0], votes[1] / (votes[0] + votes[1])};
+}
+
+void KnnModel::predictRange(const float* rows, size_t count, Prediction* out) const {
+    std::vector<float> scaled(kRowBlock * features);
+    std::vector<Neighbour> nearest(kRowBlock * k);
+
+    for (size_t first = 0; first < count; first += kRowBlock) {
+        const size_t block = std::min(kRowBlock, count - first);
+        scaleRows(rows + first * features, block, scaled.data());
+
+        if (index) {
+            for (size_t row = 0; row < block; ++row) {
+                index->search(scaled.data() + row * features, k, searchBreadth(), nearest.data() + row * k);
+            }
+        } else {
+            search(scaled.data(), block, nearest.data());
+        }
+
+        const uint8_t* labels = index ? index->labels() : targets;
+        for (size_t row = 0; row < block; ++row) {
+            out[first + row] = vote(nearest.data() + row * k, labels);
+        }
+    }
+}
+
+void KnnModel::predictBatch(const float* rows, size_t count, Prediction* out) const {
+    ThreadPool::shared().parallelFor(count, kRowsPerChunk, [&](size_t begin, size_t end) {
+        predictRange(rows + begin * features, end - begin, out + begin);
+    }, threads);
+}
+
+void KnnModel::kneighbours(const float* row, Neighbour* out) const {
+    std::vector<float> scaled(features);
+    scaleRows(row, 1, scaled.data());
+    if (index) {
+        index->search(scaled.data(), k, searchBreadth(), out);
+    } else {
+        search(scaled.data(), 1, out);
+    }
+}
+
+void KnnModel::exactNeighbours(const float* row, Neighbour* out) const {
+    std::vector<float> scaled(features);
+    scaleRows(row, 1, scaled.data());
+    if (index) {
+        index->searchExact(scaled.data(), k, out);
+    } else {
+        search(scaled.data(), 1, out);
+    }
+}
+
+}
@@ -0,0 +1,176 @@
+#include "linear_model.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "model_bundle.h"
+#include "scaler.h"
+#include "simd_math.h"
+
+namespace Native {
+
+namespace {
+constexpr size_t kBlockRows = 256;
+
+float sigmoidScalar(float score) {
+    return 1.0f / (1.0f + std::exp(-score));
+}
+
+// columns holds a block feature-major, stride floats per feature; stride
+// is a multiple of 8 so the vector kernel can read whole vectors past count.
+void scoreBlockScalar(const float* columns, size_t stride, size_t count, size_t features,
+                      const float* weights, float bias, float* scores, float* probabilities) {
+    for (size_t row = 0; row < count; ++row) {
+        float score = bias;
+        for (size_t f = 0; f < features; ++f) {
+            score = std::fma(columns[f * stride + row], weights[f], score);
+        }
+        scores[row] = score;
+        probabilities[row] = sigmoidScalar(score);
+    }
+}
+
+#ifdef ML_NATIVE_X86_KERNELS
+// One row with the same fma chain and exp as a lane of scoreBlockAvx2, so
+// predict() and predictBatch() agree bit for bit.
+__attribute__((target("avx2,fma")))
+float scoreRowAvx2(const float* row, size_t features, const float* weights, float bias, float& probability) {
+    float score = bias;
+    for (size_t f = 0; f < features; ++f) {
+        score = std::fma(row[f], weights[f], score);
+    }
+    probability = _mm256_cvtss_f32(SimdMath::sigmoid256(_mm256_set1_ps(score)));
+    return score;
+}
+
+__attribute__((target("avx2,fma")))
+void scoreBlockAvx2(const float* columns, size_t stride, size_t count, size_t features,
+                    const float* weights, float bias, float* scores, float* probabilities) {
+    for (size_t row = 0; row < count; row += 8) {
+        __m256 score = _mm256_set1_ps(bias);
+        for (size_t f = 0; f < features; ++f) {
+            score = _mm256_fmadd_ps(_mm256_loadu_ps(columns + f * stride + row), _mm256_set1_ps(weights[f]), score);
+        }
+        _mm256_storeu_ps(scores + row, score);
+        _mm256_storeu_ps(probabilities + row, SimdMath::sigmoid256(score));
+    }
+}
+#endif
+}
+
+std::unique_ptr<LinearModel> LinearModel::fromJson(const nlohmann::json& artifact) {
+    const auto& section = artifact.at("linear");
+    const auto coefficients = section.at("coefficients").get<std::vector<double>>();
+    const Scaler scaler = Scaler::fromJson(artifact, artifact.at("num_features").get<size_t>());
+
+    return create(artifact, coefficients.data(), coefficients.size(), section.at("intercept").get<double>(), scaler);
+}
+
+std::unique_ptr<LinearModel> LinearModel::fromBundle(const std::shared_ptr<const ModelBundle>& bundle) {
+    const nlohmann::json& artifact = bundle->metadata();
+    const auto coefficients = bundle->array<double>("linear.coefficients");
+    const Scaler scaler = Scaler::fromBundle(*bundle, artifact.at("num_features").get<size_t>());
+
+    return create(artifact, coefficients.data, coefficients.size(), artifact.at("linear").at("intercept").get<double>(),
+                  scaler);
+}
+
+std::unique_ptr<LinearModel> LinearModel::create(const nlohmann::json& artifact, const double* coefficients,
+                                                 size_t count, double intercept, const Scaler& scaler) {
+    auto model = std::make_unique<LinearModel>();
+
+    model->features = artifact.at("num_features").get<size_t>();
+
+    const auto& classes = artifact.at("classes");
+    if (classes.size() != 2) {
+        throw std::runtime_error("Native linear models support binary classifiers only");
+    }
+    model->classes[0] = classes[0].get<int>();
+    model->classes[1] = classes[1].get<int>();
+
+    if (count != model->features) {
+        throw std::runtime_error("Linear model coefficients do not match the number of features");
+    }
+
+    // w . (x - mean) / scale + b == (w / scale) . x + (b - w . mean / scale),
+    // folded in double before rounding to float32.
+    model->weights.resize(model->features);
+    for (size_t f = 0; f < model->features; ++f) {
+        double weight = coefficients[f];
+        if (!scaler.isIdentity()) {
+            weight /= scaler.scale[f];
+            intercept -= weight * scaler.mean[f];
+        }
+        model->weights[f] = static_cast<float>(weight);
+    }
+    model->bias = static_cast<float>(intercept);
+    model->isa = Cpu::detect();
+
+    return model;
+}
+
+std::string LinearModel::kind() const {
+    return "linear";
+}
+
+size_t LinearModel::numFeatures() const {
+    return features;
+}
+
+Prediction LinearModel::predict(const float* row) const {
+    float score = bias;
+    float probability;
+
+#ifdef ML_NATIVE_X86_KERNELS
+    if (isa != Cpu::Isa::None) {
+        score = scoreRowAvx2(row, features, weights.data(), bias, probability);
+    } else
+#endif
+    {
+        for (size_t f = 0; f < features; ++f) {
+            score = std::fma(row[f], weights[f], score);
+        }
+        probability = sigmoidScalar(score);
+    }
+
+    return {classes[score > 0.0f ? 1 : 0], probability};
+}
+
+void LinearModel::predictBatch(const float* rows, size_t count, Prediction* out) const {
+    const size_t blockRows = std::min(count, kBlockRows);
+    const size_t stride = (blockRows + 7) / 8 * 8;
+
+    std::vector<float> columns(features * stride, 0.0f);
+    std::vector<float> scores(stride);
+    std::vector<float> probabilities(stride);
+
+    for (size_t first = 0; first < count; first += blockRows) {
+        const size_t block = std::min(blockRows, count - first);
+        const float* x = rows + first * features;
+
+        for (size_t row = 0; row < block; ++row) {
+            for (size_t f = 0; f < features; ++f) {
+                columns[f * stride + row] = x[row * features + f];
+            }
+        }
+        // Slots past block in a short last block hold stale rows whose
+        // scores are never read.
+
+#ifdef ML_NATIVE_X86_KERNELS
+        if (isa != Cpu::Isa::None) {
+            scoreBlockAvx2(columns.data(), stride, block, features, weights.data(), bias,
+                           scores.data(), probabilities.data());
+        } else
+#endif
+        {
+            scoreBlockScalar(columns.data(), stride, block, features, weights.data(), bias,
+                             scores.data(), probabilities.data());
+        }
+
+        for (size_t row = 0; row < block; ++row) {
+            out[first + row] = {classes[scores[row] > 0.0f ? 1 : 0], probabilities[row]};
+        }
+    }
+}
+
+}
@@ -0,0 +1,218 @@
+#include "model_bundle.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace Native {
+
+namespace {
+constexpr char kMagic[8] = {'M', 'L', 'B', 'U', 'N', 'D', 'L', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kAlignment = 64;
+
+enum ElementType : uint32_t { Float32 = 1, Float64 = 2, Int32 = 3, UInt8 = 4, Text = 5 };
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t fileSize;
+    uint64_t directoryOffset;
+    uint32_t checksum;
+    uint32_t reserved;
+    unsigned char padding[24];
+};
+
+struct DirectoryEntry {
+    char name[32];
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t rows;
+    uint64_t columns;
+};
+
+static_assert(sizeof(FileHeader) == 64, "the bundle header is read as raw bytes");
+static_assert(sizeof(DirectoryEntry) == 64, "directory entries are read as raw bytes");
+
+size_t elementSize(uint32_t type) {
+    switch (type) {
+        case Float32: return sizeof(float);
+        case Float64: return sizeof(double);
+        case Int32: return sizeof(int32_t);
+        case UInt8:
+        case Text: return 1;
+        default: return 0;
+    }
+}
+
+template <typename T> constexpr uint32_t typeOf();
+template <> constexpr uint32_t typeOf<float>() { return Float32; }
+template <> constexpr uint32_t typeOf<double>() { return Float64; }
+template <> constexpr uint32_t typeOf<int32_t>() { return Int32; }
+template <> constexpr uint32_t typeOf<uint8_t>() { return UInt8; }
+
+// zlib's CRC32 (the one Python's zlib.crc32 computes), slicing by eight
+// bytes so that checking a large bundle stays well under its read time.
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+CrcTables makeCrcTables() {
+    CrcTables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (size_t slice = 1; slice < 8; ++slice) {
+            tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+uint32_t crc32(const unsigned char* data, size_t size) {
+    static const CrcTables tables = makeCrcTables();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    while (size >= 8) {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, data, 4);
+        std::memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^
+              tables[4][low >> 24] ^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+              tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) crc = (crc >> 8) ^ tables[0][(crc ^ *data++) & 0xFF];
+    return crc ^ 0xFFFFFFFFu;
+}
+}
+
+bool ModelBundle::isBundle(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+std::shared_ptr<const ModelBundle> ModelBundle::open(const std::string& path) {
+    std::shared_ptr<ModelBundle> bundle(new ModelBundle());
+    bundle->file = std::make_unique<MappedFile>(path);
+
+    const unsigned char* base = bundle->file->data();
+    const size_t size = bundle->file->size();
+
+    FileHeader header{};
+    if (size < sizeof(FileHeader)) {
+        throw std::runtime_error("Truncated native model bundle: " + path);
+    }
+    std::memcpy(&header, base, sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a native model bundle: " + path);
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error("Unsupported native model bundle version in " + path);
+    }
+    if (header.fileSize != size || header.directoryOffset < sizeof(FileHeader) ||
+        header.directoryOffset > size ||
+        header.sectionCount > (size - header.directoryOffset) / sizeof(DirectoryEntry)) {
+        throw std::runtime_error("Truncated native model bundle: " + path);
+    }
+    if (crc32(base + sizeof(FileHeader), size - sizeof(FileHeader)) != header.checksum) {
+        throw std::runtime_error("Checksum mismatch in native model bundle: " + path);
+    }
+
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        DirectoryEntry entry{};
+        std::memcpy(&entry, base + header.directoryOffset + i * sizeof(DirectoryEntry), sizeof(DirectoryEntry));
+
+        const size_t element = elementSize(entry.type);
+        const uint64_t elements = entry.rows * entry.columns;
+        const bool valid = element != 0 && entry.offset % kAlignment == 0 && entry.offset <= size &&
+                           (entry.columns == 0 || entry.rows <= UINT64_MAX / entry.columns) &&
+                           elements <= (size - entry.offset) / element;
+        if (!valid) {
+            throw std::runtime_error("Corrupt section in native model bundle: " + path);
+        }
+
+        const std::string name(entry.name, strnlen(entry.name, sizeof(entry.name)));
+        bundle->sections.push_back({name, entry.type, base + entry.offset, static_cast<size_t>(entry.rows),
+                                    static_cast<size_t>(entry.columns)});
+    }
+
+    const Section* metadata = bundle->find("metadata");
+    if (!metadata || metadata->type != Text) {
+        throw std::runtime_error("Native model bundle has no metadata: " + path);
+    }
+    const char* text = reinterpret_cast<const char*>(metadata->data);
+    bundle->meta = nlohmann::json::parse(text, text + metadata->rows * metadata->columns, nullptr, false);
+    if (!bundle->meta.is_object()) {
+        throw std::runtime_error("Malformed metadata in native model bundle: " + path);
+    }
+
+    return bundle;
+}
+
+std::shared_ptr<ModelBundle> ModelBundle::create() {
+    return std::shared_ptr<ModelBundle>(new ModelBundle());
+}
+
+const nlohmann::json& ModelBundle::metadata() const {
+    return meta;
+}
+
+void ModelBundle::setMetadata(nlohmann::json metadata) {
+    meta = std::move(metadata);
+}
+
+const ModelBundle::Section* ModelBundle::find(const std::string& name) const {
+    for (const Section& section : sections) {
+        if (section.name == name) return &section;
+    }
+    return nullptr;
+}
+
+bool ModelBundle::contains(const std::string& name) const {
+    return find(name) != nullptr;
+}
+
+template <typename T>
+ModelBundle::Array<T> ModelBundle::array(const std::string& name) const {
+    const Section* section = find(name);
+    if (!section) {
+        throw std::runtime_error("Native model bundle has no section " + name);
+    }
+    if (section->type != typeOf<T>()) {
+        throw std::runtime_error("Unexpected element type in bundle section " + name);
+    }
+    return {reinterpret_cast<const T*>(section->data), section->rows, section->columns};
+}
+
+template <typename T>
+T* ModelBundle::add(const std::string& name, size_t rows, size_t columns) {
+    if (find(name)) {
+        throw std::runtime_error("Duplicate bundle section " + name);
+    }
+
+    buffers.emplace_back(std::max<size_t>(rows * columns * sizeof(T), 1));
+    unsigned char* data = buffers.back().data();
+    sections.push_back({name, typeOf<T>(), data, rows, columns});
+    return reinterpret_cast<T*>(data);
+}
+
+template ModelBundle::Array<float> ModelBundle::array<float>(const std::string&) const;
+template ModelBundle::Array<double> ModelBundle::array<double>(const std::string&) const;
+template ModelBundle::Array<int32_t> ModelBundle::array<int32_t>(const std::string&) const;
+template ModelBundle::Array<uint8_t> ModelBundle::array<uint8_t>(const std::string&) const;
+template float* ModelBundle::add<float>(const std::string&, size_t, size_t);
+template double* ModelBundle::add<double>(const std::string&, size_t, size_t);
+template int32_t* ModelBundle::add<int32_t>(const std::string&, size_t, size_t);
+template uint8_t* ModelBundle::add<uint8_t>(const std::string&, size_t, size_t);
+
+}
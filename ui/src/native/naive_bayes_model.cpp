@@ -0,0 +1,229 @@
+#include "naive_bayes_model.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "model_bundle.h"
+#include "scaler.h"
+#include "simd_math.h"
+
+namespace Native {
+
+namespace {
+constexpr size_t kBlockRows = 256;
+constexpr double kTwoPi = 6.283185307179586476925286766559;
+
+float sigmoidScalar(float score) {
+    return 1.0f / (1.0f + std::exp(-score));
+}
+
+// Joint log likelihood of class 1 minus that of class 0 for one row. Each
+// class sums its own squared distances, which halves the chain of
+// dependent FMAs a single row waits on.
+inline float scoreRow(const float* row, size_t features, const float* parameters, float bias) {
+    float distance0 = 0.0f;
+    float distance1 = 0.0f;
+    for (size_t f = 0; f < features; ++f) {
+        const float* p = parameters + 4 * f;
+        const float d0 = row[f] - p[0];
+        const float d1 = row[f] - p[2];
+        distance0 = std::fma(p[1] * d0, d0, distance0);
+        distance1 = std::fma(p[3] * d1, d1, distance1);
+    }
+    return bias + (distance0 - distance1);
+}
+
+// columns holds a block feature-major, stride floats per feature; stride
+// is a multiple of 8 so the vector kernel can read whole vectors past count.
+void scoreBlockScalar(const float* columns, size_t stride, size_t count, size_t features,
+                      const float* parameters, float bias, float* scores, float* probabilities) {
+    std::vector<float> row(features);
+    for (size_t r = 0; r < count; ++r) {
+        for (size_t f = 0; f < features; ++f) row[f] = columns[f * stride + r];
+        scores[r] = scoreRow(row.data(), features, parameters, bias);
+        probabilities[r] = sigmoidScalar(scores[r]);
+    }
+}
+
+#ifdef ML_NATIVE_X86_KERNELS
+// One row with the same operations as a lane of scoreBlockAvx2, so
+// predict() and predictBatch() agree bit for bit.
+__attribute__((target("avx2,fma")))
+float scoreRowAvx2(const float* row, size_t features, const float* parameters, float bias, float& probability) {
+    const float score = scoreRow(row, features, parameters, bias);
+    probability = _mm256_cvtss_f32(SimdMath::sigmoid256(_mm256_set1_ps(score)));
+    return score;
+}
+
+__attribute__((target("avx2,fma")))
+void scoreBlockAvx2(const float* columns, size_t stride, size_t count, size_t features,
+                    const float* parameters, float bias, float* scores, float* probabilities) {
+    for (size_t row = 0; row < count; row += 8) {
+        __m256 distance0 = _mm256_setzero_ps();
+        __m256 distance1 = _mm256_setzero_ps();
+        for (size_t f = 0; f < features; ++f) {
+            const float* p = parameters + 4 * f;
+            const __m256 x = _mm256_loadu_ps(columns + f * stride + row);
+            const __m256 d0 = _mm256_sub_ps(x, _mm256_set1_ps(p[0]));
+            const __m256 d1 = _mm256_sub_ps(x, _mm256_set1_ps(p[2]));
+            distance0 = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_set1_ps(p[1]), d0), d0, distance0);
+            distance1 = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_set1_ps(p[3]), d1), d1, distance1);
+        }
+        const __m256 score = _mm256_add_ps(_mm256_set1_ps(bias), _mm256_sub_ps(distance0, distance1));
+        _mm256_storeu_ps(scores + row, score);
+        _mm256_storeu_ps(probabilities + row, SimdMath::sigmoid256(score));
+    }
+}
+#endif
+}
+
+std::unique_ptr<NaiveBayesModel> NaiveBayesModel::fromJson(const nlohmann::json& artifact) {
+    const size_t features = artifact.at("num_features").get<size_t>();
+    const auto& section = artifact.at("naive_bayes");
+    const auto means = section.at("theta").get<std::vector<std::vector<double>>>();
+    const auto variances = section.at("var").get<std::vector<std::vector<double>>>();
+    const auto priors = section.at("class_prior").get<std::vector<double>>();
+
+    if (means.size() != 2 || variances.size() != 2 || priors.size() != 2) {
+        throw std::runtime_error("Malformed naive Bayes parameters in native model");
+    }
+
+    std::vector<double> theta;
+    std::vector<double> var;
+    for (size_t c = 0; c < 2; ++c) {
+        if (means[c].size() != features || variances[c].size() != features) {
+            throw std::runtime_error("Naive Bayes parameters do not match the number of features");
+        }
+        theta.insert(theta.end(), means[c].begin(), means[c].end());
+        var.insert(var.end(), variances[c].begin(), variances[c].end());
+    }
+
+    return create(artifact, theta.data(), var.data(), priors.data(), Scaler::fromJson(artifact, features));
+}
+
+std::unique_ptr<NaiveBayesModel> NaiveBayesModel::fromBundle(const std::shared_ptr<const ModelBundle>& bundle) {
+    const nlohmann::json& artifact = bundle->metadata();
+    const size_t features = artifact.at("num_features").get<size_t>();
+    const auto theta = bundle->array<double>("naive_bayes.theta");
+    const auto var = bundle->array<double>("naive_bayes.var");
+    const auto priors = bundle->array<double>("naive_bayes.class_prior");
+
+    if (theta.rows != 2 || theta.columns != features || var.rows != 2 || var.columns != features ||
+        priors.size() != 2) {
+        throw std::runtime_error("Naive Bayes parameters do not match the number of features");
+    }
+
+    return create(artifact, theta.data, var.data, priors.data, Scaler::fromBundle(*bundle, features));
+}
+
+std::unique_ptr<NaiveBayesModel> NaiveBayesModel::create(const nlohmann::json& artifact, const double* means,
+                                                         const double* variances, const double* priors,
+                                                         const Scaler& scaler) {
+    auto model = std::make_unique<NaiveBayesModel>();
+
+    model->features = artifact.at("num_features").get<size_t>();
+
+    const auto& classes = artifact.at("classes");
+    if (classes.size() != 2) {
+        throw std::runtime_error("Native naive Bayes models support binary classifiers only");
+    }
+    model->classes[0] = classes[0].get<int>();
+    model->classes[1] = classes[1].get<int>();
+
+    // Trained on x' = (x - mean) / scale: (x' - theta)^2 / (2 var) equals
+    // (x - (mean + scale theta))^2 / (2 var scale^2), while the log
+    // normalizer keeps the variance the model was fitted with.
+    model->parameters.resize(4 * model->features);
+
+    double constants[2];
+    for (size_t c = 0; c < 2; ++c) {
+        if (priors[c] <= 0.0) {
+            throw std::runtime_error("Naive Bayes class prior must be positive");
+        }
+
+        constants[c] = std::log(priors[c]);
+        for (size_t f = 0; f < model->features; ++f) {
+            const double variance = variances[c * model->features + f];
+            if (!(variance > 0.0)) {
+                throw std::runtime_error("Naive Bayes variance must be positive");
+            }
+            constants[c] -= 0.5 * std::log(kTwoPi * variance);
+
+            double mean = means[c * model->features + f];
+            double inverse = 1.0 / (2.0 * variance);
+            if (!scaler.isIdentity()) {
+                mean = scaler.mean[f] + scaler.scale[f] * mean;
+                inverse /= scaler.scale[f] * scaler.scale[f];
+            }
+            model->parameters[4 * f + 2 * c] = static_cast<float>(mean);
+            model->parameters[4 * f + 2 * c + 1] = static_cast<float>(inverse);
+        }
+    }
+
+    model->bias = static_cast<float>(constants[1] - constants[0]);
+    model->isa = Cpu::detect();
+
+    return model;
+}
+
+std::string NaiveBayesModel::kind() const {
+    return "naive_bayes";
+}
+
+size_t NaiveBayesModel::numFeatures() const {
+    return features;
+}
+
+Prediction NaiveBayesModel::predict(const float* row) const {
+    float score;
+    float probability;
+
+#ifdef ML_NATIVE_X86_KERNELS
+    if (isa != Cpu::Isa::None) {
+        score = scoreRowAvx2(row, features, parameters.data(), bias, probability);
+    } else
+#endif
+    {
+        score = scoreRow(row, features, parameters.data(), bias);
+        probability = sigmoidScalar(score);
+    }
+
+    return {classes[score > 0.0f ? 1 : 0], probability};
+}
+
+void NaiveBayesModel::predictBatch(const float* rows, size_t count, Prediction* out) const {
+    const size_t blockRows = std::min(count, kBlockRows);
+    const size_t stride = (blockRows + 7) / 8 * 8;
+
+    std::vector<float> columns(features * stride, 0.0f);
+    std::vector<float> scores(stride);
+    std::vector<float> probabilities(stride);
+
+    for (size_t first = 0; first < count; first += blockRows) {
+        const size_t block = std::min(blockRows, count - first);
+        const float* x = rows + first * features;
+
+        for (size_t row = 0; row < block; ++row) {
+            for (size_t f = 0; f < features; ++f) {
+                columns[f * stride + row] = x[row * features + f];
+            }
+        }
+
+#ifdef ML_NATIVE_X86_KERNELS
+        if (isa != Cpu::Isa::None) {
+            scoreBlockAvx2(columns.data(), stride, block, features, parameters.data(), bias,
+                           scores.data(), probabilities.data());
+        } else
+#endif
+        {
+            scoreBlockScalar(columns.data(), stride, block, features, parameters.data(), bias,
+                             scores.data(), probabilities.data());
+        }
+
+        for (size_t row = 0; row < block; ++row) {
+            out[first + row] = {classes[scores[row] > 0.0f ? 1 : 0], probabilities[row]};
+        }
+    }
+}
+
+}
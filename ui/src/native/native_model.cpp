@@ -0,0 +1,106 @@
+#include "native_model.h"
+#include <fstream>
+#include <stdexcept>
+
+#include "knn_model.h"
+#include "linear_model.h"
+#include "model_bundle.h"
+#include "naive_bayes_model.h"
+#include "onnx_model.h"
+#include "svm_model.h"
+#include "thread_pool.h"
+#include "tree_ensemble.h"
+#include "json.hpp"
+
+namespace Native {
+
+namespace {
+constexpr const char* kFormat = "ml-native";
+constexpr int kVersion = 1;
+
+void checkFormat(const nlohmann::json& artifact, const std::string& path) {
+    if (!artifact.is_object() || artifact.value("format", "") != kFormat) {
+        throw std::runtime_error("Not a native model artifact: " + path);
+    }
+
+    if (artifact.value("version", 0) != kVersion) {
+        throw std::runtime_error("Unsupported native model version in " + path);
+    }
+}
+
+std::unique_ptr<Model> loadBundle(const std::string& path) {
+    const auto bundle = ModelBundle::open(path);
+    const nlohmann::json& artifact = bundle->metadata();
+    checkFormat(artifact, path);
+
+    const std::string type = artifact.value("model", "");
+    std::unique_ptr<Model> model;
+
+    if (type == "trees") {
+        model = TreeEnsemble::fromBundle(bundle);
+    } else if (type == "linear") {
+        model = LinearModel::fromBundle(bundle);
+    } else if (type == "svm") {
+        model = SvmModel::fromBundle(bundle);
+    } else if (type == "knn") {
+        model = KnnModel::fromBundle(bundle);
+    } else if (type == "naive_bayes") {
+        model = NaiveBayesModel::fromBundle(bundle);
+    } else {
+        throw std::runtime_error("Unsupported native model type: " + type);
+    }
+
+    model->setFeatureNames(artifact.value("features", std::vector<std::string>{}));
+    return model;
+}
+}
+
+std::unique_ptr<Model> loadModel(const std::string& path) {
+    if (ModelBundle::isBundle(path)) {
+        return loadBundle(path);
+    }
+
+    // ONNX files have no magic number to sniff.
+    const std::string onnxSuffix = ".onnx";
+    if (path.size() >= onnxSuffix.size() &&
+        path.compare(path.size() - onnxSuffix.size(), onnxSuffix.size(), onnxSuffix) == 0) {
+        return OnnxModel::load(path);
+    }
+
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Could not open native model: " + path);
+    }
+
+    nlohmann::json artifact = nlohmann::json::parse(file, nullptr, false);
+    checkFormat(artifact, path);
+
+    const std::string type = artifact.value("model", "");
+    std::unique_ptr<Model> model;
+
+    if (type == "trees") {
+        model = TreeEnsemble::fromJson(artifact);
+    } else if (type == "linear") {
+        model = LinearModel::fromJson(artifact);
+    } else if (type == "svm") {
+        model = SvmModel::fromJson(artifact);
+    } else if (type == "knn") {
+        model = KnnModel::fromJson(artifact);
+    } else if (type == "naive_bayes") {
+        model = NaiveBayesModel::fromJson(artifact);
+    } else {
+        throw std::runtime_error("Unsupported native model type: " + type);
+    }
+
+    model->setFeatureNames(artifact.value("features", std::vector<std::string>{}));
+    return model;
+}
+
+void predictParallel(const Model& model, const float* rows, size_t count, Prediction* out, size_t threads) {
+    const size_t columns = model.numFeatures();
+    ThreadPool::shared().parallelFor(count, kParallelBlockRows, [&](size_t begin, size_t end) {
+        model.predictBatch(rows + begin * columns, end - begin, out + begin);
+    }, threads);
+}
+
+}
@@ -0,0 +1,515 @@
+#include "onnx_graph.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+#include "mapped_file.h"
+
+namespace Native {
+
+namespace {
+enum WireType { Varint = 0, Fixed64 = 1, LengthDelimited = 2, Fixed32 = 5 };
+
+// Decodes one protobuf message. next() steps from field to field; the
+// accessors then read the current field's value, which must match its
+// wire type.
+class ProtoReader {
+public:
+    ProtoReader(const unsigned char* data, size_t size) : position(data), end(data + size) {}
+
+    bool next() {
+        if (position == end) return false;
+
+        const uint64_t tag = readVarint();
+        fieldNumber = static_cast<uint32_t>(tag >> 3);
+        wire = static_cast<int>(tag & 7);
+        if (fieldNumber == 0) fail();
+        return true;
+    }
+
+    uint32_t field() const { return fieldNumber; }
+
+    uint64_t varint() {
+        expect(Varint);
+        return readVarint();
+    }
+
+    int64_t int64() { return static_cast<int64_t>(varint()); }
+
+    float fixed32() {
+        expect(Fixed32);
+        return readFloat();
+    }
+
+    ProtoReader message() {
+        const auto [data, size] = bytes();
+        return ProtoReader(data, size);
+    }
+
+    std::string string() {
+        const auto [data, size] = bytes();
+        return std::string(reinterpret_cast<const char*>(data), size);
+    }
+
+    std::pair<const unsigned char*, size_t> bytes() {
+        expect(LengthDelimited);
+        const uint64_t size = readVarint();
+        if (size > static_cast<uint64_t>(end - position)) fail();
+
+        const unsigned char* data = position;
+        position += size;
+        return {data, static_cast<size_t>(size)};
+    }
+
+    // Repeated scalar fields may be packed (one length-delimited run) or
+    // not (one tag per element); writers are free to use either.
+    void appendVarints(std::vector<int64_t>& out) {
+        if (wire != LengthDelimited) {
+            out.push_back(int64());
+            return;
+        }
+        ProtoReader packed = message();
+        while (packed.position != packed.end) out.push_back(static_cast<int64_t>(packed.readVarint()));
+    }
+
+    void appendFloats(std::vector<float>& out) {
+        if (wire != LengthDelimited) {
+            out.push_back(fixed32());
+            return;
+        }
+        ProtoReader packed = message();
+        while (packed.position != packed.end) out.push_back(packed.readFloat());
+    }
+
+    void appendDoubles(std::vector<double>& out) {
+        if (wire != LengthDelimited) {
+            expect(Fixed64);
+            out.push_back(readDouble());
+            return;
+        }
+        ProtoReader packed = message();
+        while (packed.position != packed.end) out.push_back(packed.readDouble());
+    }
+
+    void skip() {
+        switch (wire) {
+        case Varint:
+            readVarint();
+            break;
+        case Fixed64:
+            advance(8);
+            break;
+        case LengthDelimited:
+            bytes();
+            break;
+        case Fixed32:
+            advance(4);
+            break;
+        default:
+            // Groups (wire types 3 and 4) are not used by ONNX.
+            fail();
+        }
+    }
+
+private:
+    [[noreturn]] static void fail() {
+        throw std::runtime_error("Malformed or truncated ONNX model");
+    }
+
+    void expect(int expected) const {
+        if (wire != expected) fail();
+    }
+
+    void advance(size_t count) {
+        if (count > static_cast<size_t>(end - position)) fail();
+        position += count;
+    }
+
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (position == end) fail();
+            const unsigned char byte = *position++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        fail();
+    }
+
+    float readFloat() {
+        const unsigned char* data = position;
+        advance(4);
+        float value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    double readDouble() {
+        const unsigned char* data = position;
+        advance(8);
+        double value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    const unsigned char* position;
+    const unsigned char* end;
+    uint32_t fieldNumber = 0;
+    int wire = 0;
+};
+
+template <typename T>
+void appendRaw(const unsigned char* data, size_t size, std::vector<double>& out) {
+    if (size % sizeof(T) != 0) {
+        throw std::runtime_error("Malformed raw_data in ONNX tensor");
+    }
+    for (size_t offset = 0; offset < size; offset += sizeof(T)) {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        out.push_back(static_cast<double>(value));
+    }
+}
+
+OnnxTensor readTensor(ProtoReader reader) {
+    OnnxTensor tensor;
+    std::vector<float> floats;
+    std::vector<int64_t> integers;
+    std::vector<double> doubles;
+    const unsigned char* raw = nullptr;
+    size_t rawSize = 0;
+    bool hasRaw = false;
+
+    while (reader.next()) {
+        switch (reader.field()) {
+        case 1:
+            reader.appendVarints(tensor.dims);
+            break;
+        case 2:
+            tensor.type = static_cast<OnnxType>(reader.int64());
+            break;
+        case 4:
+            reader.appendFloats(floats);
+            break;
+        case 5:    // int32_data, also used for bool, int8/16 and uint8/16
+        case 7:    // int64_data
+            reader.appendVarints(integers);
+            break;
+        case 8:
+            tensor.name = reader.string();
+            break;
+        case 9: {
+            const auto [data, size] = reader.bytes();
+            raw = data;
+            rawSize = size;
+            hasRaw = true;
+            break;
+        }
+        case 10:
+            reader.appendDoubles(doubles);
+            break;
+        case 14:
+            if (reader.int64() != 0) {
+                throw std::runtime_error("ONNX tensors stored as external data are not supported");
+            }
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if (hasRaw) {
+        switch (tensor.type) {
+        case OnnxType::Float:
+            appendRaw<float>(raw, rawSize, tensor.values);
+            break;
+        case OnnxType::Double:
+            appendRaw<double>(raw, rawSize, tensor.values);
+            break;
+        case OnnxType::Int64:
+            appendRaw<int64_t>(raw, rawSize, tensor.values);
+            break;
+        case OnnxType::Int32:
+            appendRaw<int32_t>(raw, rawSize, tensor.values);
+            break;
+        case OnnxType::Uint8:
+        case OnnxType::Bool:
+            appendRaw<uint8_t>(raw, rawSize, tensor.values);
+            break;
+        case OnnxType::Int8:
+            appendRaw<int8_t>(raw, rawSize, tensor.values);
+            break;
+        default:
+            throw std::runtime_error("Unsupported ONNX tensor type in " + tensor.name);
+        }
+    } else {
+        tensor.values.insert(tensor.values.end(), floats.begin(), floats.end());
+        tensor.values.insert(tensor.values.end(), doubles.begin(), doubles.end());
+        for (const int64_t value : integers) tensor.values.push_back(static_cast<double>(value));
+    }
+
+    return tensor;
+}
+
+OnnxAttribute readAttribute(ProtoReader reader) {
+    OnnxAttribute attribute;
+
+    while (reader.next()) {
+        switch (reader.field()) {
+        case 1:
+            attribute.name = reader.string();
+            break;
+        case 2:
+            attribute.number = reader.fixed32();
+            break;
+        case 3:
+            attribute.integer = reader.int64();
+            break;
+        case 4:
+            attribute.text = reader.string();
+            break;
+        case 5:
+            attribute.tensor = readTensor(reader.message());
+            break;
+        case 7:
+            reader.appendFloats(attribute.numbers);
+            break;
+        case 8:
+            reader.appendVarints(attribute.integers);
+            break;
+        case 9:
+            attribute.texts.push_back(reader.string());
+            break;
+        case 20:
+            attribute.type = static_cast<OnnxAttribute::Type>(reader.int64());
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    return attribute;
+}
+
+OnnxNode readNode(ProtoReader reader) {
+    OnnxNode node;
+
+    while (reader.next()) {
+        switch (reader.field()) {
+        case 1:
+            node.inputs.push_back(reader.string());
+            break;
+        case 2:
+            node.outputs.push_back(reader.string());
+            break;
+        case 3:
+            node.name = reader.string();
+            break;
+        case 4:
+            node.opType = reader.string();
+            break;
+        case 5:
+            node.attributes.push_back(readAttribute(reader.message()));
+            break;
+        case 7:
+            node.domain = reader.string();
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if (node.domain == "ai.onnx") node.domain.clear();
+    return node;
+}
+
+std::vector<int64_t> readShape(ProtoReader reader) {
+    std::vector<int64_t> shape;
+
+    while (reader.next()) {
+        if (reader.field() != 1) {
+            reader.skip();
+            continue;
+        }
+
+        int64_t size = -1;
+        ProtoReader dimension = reader.message();
+        while (dimension.next()) {
+            if (dimension.field() == 1) {
+                size = dimension.int64();
+            } else {
+                dimension.skip();
+            }
+        }
+        shape.push_back(size);
+    }
+
+    return shape;
+}
+
+OnnxValueInfo readValueInfo(ProtoReader reader) {
+    OnnxValueInfo info;
+
+    while (reader.next()) {
+        if (reader.field() == 1) {
+            info.name = reader.string();
+        } else if (reader.field() == 2) {
+            ProtoReader type = reader.message();
+            while (type.next()) {
+                if (type.field() == 1) {
+                    info.kind = OnnxValueInfo::Kind::Tensor;
+                    ProtoReader tensor = type.message();
+                    while (tensor.next()) {
+                        if (tensor.field() == 1) {
+                            info.type = static_cast<OnnxType>(tensor.int64());
+                        } else if (tensor.field() == 2) {
+                            info.shape = readShape(tensor.message());
+                        } else {
+                            tensor.skip();
+                        }
+                    }
+                } else if (type.field() == 4) {
+                    info.kind = OnnxValueInfo::Kind::Sequence;
+                    type.skip();
+                } else if (type.field() == 5) {
+                    info.kind = OnnxValueInfo::Kind::Map;
+                    type.skip();
+                } else {
+                    type.skip();
+                }
+            }
+        } else {
+            reader.skip();
+        }
+    }
+
+    return info;
+}
+
+void readGraph(ProtoReader reader, OnnxGraph& graph) {
+    while (reader.next()) {
+        switch (reader.field()) {
+        case 1:
+            graph.nodes.push_back(readNode(reader.message()));
+            break;
+        case 5:
+            graph.initializers.push_back(readTensor(reader.message()));
+            break;
+        case 11:
+            graph.inputs.push_back(readValueInfo(reader.message()));
+            break;
+        case 12:
+            graph.outputs.push_back(readValueInfo(reader.message()));
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    std::set<std::string> constants;
+    for (const OnnxTensor& tensor : graph.initializers) constants.insert(tensor.name);
+    graph.inputs.erase(std::remove_if(graph.inputs.begin(), graph.inputs.end(),
+                                      [&](const OnnxValueInfo& input) { return constants.count(input.name) > 0; }),
+                       graph.inputs.end());
+}
+
+const OnnxAttribute* typedAttribute(const OnnxNode& node, const std::string& name, OnnxAttribute::Type type) {
+    const OnnxAttribute* found = node.attribute(name);
+    if (found && found->type != type) {
+        throw std::runtime_error("Attribute " + name + " of " + node.opType + " has an unexpected type");
+    }
+    return found;
+}
+}
+
+const OnnxAttribute* OnnxNode::attribute(const std::string& attributeName) const {
+    for (const OnnxAttribute& candidate : attributes) {
+        if (candidate.name == attributeName) return &candidate;
+    }
+    return nullptr;
+}
+
+int64_t OnnxNode::integer(const std::string& attributeName, int64_t fallback) const {
+    const OnnxAttribute* found = typedAttribute(*this, attributeName, OnnxAttribute::Type::Int);
+    return found ? found->integer : fallback;
+}
+
+std::string OnnxNode::text(const std::string& attributeName, const std::string& fallback) const {
+    const OnnxAttribute* found = typedAttribute(*this, attributeName, OnnxAttribute::Type::String);
+    return found ? found->text : fallback;
+}
+
+std::vector<float> OnnxNode::numbers(const std::string& attributeName) const {
+    const OnnxAttribute* found = typedAttribute(*this, attributeName, OnnxAttribute::Type::Floats);
+    return found ? found->numbers : std::vector<float>{};
+}
+
+std::vector<int64_t> OnnxNode::integers(const std::string& attributeName) const {
+    const OnnxAttribute* found = typedAttribute(*this, attributeName, OnnxAttribute::Type::Ints);
+    return found ? found->integers : std::vector<int64_t>{};
+}
+
+std::vector<std::string> OnnxNode::texts(const std::string& attributeName) const {
+    const OnnxAttribute* found = typedAttribute(*this, attributeName, OnnxAttribute::Type::Strings);
+    return found ? found->texts : std::vector<std::string>{};
+}
+
+std::vector<double> OnnxNode::values(const std::string& attributeName) const {
+    if (const OnnxAttribute* tensor = typedAttribute(*this, attributeName + "_as_tensor", OnnxAttribute::Type::Tensor)) {
+        return tensor->tensor.values;
+    }
+
+    const std::vector<float> floats = numbers(attributeName);
+    return std::vector<double>(floats.begin(), floats.end());
+}
+
+OnnxGraph OnnxGraph::parse(const unsigned char* bytes, size_t size) {
+    OnnxGraph graph;
+    bool hasGraph = false;
+    ProtoReader reader(bytes, size);
+
+    while (reader.next()) {
+        switch (reader.field()) {
+        case 1:
+            graph.irVersion = reader.int64();
+            break;
+        case 2:
+            graph.producer = reader.string();
+            break;
+        case 7:
+            readGraph(reader.message(), graph);
+            hasGraph = true;
+            break;
+        case 8: {
+            std::string domain;
+            int64_t version = 0;
+            ProtoReader opset = reader.message();
+            while (opset.next()) {
+                if (opset.field() == 1) {
+                    domain = opset.string();
+                } else if (opset.field() == 2) {
+                    version = opset.int64();
+                } else {
+                    opset.skip();
+                }
+            }
+            graph.opsets[domain == "ai.onnx" ? "" : domain] = version;
+            break;
+        }
+        default:
+            reader.skip();
+        }
+    }
+
+    if (!hasGraph || graph.irVersion <= 0) {
+        throw std::runtime_error("Not an ONNX model");
+    }
+    return graph;
+}
+
+OnnxGraph OnnxGraph::load(const std::string& path) {
+    const MappedFile file(path);
+    return parse(file.data(), file.size());
+}
+
+}
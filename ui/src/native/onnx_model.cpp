@@ -0,0 +1,953 @@
+#include "onnx_model.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#include "onnx_graph.h"
+#include "svm_model.h"
+
+namespace Native {
+
+// A value flowing between operators: a row-major [rows, columns] block of
+// one element type. The graph input is a view of the caller's rows.
+struct OnnxModel::Tensor {
+    OnnxType type = OnnxType::Float;
+    size_t columns = 0;
+    const float* view = nullptr;
+    std::vector<float> floats;
+    std::vector<double> doubles;
+    std::vector<int64_t> integers;
+
+    const float* floatData() const { return view ? view : floats.data(); }
+};
+
+class OnnxModel::Operator {
+public:
+    // Element type and width of a value, known for every value at load.
+    struct Shape {
+        OnnxType type;
+        size_t columns;
+    };
+
+    virtual ~Operator() = default;
+    virtual std::string name() const = 0;
+    virtual void run(std::vector<Tensor>& values, size_t rows) const = 0;
+
+    std::vector<std::string> inputNames;    // resolved through aliases
+    std::vector<std::string> outputNames;
+    std::vector<Shape> outputShapes;
+    std::vector<size_t> inputs;             // slots, assigned once the graph is final
+    std::vector<size_t> outputs;
+};
+
+namespace {
+using Operator = OnnxModel::Operator;
+using Shape = OnnxModel::Operator::Shape;
+using Tensor = OnnxModel::Tensor;
+
+constexpr size_t kRowBlock = 256;
+constexpr const char* kMlDomain = "ai.onnx.ml";
+
+enum class PostTransform { None, Logistic, Softmax, SoftmaxZero };
+
+[[noreturn]] void malformed(const OnnxNode& node) {
+    throw std::runtime_error("Malformed " + node.opType + " node in ONNX model");
+}
+
+void requireFloat(const OnnxNode& node, const Shape& input) {
+    if (input.type != OnnxType::Float) {
+        throw std::runtime_error(node.opType + " expects a float input tensor");
+    }
+}
+
+PostTransform postTransform(const OnnxNode& node) {
+    const std::string transform = node.text("post_transform", "NONE");
+    if (transform == "NONE") return PostTransform::None;
+    if (transform == "LOGISTIC") return PostTransform::Logistic;
+    if (transform == "SOFTMAX") return PostTransform::Softmax;
+    if (transform == "SOFTMAX_ZERO") return PostTransform::SoftmaxZero;
+    throw std::runtime_error("Unsupported post_transform " + transform + " in " + node.opType);
+}
+
+float logistic(double x) {
+    return static_cast<float>(1.0 / (1.0 + std::exp(-x)));
+}
+
+// Writes the transformed scores of one row. SOFTMAX_ZERO leaves zero
+// scores at zero and normalizes the others.
+void transform(PostTransform kind, const double* scores, size_t count, float* out) {
+    switch (kind) {
+    case PostTransform::None:
+        for (size_t i = 0; i < count; ++i) out[i] = static_cast<float>(scores[i]);
+        break;
+    case PostTransform::Logistic:
+        for (size_t i = 0; i < count; ++i) out[i] = logistic(scores[i]);
+        break;
+    case PostTransform::Softmax:
+    case PostTransform::SoftmaxZero: {
+        const bool skipZeros = kind == PostTransform::SoftmaxZero;
+        double highest = -INFINITY;
+        for (size_t i = 0; i < count; ++i) {
+            if (!(skipZeros && scores[i] == 0.0)) highest = std::max(highest, scores[i]);
+        }
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!(skipZeros && scores[i] == 0.0)) sum += std::exp(scores[i] - highest);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = skipZeros && scores[i] == 0.0 ? 0.0f : static_cast<float>(std::exp(scores[i] - highest) / sum);
+        }
+        break;
+    }
+    }
+}
+
+// Class labels of a classifier; string labels cannot be reported through
+// Prediction and are rejected.
+std::vector<int64_t> classLabels(const OnnxNode& node, const std::string& attributeName) {
+    const std::string stringsName = attributeName.substr(0, attributeName.rfind('_')) + "_strings";
+    if (!node.texts(stringsName).empty()) {
+        throw std::runtime_error(node.opType + " with string class labels is not supported");
+    }
+    return node.integers(attributeName);
+}
+
+size_t argmax(const double* scores, size_t count) {
+    return static_cast<size_t>(std::max_element(scores, scores + count) - scores);
+}
+
+std::vector<float> broadcast(const OnnxNode& node, const std::vector<float>& values, size_t columns, float fallback) {
+    if (values.empty()) return std::vector<float>(columns, fallback);
+    if (values.size() == 1) return std::vector<float>(columns, values[0]);
+    if (values.size() != columns) malformed(node);
+    return values;
+}
+
+// Y = (X - offset) * scale.
+class ScalerOperator : public Operator {
+public:
+    ScalerOperator(const OnnxNode& node, const Shape& input) : columns(input.columns) {
+        requireFloat(node, input);
+        offset = broadcast(node, node.numbers("offset"), columns, 0.0f);
+        scale = broadcast(node, node.numbers("scale"), columns, 1.0f);
+        outputShapes = {{OnnxType::Float, columns}};
+    }
+
+    std::string name() const override { return "Scaler"; }
+
+    void run(std::vector<Tensor>& values, size_t rows) const override {
+        const float* x = values[inputs[0]].floatData();
+        Tensor& y = values[outputs[0]];
+        y.floats.resize(rows * columns);
+
+        for (size_t row = 0; row < rows; ++row) {
+            for (size_t f = 0; f < columns; ++f) {
+                y.floats[row * columns + f] = (x[row * columns + f] - offset[f]) * scale[f];
+            }
+        }
+    }
+
+    size_t columns;
+    std::vector<float> offset;
+    std::vector<float> scale;
+};
+
+// One row of coefficients per class. A single row with two labels is the
+// binary form: scores are [-s, s] and the label is positive when s > 0.
+class LinearOperator : public Operator {
+public:
+    LinearOperator(const OnnxNode& node, const Shape& input) : features(input.columns) {
+        requireFloat(node, input);
+
+        const std::vector<float> coefficients = node.numbers("coefficients");
+        if (coefficients.empty() || coefficients.size() % features != 0) malformed(node);
+        targets = coefficients.size() / features;
+        weights.assign(coefficients.begin(), coefficients.end());
+
+        const std::vector<float> intercepts = node.numbers("intercepts");
+        if (!intercepts.empty() && intercepts.size() != targets) malformed(node);
+        biases.assign(targets, 0.0);
+        std::copy(intercepts.begin(), intercepts.end(), biases.begin());
+
+        labels = classLabels(node, "classlabels_ints");
+        binary = targets == 1 && labels.size() == 2;
+        if (labels.empty()) {
+            for (size_t c = 0; c < (targets == 1 ? 2 : targets); ++c) labels.push_back(static_cast<int64_t>(c));
+            binary = targets == 1;
+        } else if (!binary && labels.size() != targets) {
+            malformed(node);
+        }
+
+        kind = postTransform(node);
+        outputShapes = {{OnnxType::Int64, 1}, {OnnxType::Float, binary ? 2 : targets}};
+    }
+
+    std::string name() const override { return fused ? "Scaler+LinearClassifier" : "LinearClassifier"; }
+
+    // Folds a Scaler that feeds only this operator into the coefficients:
+    // w . ((x - offset) * scale) + b = (w * scale) . x + (b - w . (offset * scale)).
+    void fold(const ScalerOperator& scaler) {
+        for (size_t c = 0; c < targets; ++c) {
+            double* row = weights.data() + c * features;
+            for (size_t f = 0; f < features; ++f) {
+                row[f] *= scaler.scale[f];
+                biases[c] -= row[f] * scaler.offset[f];
+            }
+        }
+        inputNames = scaler.inputNames;
+        fused = true;
+    }
+
+    void run(std::vector<Tensor>& values, size_t rows) const override {
+        const float* x = values[inputs[0]].floatData();
+        Tensor& label = values[outputs[0]];
+        Tensor& scores = values[outputs[1]];
+        const size_t columns = binary ? 2 : targets;
+        label.integers.resize(rows);
+        scores.floats.resize(rows * columns);
+
+        std::vector<double> raw(columns);
+        for (size_t row = 0; row < rows; ++row) {
+            const float* sample = x + row * features;
+            for (size_t c = 0; c < targets; ++c) {
+                const double* w = weights.data() + c * features;
+                double sum = biases[c];
+                for (size_t f = 0; f < features; ++f) sum += w[f] * sample[f];
+                raw[binary ? 1 : c] = sum;
+            }
+
+            if (binary) {
+                raw[0] = -raw[1];
+                label.integers[row] = labels[raw[1] > 0.0 ? 1 : 0];
+            } else {
+                label.integers[row] = labels[argmax(raw.data(), columns)];
+            }
+            transform(kind, raw.data(), columns, scores.floats.data() + row * columns);
+        }
+    }
+
+private:
+    size_t features;
+    size_t targets = 0;
+    std::vector<double> weights;   // targets x features
+    std::vector<double> biases;
+    std::vector<int64_t> labels;
+    PostTransform kind = PostTransform::None;
+    bool binary = false;
+    bool fused = false;
+};
+
+// Sums the leaf weights each row reaches in every tree, per class. When
+// only one class column carries weights in a binary model (the converter's
+// form for gradient boosting), that column is the positive class' score
+// and the other is derived from it, as ONNX Runtime does.
+class TreeOperator : public Operator {
+public:
+    TreeOperator(const OnnxNode& node, const Shape& input) {
+        requireFloat(node, input);
+
+        const std::vector<int64_t> treeIds = node.integers("nodes_treeids");
+        const std::vector<int64_t> nodeIds = node.integers("nodes_nodeids");
+        const std::vector<int64_t> featureIds = node.integers("nodes_featureids");
+        const std::vector<std::string> modes = node.texts("nodes_modes");
+        const std::vector<int64_t> trueIds = node.integers("nodes_truenodeids");
+        const std::vector<int64_t> falseIds = node.integers("nodes_falsenodeids");
+        const std::vector<int64_t> missingTrue = node.integers("nodes_missing_value_tracks_true");
+        const std::vector<double> thresholds = node.values("nodes_values");
+
+        const size_t count = treeIds.size();
+        if (count == 0 || nodeIds.size() != count || featureIds.size() != count || modes.size() != count ||
+            trueIds.size() != count || falseIds.size() != count || thresholds.size() != count ||
+            (!missingTrue.empty() && missingTrue.size() != count)) {
+            malformed(node);
+        }
+
+        labels = classLabels(node, "classlabels_int64s");
+        if (labels.size() < 2) malformed(node);
+        classes = labels.size();
+
+        std::map<std::pair<int64_t, int64_t>, uint32_t> index;
+        for (size_t i = 0; i < count; ++i) {
+            if (!index.emplace(std::make_pair(treeIds[i], nodeIds[i]), static_cast<uint32_t>(i)).second) {
+                malformed(node);
+            }
+        }
+
+        auto child = [&](int64_t tree, int64_t id) {
+            auto it = index.find({tree, id});
+            if (it == index.end()) malformed(node);
+            return it->second;
+        };
+
+        nodes.resize(count);
+        std::vector<bool> isChild(count, false);
+        for (size_t i = 0; i < count; ++i) {
+            Node& target = nodes[i];
+            target.mode = parseMode(node, modes[i]);
+            target.missingTrue = !missingTrue.empty() && missingTrue[i] != 0;
+            target.threshold = thresholds[i];
+            if (target.mode == Mode::Leaf) continue;
+
+            if (featureIds[i] < 0 || static_cast<size_t>(featureIds[i]) >= input.columns) malformed(node);
+            target.feature = static_cast<int32_t>(featureIds[i]);
+            target.trueChild = child(treeIds[i], trueIds[i]);
+            target.falseChild = child(treeIds[i], falseIds[i]);
+            isChild[target.trueChild] = true;
+            isChild[target.falseChild] = true;
+        }
+
+        // Weights are grouped by leaf so a leaf adds a contiguous run.
+        const std::vector<int64_t> weightTrees = node.integers("class_treeids");
+        const std::vector<int64_t> weightNodes = node.integers("class_nodeids");
+        const std::vector<int64_t> weightClasses = node.integers("class_ids");
+        const std::vector<double> weightValues = node.values("class_weights");
+        if (weightNodes.size() != weightTrees.size() || weightClasses.size() != weightTrees.size() ||
+            weightValues.size() != weightTrees.size()) {
+            malformed(node);
+        }
+
+        std::vector<std::vector<LeafWeight>> byLeaf(count);
+        std::set<int64_t> scored;
+        weightsPositive = true;
+        for (size_t i = 0; i < weightTrees.size(); ++i) {
+            const uint32_t leaf = child(weightTrees[i], weightNodes[i]);
+            if (nodes[leaf].mode != Mode::Leaf || weightClasses[i] < 0 ||
+                static_cast<size_t>(weightClasses[i]) >= classes) {
+                malformed(node);
+            }
+            byLeaf[leaf].push_back({static_cast<uint32_t>(weightClasses[i]), weightValues[i]});
+            scored.insert(weightClasses[i]);
+            weightsPositive = weightsPositive && weightValues[i] >= 0.0;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            nodes[i].weightBegin = static_cast<uint32_t>(weights.size());
+            weights.insert(weights.end(), byLeaf[i].begin(), byLeaf[i].end());
+            nodes[i].weightEnd = static_cast<uint32_t>(weights.size());
+        }
+
+        // A tree's root is its one node nobody branches to; walking from
+        // it must reach every node of the tree exactly once.
+        std::vector<bool> visited(count, false);
+        std::vector<uint32_t> pending;
+        for (size_t i = 0; i < count; ++i) {
+            if (isChild[i]) continue;
+            roots.push_back(static_cast<uint32_t>(i));
+            pending.push_back(static_cast<uint32_t>(i));
+            while (!pending.empty()) {
+                const uint32_t current = pending.back();
+                pending.pop_back();
+                if (visited[current]) malformed(node);
+                visited[current] = true;
+                if (nodes[current].mode != Mode::Leaf) {
+                    pending.push_back(nodes[current].trueChild);
+                    pending.push_back(nodes[current].falseChild);
+                }
+            }
+        }
+        if (std::find(visited.begin(), visited.end(), false) != visited.end()) malformed(node);
+
+        baseValues = node.values("base_values");
+        if (!baseValues.empty() && baseValues.size() != 1 && baseValues.size() != classes) malformed(node);
+
+        singleColumn = classes == 2 && scored.size() == 1;
+        kind = postTransform(node);
+        outputShapes = {{OnnxType::Int64, 1}, {OnnxType::Float, classes}};
+    }
+
+    std::string name() const override { return "TreeEnsembleClassifier"; }
+
+    void run(std::vector<Tensor>& values, size_t rows) const override {
+        const size_t columns = values[inputs[0]].columns;
+        const float* x = values[inputs[0]].floatData();
+        Tensor& label = values[outputs[0]];
+        Tensor& scores = values[outputs[1]];
+        label.integers.resize(rows);
+        scores.floats.resize(rows * classes);
+
+        // Tree by tree over the whole block, so each tree's nodes are
+        // fetched once per block rather than once per row.
+        std::vector<double> sums(rows * classes, 0.0);
+        for (const uint32_t root : roots) {
+            for (size_t row = 0; row < rows; ++row) {
+                const float* features = x + row * columns;
+                const Node* current = &nodes[root];
+                while (current->mode != Mode::Leaf) {
+                    const double value = features[current->feature];
+                    current = &nodes[branch(*current, value) ? current->trueChild : current->falseChild];
+                }
+
+                double* rowSums = sums.data() + row * classes;
+                for (uint32_t w = current->weightBegin; w < current->weightEnd; ++w) {
+                    rowSums[weights[w].target] += weights[w].value;
+                }
+            }
+        }
+
+        for (size_t row = 0; row < rows; ++row) {
+            double* rowSums = sums.data() + row * classes;
+            float* out = scores.floats.data() + row * classes;
+            if (singleColumn) {
+                finishSingleColumn(rowSums[0] + rowSums[1], label.integers[row], out);
+                continue;
+            }
+
+            if (baseValues.size() == classes) {
+                for (size_t c = 0; c < classes; ++c) rowSums[c] += baseValues[c];
+            }
+            label.integers[row] = labels[argmax(rowSums, classes)];
+            transform(kind, rowSums, classes, out);
+        }
+    }
+
+private:
+    enum class Mode : uint8_t { Leaf, Leq, Lt, Gte, Gt, Eq, Neq };
+
+    struct Node {
+        double threshold = 0.0;
+        uint32_t trueChild = 0;
+        uint32_t falseChild = 0;
+        uint32_t weightBegin = 0;
+        uint32_t weightEnd = 0;
+        int32_t feature = 0;
+        Mode mode = Mode::Leaf;
+        bool missingTrue = false;
+    };
+
+    struct LeafWeight {
+        uint32_t target;
+        double value;
+    };
+
+    static Mode parseMode(const OnnxNode& node, const std::string& mode) {
+        if (mode == "LEAF") return Mode::Leaf;
+        if (mode == "BRANCH_LEQ") return Mode::Leq;
+        if (mode == "BRANCH_LT") return Mode::Lt;
+        if (mode == "BRANCH_GTE") return Mode::Gte;
+        if (mode == "BRANCH_GT") return Mode::Gt;
+        if (mode == "BRANCH_EQ") return Mode::Eq;
+        if (mode == "BRANCH_NEQ") return Mode::Neq;
+        malformed(node);
+    }
+
+    static bool branch(const Node& node, double value) {
+        if (std::isnan(value)) return node.missingTrue;
+        switch (node.mode) {
+        case Mode::Leq: return value <= node.threshold;
+        case Mode::Lt: return value < node.threshold;
+        case Mode::Gte: return value >= node.threshold;
+        case Mode::Gt: return value > node.threshold;
+        case Mode::Eq: return value == node.threshold;
+        case Mode::Neq: return value != node.threshold;
+        case Mode::Leaf: break;
+        }
+        return false;
+    }
+
+    // Only one of the two columns is ever written, so their sum is its score.
+    void finishSingleColumn(double sum, int64_t& label, float* out) const {
+        double score = sum;
+        if (baseValues.size() == 2) {
+            score += baseValues[1];
+        } else if (baseValues.size() == 1) {
+            score += baseValues[0];
+        }
+
+        // As in ONNX Runtime: with no negative weight the score is the
+        // positive class's probability, otherwise a margin, whatever the
+        // post_transform. Only LOGISTIC is applied, to the margin pair;
+        // the softmaxes leave the pair as it is.
+        label = labels[score > (weightsPositive ? 0.5 : 0.0) ? 1 : 0];
+        if (kind == PostTransform::Logistic) {
+            out[0] = logistic(-score);
+            out[1] = logistic(score);
+            return;
+        }
+        out[0] = static_cast<float>(weightsPositive ? 1.0 - score : -score);
+        out[1] = static_cast<float>(score);
+    }
+
+    std::vector<Node> nodes;
+    std::vector<LeafWeight> weights;
+    std::vector<uint32_t> roots;
+    std::vector<int64_t> labels;
+    std::vector<double> baseValues;
+    size_t classes = 0;
+    PostTransform kind = PostTransform::None;
+    bool singleColumn = false;
+    bool weightsPositive = true;
+};
+
+// Binary SVC in libsvm's convention: a positive decision value means the
+// first class, and probabilities come from Platt scaling followed by
+// libsvm's pairwise coupling (see SvmModel::plattProbabilities).
+class SvmOperator : public Operator {
+public:
+    SvmOperator(const OnnxNode& node, const Shape& input) : features(input.columns) {
+        requireFloat(node, input);
+
+        const std::string kernelType = node.text("kernel_type", "LINEAR");
+        if (kernelType == "LINEAR") {
+            kernel = Kernel::Linear;
+        } else if (kernelType == "POLY") {
+            kernel = Kernel::Poly;
+        } else if (kernelType == "RBF") {
+            kernel = Kernel::Rbf;
+        } else if (kernelType == "SIGMOID") {
+            kernel = Kernel::Sigmoid;
+        } else {
+            malformed(node);
+        }
+
+        const std::vector<float> parameters = node.numbers("kernel_params");
+        if (!parameters.empty()) gamma = parameters[0];
+        if (parameters.size() > 1) coef0 = parameters[1];
+        if (parameters.size() > 2) degree = parameters[2];
+
+        labels = classLabels(node, "classlabels_ints");
+        if (labels.size() != 2) {
+            throw std::runtime_error("Only binary SVMClassifier models are supported");
+        }
+
+        const std::vector<int64_t> perClass = node.integers("vectors_per_class");
+        if (perClass.empty()) {
+            throw std::runtime_error("SVMClassifier without support vectors (a linear SVC) is not supported");
+        }
+        size_t total = 0;
+        for (const int64_t count : perClass) {
+            if (count < 0) malformed(node);
+            total += static_cast<size_t>(count);
+        }
+
+        const std::vector<float> supportVectors = node.numbers("support_vectors");
+        const std::vector<float> dualCoefficients = node.numbers("coefficients");
+        const std::vector<float> rho = node.numbers("rho");
+        if (perClass.size() != 2 || total == 0 || supportVectors.size() != total * features ||
+            dualCoefficients.size() != total || rho.size() != 1) {
+            malformed(node);
+        }
+        vectors.assign(supportVectors.begin(), supportVectors.end());
+        coefficients.assign(dualCoefficients.begin(), dualCoefficients.end());
+        intercept = rho[0];
+
+        const std::vector<float> probA = node.numbers("prob_a");
+        const std::vector<float> probB = node.numbers("prob_b");
+        if (probA.size() != probB.size() || probA.size() > 1) malformed(node);
+        platt = !probA.empty();
+        if (platt) {
+            a = probA[0];
+            b = probB[0];
+        }
+
+        kind = postTransform(node);
+        outputShapes = {{OnnxType::Int64, 1}, {OnnxType::Float, 2}};
+    }
+
+    std::string name() const override { return "SVMClassifier"; }
+
+    void run(std::vector<Tensor>& values, size_t rows) const override {
+        const float* x = values[inputs[0]].floatData();
+        Tensor& label = values[outputs[0]];
+        Tensor& scores = values[outputs[1]];
+        label.integers.resize(rows);
+        scores.floats.resize(rows * 2);
+
+        const size_t count = coefficients.size();
+        for (size_t row = 0; row < rows; ++row) {
+            const float* sample = x + row * features;
+            double decision = intercept;
+            for (size_t sv = 0; sv < count; ++sv) {
+                decision += coefficients[sv] * evaluate(sample, vectors.data() + sv * features);
+            }
+
+            label.integers[row] = labels[decision > 0.0 ? 0 : 1];
+            float* out = scores.floats.data() + row * 2;
+            if (platt) {
+                double p[2];
+                SvmModel::plattProbabilities(decision, a, b, p);
+                out[0] = static_cast<float>(p[0]);
+                out[1] = static_cast<float>(p[1]);
+            } else {
+                const double pair[2] = {decision, -decision};
+                transform(kind, pair, 2, out);
+            }
+        }
+    }
+
+private:
+    enum class Kernel { Linear, Poly, Rbf, Sigmoid };
+
+    double evaluate(const float* x, const double* vector) const {
+        if (kernel == Kernel::Rbf) {
+            double distance = 0.0;
+            for (size_t f = 0; f < features; ++f) {
+                const double d = x[f] - vector[f];
+                distance += d * d;
+            }
+            return std::exp(-gamma * distance);
+        }
+
+        double dot = 0.0;
+        for (size_t f = 0; f < features; ++f) dot += x[f] * vector[f];
+        switch (kernel) {
+        case Kernel::Poly: return std::pow(gamma * dot + coef0, degree);
+        case Kernel::Sigmoid: return std::tanh(gamma * dot + coef0);
+        default: return dot;
+        }
+    }
+
+    size_t features;
+    Kernel kernel = Kernel::Linear;
+    double gamma = 0.0;
+    double coef0 = 0.0;
+    double degree = 0.0;
+    std::vector<double> vectors;        // support vectors x features
+    std::vector<double> coefficients;
+    double intercept = 0.0;
+    bool platt = false;
+    double a = 0.0;
+    double b = 0.0;
+    std::vector<int64_t> labels;
+    PostTransform kind = PostTransform::None;
+};
+
+class NormalizerOperator : public Operator {
+public:
+    NormalizerOperator(const OnnxNode& node, const Shape& input) : columns(input.columns) {
+        requireFloat(node, input);
+
+        const std::string norm = node.text("norm", "MAX");
+        if (norm == "MAX") {
+            kind = Norm::Max;
+        } else if (norm == "L1") {
+            kind = Norm::L1;
+        } else if (norm == "L2") {
+            kind = Norm::L2;
+        } else {
+            malformed(node);
+        }
+        outputShapes = {{OnnxType::Float, columns}};
+    }
+
+    std::string name() const override { return "Normalizer"; }
+
+    void run(std::vector<Tensor>& values, size_t rows) const override {
+        const float* x = values[inputs[0]].floatData();
+        Tensor& y = values[outputs[0]];
+        y.floats.resize(rows * columns);
+
+        for (size_t row = 0; row < rows; ++row) {
+            const float* in = x + row * columns;
+            float* out = y.floats.data() + row * columns;
+
+            double norm = 0.0;
+            for (size_t c = 0; c < columns; ++c) {
+                if (kind == Norm::Max) {
+                    norm = c == 0 ? in[c] : std::max(norm, static_cast<double>(in[c]));
+                } else if (kind == Norm::L1) {
+                    norm += std::fabs(in[c]);
+                } else {
+                    norm += static_cast<double>(in[c]) * in[c];
+                }
+            }
+            if (kind == Norm::L2) norm = std::sqrt(norm);
+
+            for (size_t c = 0; c < columns; ++c) {
+                out[c] = norm == 0.0 ? in[c] : static_cast<float>(in[c] / norm);
+            }
+        }
+    }
+
+private:
+    enum class Norm { Max, L1, L2 };
+
+    size_t columns;
+    Norm kind = Norm::Max;
+};
+
+// Between float, double and int64; Casts that keep the type are removed
+// at load instead.
+class CastOperator : public Operator {
+public:
+    CastOperator(const Shape& input, OnnxType to) : from(input.type), columns(input.columns) {
+        outputShapes = {{to, columns}};
+    }
+
+    std::string name() const override { return "Cast"; }
+
+    void run(std::vector<Tensor>& values, size_t rows) const override {
+        const Tensor& x = values[inputs[0]];
+        Tensor& y = values[outputs[0]];
+        const size_t count = rows * columns;
+
+        switch (outputShapes[0].type) {
+        case OnnxType::Float:
+            y.floats.resize(count);
+            convert(x, count, y.floats.data());
+            break;
+        case OnnxType::Double:
+            y.doubles.resize(count);
+            convert(x, count, y.doubles.data());
+            break;
+        default:
+            y.integers.resize(count);
+            convert(x, count, y.integers.data());
+        }
+    }
+
+private:
+    template <typename T>
+    void convert(const Tensor& x, size_t count, T* out) const {
+        if (from == OnnxType::Float) {
+            const float* in = x.floatData();
+            for (size_t i = 0; i < count; ++i) out[i] = static_cast<T>(in[i]);
+        } else if (from == OnnxType::Double) {
+            for (size_t i = 0; i < count; ++i) out[i] = static_cast<T>(x.doubles[i]);
+        } else {
+            for (size_t i = 0; i < count; ++i) out[i] = static_cast<T>(x.integers[i]);
+        }
+    }
+
+    OnnxType from;
+    size_t columns;
+};
+
+bool isSupported(const OnnxNode& node) {
+    if (node.domain.empty()) return node.opType == "Identity" || node.opType == "Cast";
+    if (node.domain != kMlDomain) return false;
+
+    static const std::set<std::string> operators = {
+        "Scaler", "LinearClassifier", "TreeEnsembleClassifier", "SVMClassifier", "Normalizer", "ZipMap",
+    };
+    return operators.count(node.opType) > 0;
+}
+
+bool isCastable(OnnxType type) {
+    return type == OnnxType::Float || type == OnnxType::Double || type == OnnxType::Int64;
+}
+}
+
+OnnxModel::~OnnxModel() = default;
+
+std::unique_ptr<OnnxModel> OnnxModel::load(const std::string& path) {
+    return fromGraph(OnnxGraph::load(path));
+}
+
+std::unique_ptr<OnnxModel> OnnxModel::fromGraph(const OnnxGraph& graph) {
+    auto model = std::make_unique<OnnxModel>();
+
+    if (graph.inputs.size() != 1 || graph.inputs[0].kind != OnnxValueInfo::Kind::Tensor ||
+        graph.inputs[0].type != OnnxType::Float || graph.inputs[0].shape.size() != 2 ||
+        graph.inputs[0].shape[1] <= 0) {
+        throw std::runtime_error("ONNX model input must be a float tensor [N, features]");
+    }
+    model->features = static_cast<size_t>(graph.inputs[0].shape[1]);
+    const std::string inputName = graph.inputs[0].name;
+
+    // Every value's type and width, with Identity, ZipMap and no-op Casts
+    // resolved to the value they pass through.
+    std::map<std::string, Shape> shapes = {{inputName, {OnnxType::Float, model->features}}};
+    std::map<std::string, std::string> aliases;
+    auto resolve = [&](const std::string& name) {
+        auto it = aliases.find(name);
+        return it == aliases.end() ? name : it->second;
+    };
+
+    std::vector<std::unique_ptr<Operator>> operators;
+    for (size_t n = 0; n < graph.nodes.size(); ++n) {
+        const OnnxNode& node = graph.nodes[n];
+        const std::string qualified = node.domain.empty() ? node.opType : node.domain + "." + node.opType;
+        if (!isSupported(node)) {
+            throw std::runtime_error("Unsupported ONNX operator: " + qualified);
+        }
+
+        std::vector<std::string> inputs;
+        for (const std::string& input : node.inputs) {
+            if (input.empty()) continue;
+            const std::string resolved = resolve(input);
+            if (!shapes.count(resolved)) {
+                throw std::runtime_error("ONNX node " + qualified + " reads " + input +
+                                         ", which is not computed by a supported operator");
+            }
+            inputs.push_back(resolved);
+        }
+        if (inputs.size() != 1 || node.outputs.empty()) malformed(node);
+        const Shape& input = shapes.at(inputs[0]);
+
+        std::unique_ptr<Operator> op;
+        if (node.domain.empty()) {
+            OnnxType to = input.type;
+            if (node.opType == "Cast") {
+                to = static_cast<OnnxType>(node.integer("to", 0));
+                if (!isCastable(input.type) || !isCastable(to)) {
+                    throw std::runtime_error("Cast to or from this element type is not supported");
+                }
+            }
+            if (to == input.type) {
+                aliases[node.outputs[0]] = inputs[0];
+                continue;
+            }
+            op = std::make_unique<CastOperator>(input, to);
+        } else if (node.opType == "ZipMap") {
+            // Probabilities are read straight from the tensor it would turn
+            // into a sequence of maps.
+            const size_t labels = std::max(node.integers("classlabels_int64s").size(),
+                                           node.texts("classlabels_strings").size());
+            if (input.type != OnnxType::Float || labels != input.columns) malformed(node);
+            aliases[node.outputs[0]] = inputs[0];
+            continue;
+        } else if (node.opType == "Scaler") {
+            op = std::make_unique<ScalerOperator>(node, input);
+        } else if (node.opType == "LinearClassifier") {
+            op = std::make_unique<LinearOperator>(node, input);
+        } else if (node.opType == "TreeEnsembleClassifier") {
+            op = std::make_unique<TreeOperator>(node, input);
+        } else if (node.opType == "SVMClassifier") {
+            op = std::make_unique<SvmOperator>(node, input);
+        } else {
+            op = std::make_unique<NormalizerOperator>(node, input);
+        }
+
+        op->inputNames = inputs;
+        for (size_t i = 0; i < op->outputShapes.size(); ++i) {
+            // Outputs the graph leaves unnamed still get a slot.
+            std::string name = i < node.outputs.size() ? node.outputs[i] : std::string();
+            if (name.empty()) name = "#" + std::to_string(n) + "." + std::to_string(i);
+            if (shapes.count(name)) malformed(node);
+            shapes.emplace(name, op->outputShapes[i]);
+            op->outputNames.push_back(name);
+        }
+        operators.push_back(std::move(op));
+    }
+
+    // Probabilities are the first output computed from a classifier's
+    // scores (its second output), so scaled features exported alongside
+    // are not mistaken for them.
+    std::set<std::string> fromScores;
+    for (const auto& op : operators) {
+        if (op->outputNames.size() == 2) {
+            fromScores.insert(op->outputNames[1]);
+        } else if (fromScores.count(op->inputNames[0])) {
+            fromScores.insert(op->outputNames.begin(), op->outputNames.end());
+        }
+    }
+
+    std::string labelName;
+    std::string probabilityName;
+    for (const OnnxValueInfo& output : graph.outputs) {
+        const std::string name = resolve(output.name);
+        auto shape = shapes.find(name);
+        if (shape == shapes.end()) continue;
+
+        if (labelName.empty() && shape->second.type == OnnxType::Int64 && shape->second.columns == 1) {
+            labelName = name;
+        } else if (probabilityName.empty() && fromScores.count(name) && shape->second.columns >= 2 &&
+                   (shape->second.type == OnnxType::Float || shape->second.type == OnnxType::Double)) {
+            probabilityName = name;
+        }
+    }
+    if (labelName.empty() || probabilityName.empty()) {
+        throw std::runtime_error("ONNX model needs an int64 label output and a probability output");
+    }
+
+    // Only operators the two outputs depend on are kept.
+    std::map<std::string, size_t> consumers = {{labelName, 1}, {probabilityName, 1}};
+    std::vector<std::unique_ptr<Operator>> live;
+    for (auto it = operators.rbegin(); it != operators.rend(); ++it) {
+        const bool used = std::any_of((*it)->outputNames.begin(), (*it)->outputNames.end(),
+                                      [&](const std::string& name) { return consumers.count(name) > 0; });
+        if (!used) continue;
+
+        for (const std::string& input : (*it)->inputNames) ++consumers[input];
+        live.push_back(std::move(*it));
+    }
+    std::reverse(live.begin(), live.end());
+
+    // Scaler -> LinearClassifier becomes one operator when nothing else
+    // reads the scaled features.
+    std::map<std::string, ScalerOperator*> scalers;
+    for (const auto& op : live) {
+        if (auto* scaler = dynamic_cast<ScalerOperator*>(op.get())) {
+            scalers[scaler->outputNames[0]] = scaler;
+        }
+    }
+    std::set<const Operator*> folded;
+    for (const auto& op : live) {
+        auto* linear = dynamic_cast<LinearOperator*>(op.get());
+        if (!linear) continue;
+
+        auto scaler = scalers.find(linear->inputNames[0]);
+        if (scaler == scalers.end() || consumers[scaler->first] != 1) continue;
+
+        linear->fold(*scaler->second);
+        folded.insert(scaler->second);
+    }
+    live.erase(std::remove_if(live.begin(), live.end(),
+                              [&](const std::unique_ptr<Operator>& op) { return folded.count(op.get()) > 0; }),
+               live.end());
+
+    std::map<std::string, size_t> slots = {{inputName, 0}};
+    auto slot = [&](const std::string& name) {
+        return slots.emplace(name, slots.size()).first->second;
+    };
+    for (const auto& op : live) {
+        op->inputs.clear();
+        op->outputs.clear();
+        for (const std::string& name : op->inputNames) op->inputs.push_back(slot(name));
+        for (const std::string& name : op->outputNames) op->outputs.push_back(slot(name));
+    }
+
+    model->inputSlot = 0;
+    model->labelSlot = slot(labelName);
+    model->probabilitySlot = slot(probabilityName);
+    model->slotCount = slots.size();
+    model->steps = std::move(live);
+    return model;
+}
+
+std::string OnnxModel::kind() const {
+    return "onnx";
+}
+
+size_t OnnxModel::numFeatures() const {
+    return features;
+}
+
+std::vector<std::string> OnnxModel::operators() const {
+    std::vector<std::string> names;
+    for (const auto& step : steps) names.push_back(step->name());
+    return names;
+}
+
+void OnnxModel::predictBatch(const float* rows, size_t count, Prediction* out) const {
+    std::vector<Tensor> values(slotCount);
+    values[inputSlot].columns = features;
+
+    // Column counts are fixed per value; kernels only size the buffers.
+    for (const auto& step : steps) {
+        for (size_t i = 0; i < step->outputs.size(); ++i) {
+            values[step->outputs[i]].type = step->outputShapes[i].type;
+            values[step->outputs[i]].columns = step->outputShapes[i].columns;
+        }
+    }
+
+    for (size_t first = 0; first < count; first += kRowBlock) {
+        const size_t block = std::min(kRowBlock, count - first);
+        values[inputSlot].view = rows + first * features;
+
+        for (const auto& step : steps) step->run(values, block);
+
+        const Tensor& labels = values[labelSlot];
+        const Tensor& probabilities = values[probabilitySlot];
+        for (size_t row = 0; row < block; ++row) {
+            const size_t index = row * probabilities.columns + 1;
+            out[first + row].label = static_cast<int>(labels.integers[row]);
+            out[first + row].probability = probabilities.type == OnnxType::Double
+                ? probabilities.doubles[index]
+                : probabilities.floatData()[index];
+        }
+    }
+}
+
+}
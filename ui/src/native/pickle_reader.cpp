@@ -0,0 +1,712 @@
+#include "pickle_reader.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace Native {
+
+namespace {
+// Opcodes of protocols 2 to 5, from CPython's Lib/pickle.py.
+enum Opcode : unsigned char {
+    Mark = '(',
+    Stop = '.',
+    Pop = '0',
+    PopMark = '1',
+    Dup = '2',
+    BinInt = 'J',
+    BinInt1 = 'K',
+    BinInt2 = 'M',
+    None = 'N',
+    Reduce = 'R',
+    BinString = 'T',
+    ShortBinString = 'U',
+    BinUnicode = 'X',
+    Append = 'a',
+    Build = 'b',
+    GlobalOp = 'c',
+    DictOp = 'd',
+    EmptyDict = '}',
+    Appends = 'e',
+    BinGet = 'h',
+    LongBinGet = 'j',
+    ListOp = 'l',
+    EmptyList = ']',
+    BinPut = 'q',
+    LongBinPut = 'r',
+    SetItem = 's',
+    TupleOp = 't',
+    EmptyTuple = ')',
+    SetItems = 'u',
+    BinFloat = 'G',
+    Proto = 0x80,
+    NewObj = 0x81,
+    Tuple1 = 0x85,
+    Tuple2 = 0x86,
+    Tuple3 = 0x87,
+    NewTrue = 0x88,
+    NewFalse = 0x89,
+    Long1 = 0x8a,
+    Long4 = 0x8b,
+    BinBytes = 'B',
+    ShortBinBytes = 'C',
+    ShortBinUnicode = 0x8c,
+    BinUnicode8 = 0x8d,
+    BinBytes8 = 0x8e,
+    EmptySet = 0x8f,
+    AddItems = 0x90,
+    FrozenSet = 0x91,
+    NewObjEx = 0x92,
+    StackGlobal = 0x93,
+    Memoize = 0x94,
+    Frame = 0x95,
+    ByteArray8 = 0x96,
+};
+
+constexpr int kHighestProtocol = 5;
+
+PickleRef make(PickleValue::Type type) {
+    auto value = std::make_shared<PickleValue>();
+    value->type = type;
+    return value;
+}
+
+class Unpickler {
+public:
+    Unpickler(const unsigned char* bytes, size_t size) : position(bytes), end(bytes + size) {}
+
+    PickleRef run() {
+        for (;;) {
+            const unsigned char opcode = *take(1);
+            switch (opcode) {
+                case Proto:
+                    if (*take(1) > kHighestProtocol) throw std::runtime_error("Unsupported pickle protocol");
+                    break;
+                case Frame:
+                    // Frames only group opcodes for buffered reading.
+                    readUnsigned(8);
+                    break;
+                case Stop:
+                    return pop();
+                case Mark:
+                    marks.push_back(stack.size());
+                    break;
+                case Pop:
+                    pop();
+                    break;
+                case PopMark:
+                    popMark();
+                    break;
+                case Dup:
+                    push(top());
+                    break;
+
+                case None:
+                    push(make(PickleValue::Type::None));
+                    break;
+                case NewTrue:
+                case NewFalse: {
+                    auto value = make(PickleValue::Type::Bool);
+                    value->integer = opcode == NewTrue;
+                    push(value);
+                    break;
+                }
+                case BinInt:
+                    pushInt(static_cast<int32_t>(readUnsigned(4)));
+                    break;
+                case BinInt1:
+                    pushInt(static_cast<int64_t>(readUnsigned(1)));
+                    break;
+                case BinInt2:
+                    pushInt(static_cast<int64_t>(readUnsigned(2)));
+                    break;
+                case Long1:
+                    pushLong(readUnsigned(1));
+                    break;
+                case Long4:
+                    pushLong(readUnsigned(4));
+                    break;
+                case BinFloat: {
+                    // The one big-endian field in the format.
+                    const unsigned char* bytes = take(8);
+                    uint64_t bits = 0;
+                    for (int i = 0; i < 8; ++i) bits = (bits << 8) | bytes[i];
+                    auto value = make(PickleValue::Type::Float);
+                    std::memcpy(&value->number, &bits, sizeof(bits));
+                    push(value);
+                    break;
+                }
+
+                case ShortBinUnicode:
+                    pushString(PickleValue::Type::String, readUnsigned(1));
+                    break;
+                case BinUnicode:
+                    pushString(PickleValue::Type::String, readUnsigned(4));
+                    break;
+                case BinUnicode8:
+                    pushString(PickleValue::Type::String, readUnsigned(8));
+                    break;
+                case ShortBinString:
+                    pushString(PickleValue::Type::String, readUnsigned(1));
+                    break;
+                case BinString:
+                    pushString(PickleValue::Type::String, readUnsigned(4));
+                    break;
+                case ShortBinBytes:
+                    pushBytes(readUnsigned(1));
+                    break;
+                case BinBytes:
+                    pushBytes(readUnsigned(4));
+                    break;
+                case BinBytes8:
+                case ByteArray8:
+                    pushBytes(readUnsigned(8));
+                    break;
+
+                case EmptyTuple:
+                    push(make(PickleValue::Type::Tuple));
+                    break;
+                case Tuple1:
+                case Tuple2:
+                case Tuple3: {
+                    const size_t count = opcode - Tuple1 + 1;
+                    if (stack.size() < count) throw std::runtime_error("Pickle stack underflow");
+                    auto tuple = make(PickleValue::Type::Tuple);
+                    tuple->items.assign(stack.end() - count, stack.end());
+                    stack.resize(stack.size() - count);
+                    push(tuple);
+                    break;
+                }
+                case TupleOp: {
+                    auto tuple = make(PickleValue::Type::Tuple);
+                    tuple->items = popMark();
+                    push(tuple);
+                    break;
+                }
+
+                case EmptyList:
+                    push(make(PickleValue::Type::List));
+                    break;
+                case ListOp: {
+                    auto list = make(PickleValue::Type::List);
+                    list->items = popMark();
+                    push(list);
+                    break;
+                }
+                case Append: {
+                    PickleRef value = pop();
+                    top()->items.push_back(value);
+                    break;
+                }
+                case Appends: {
+                    std::vector<PickleRef> values = popMark();
+                    auto& items = top()->items;
+                    items.insert(items.end(), values.begin(), values.end());
+                    break;
+                }
+
+                case EmptyDict:
+                    push(make(PickleValue::Type::Dict));
+                    break;
+                case DictOp: {
+                    auto dict = make(PickleValue::Type::Dict);
+                    dict->items = popMark();
+                    push(dict);
+                    break;
+                }
+                case SetItem: {
+                    PickleRef value = pop();
+                    PickleRef key = pop();
+                    top()->items.push_back(key);
+                    top()->items.push_back(value);
+                    break;
+                }
+                case SetItems: {
+                    std::vector<PickleRef> pairs = popMark();
+                    if (pairs.size() % 2 != 0) throw std::runtime_error("Odd number of dict items in pickle");
+                    auto& items = top()->items;
+                    items.insert(items.end(), pairs.begin(), pairs.end());
+                    break;
+                }
+
+                case EmptySet:
+                    push(make(PickleValue::Type::Set));
+                    break;
+                case AddItems: {
+                    std::vector<PickleRef> values = popMark();
+                    auto& items = top()->items;
+                    items.insert(items.end(), values.begin(), values.end());
+                    break;
+                }
+                case FrozenSet: {
+                    auto set = make(PickleValue::Type::Set);
+                    set->items = popMark();
+                    push(set);
+                    break;
+                }
+
+                case GlobalOp: {
+                    const std::string module = readLine();
+                    pushGlobal(module, readLine());
+                    break;
+                }
+                case StackGlobal: {
+                    PickleRef name = pop();
+                    PickleRef module = pop();
+                    if (module->type != PickleValue::Type::String || name->type != PickleValue::Type::String) {
+                        throw std::runtime_error("Malformed global in pickle");
+                    }
+                    pushGlobal(module->text, name->text);
+                    break;
+                }
+                case Reduce:
+                case NewObj: {
+                    PickleRef arguments = pop();
+                    PickleRef callable = pop();
+                    pushObject(callable, arguments);
+                    break;
+                }
+                case NewObjEx: {
+                    pop();   // keyword arguments
+                    PickleRef arguments = pop();
+                    PickleRef callable = pop();
+                    pushObject(callable, arguments);
+                    break;
+                }
+                case Build: {
+                    PickleRef state = pop();
+                    if (top()->type != PickleValue::Type::Object) {
+                        throw std::runtime_error("BUILD on a value that is not an object in pickle");
+                    }
+                    // Through the memo a state can be the object itself, which
+                    // find() would then follow forever.
+                    const bool selfReferencing =
+                        state == top() || (state->type == PickleValue::Type::Tuple && !state->items.empty() &&
+                                           state->items[0] == top());
+                    if (selfReferencing) throw std::runtime_error("BUILD state refers to its own object in pickle");
+                    top()->state = state;
+                    break;
+                }
+
+                case Memoize:
+                    memo.push_back(top());
+                    break;
+                case BinPut:
+                    put(readUnsigned(1));
+                    break;
+                case LongBinPut:
+                    put(readUnsigned(4));
+                    break;
+                case BinGet:
+                    get(readUnsigned(1));
+                    break;
+                case LongBinGet:
+                    get(readUnsigned(4));
+                    break;
+
+                default:
+                    throw std::runtime_error("Unsupported pickle opcode " + std::to_string(opcode));
+            }
+        }
+    }
+
+private:
+    const unsigned char* take(size_t count) {
+        if (static_cast<size_t>(end - position) < count) throw std::runtime_error("Truncated pickle");
+        const unsigned char* start = position;
+        position += count;
+        return start;
+    }
+
+    uint64_t readUnsigned(size_t bytes) {
+        const unsigned char* data = take(bytes);
+        uint64_t value = 0;
+        for (size_t i = bytes; i-- > 0;) value = (value << 8) | data[i];
+        return value;
+    }
+
+    std::string readLine() {
+        const void* newline = std::memchr(position, '\n', static_cast<size_t>(end - position));
+        if (!newline) throw std::runtime_error("Truncated pickle");
+        const size_t length = static_cast<const unsigned char*>(newline) - position;
+        std::string line(reinterpret_cast<const char*>(take(length)), length);
+        take(1);
+        return line;
+    }
+
+    void push(PickleRef value) { stack.push_back(std::move(value)); }
+
+    PickleRef& top() {
+        if (stack.empty() || (!marks.empty() && marks.back() == stack.size())) {
+            throw std::runtime_error("Pickle stack underflow");
+        }
+        return stack.back();
+    }
+
+    PickleRef pop() {
+        PickleRef value = top();
+        stack.pop_back();
+        return value;
+    }
+
+    std::vector<PickleRef> popMark() {
+        if (marks.empty()) throw std::runtime_error("Pickle mark missing");
+        const size_t mark = marks.back();
+        marks.pop_back();
+        std::vector<PickleRef> values(stack.begin() + static_cast<std::ptrdiff_t>(mark), stack.end());
+        stack.resize(mark);
+        return values;
+    }
+
+    void pushInt(int64_t integer) {
+        auto value = make(PickleValue::Type::Int);
+        value->integer = integer;
+        push(value);
+    }
+
+    // Two's complement, little-endian, of any length; only values that fit
+    // 64 bits occur in the files read here.
+    void pushLong(uint64_t length) {
+        if (length > 8) throw std::runtime_error("Pickled integer does not fit 64 bits");
+        const unsigned char* data = take(length);
+        uint64_t bits = 0;
+        for (size_t i = length; i-- > 0;) bits = (bits << 8) | data[i];
+        if (length > 0 && length < 8 && (data[length - 1] & 0x80)) bits |= ~uint64_t{0} << (8 * length);
+        pushInt(static_cast<int64_t>(bits));
+    }
+
+    void pushString(PickleValue::Type type, uint64_t length) {
+        auto value = make(type);
+        value->text.assign(reinterpret_cast<const char*>(take(length)), length);
+        push(value);
+    }
+
+    void pushBytes(uint64_t length) {
+        auto value = make(PickleValue::Type::Bytes);
+        value->data = take(length);
+        value->size = length;
+        push(value);
+    }
+
+    void pushGlobal(const std::string& module, const std::string& name) {
+        auto value = make(PickleValue::Type::Global);
+        value->text = module + "." + name;
+        push(value);
+    }
+
+    void pushObject(PickleRef callable, PickleRef arguments) {
+        if (callable->type != PickleValue::Type::Global) {
+            throw std::runtime_error("Pickle calls something that is not a global");
+        }
+
+        // Protocol 2 writes bytes as _codecs.encode(latin-1 text, "latin1").
+        if (callable->text == "_codecs.encode" && arguments->items.size() == 2 &&
+            arguments->items[0]->type == PickleValue::Type::String) {
+            push(latin1Bytes(arguments->items[0]->text));
+            return;
+        }
+
+        auto object = make(PickleValue::Type::Object);
+        object->callable = std::move(callable);
+        object->arguments = std::move(arguments);
+        push(object);
+    }
+
+    // Decodes the UTF-8 text of a latin-1 string back to its bytes, kept
+    // alive in owned.
+    PickleRef latin1Bytes(const std::string& text) {
+        std::string bytes;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const auto c = static_cast<unsigned char>(text[i]);
+            if (c < 0x80) {
+                bytes.push_back(static_cast<char>(c));
+            } else if ((c & 0xE0) == 0xC0 && i + 1 < text.size()) {
+                bytes.push_back(static_cast<char>(((c & 0x1F) << 6) | (text[++i] & 0x3F)));
+            } else {
+                throw std::runtime_error("Malformed latin-1 bytes in pickle");
+            }
+        }
+
+        auto value = make(PickleValue::Type::Bytes);
+        value->text = std::move(bytes);
+        value->data = reinterpret_cast<const unsigned char*>(value->text.data());
+        value->size = value->text.size();
+        return value;
+    }
+
+    void put(uint64_t index) {
+        if (index >= memo.size()) memo.resize(index + 1);
+        memo[index] = top();
+    }
+
+    void get(uint64_t index) {
+        if (index >= memo.size() || !memo[index]) throw std::runtime_error("Pickle memo entry missing");
+        push(memo[index]);
+    }
+
+    const unsigned char* position;
+    const unsigned char* end;
+    std::vector<PickleRef> stack;
+    std::vector<size_t> marks;
+    std::vector<PickleRef> memo;
+};
+
+bool isNumpyGlobal(const PickleValue& value, const char* name) {
+    if (value.type != PickleValue::Type::Object || value.className() != name) return false;
+    // numpy.core before numpy 2, numpy._core since.
+    return value.callable->text.compare(0, 6, "numpy.") == 0;
+}
+
+// Parses a numpy.dtype(...) object: its type string, and byte order and
+// fields from the BUILD state.
+void readDtype(const PickleValue& dtype, NumpyArray& array) {
+    if (!isNumpyGlobal(dtype, "dtype") || dtype.arguments->items.empty() ||
+        dtype.arguments->items[0]->type != PickleValue::Type::String) {
+        throw std::runtime_error("Malformed numpy dtype in pickle");
+    }
+
+    const std::string& code = dtype.arguments->items[0]->text;
+    array.kind = code.empty() ? 0 : code[0];
+    array.itemSize = code.size() > 1 ? std::stoul(code.substr(1)) : 0;
+
+    if (dtype.state && dtype.state->type == PickleValue::Type::Tuple && dtype.state->items.size() >= 6) {
+        const auto& state = dtype.state->items;
+        if (state[1]->text == ">" && array.itemSize > 1) {
+            throw std::runtime_error("Big-endian numpy arrays are not supported");
+        }
+        if (state[5]->type == PickleValue::Type::Int && state[5]->integer > 0) {
+            array.itemSize = static_cast<size_t>(state[5]->integer);
+        }
+
+        if (array.kind == 'V' && state[3]->type == PickleValue::Type::Tuple) {
+            for (const auto& name : state[3]->items) {
+                const PickleValue& entry = state[4]->at(name->text);
+                NumpyArray field;
+                readDtype(entry.item(0), field);
+                if (field.kind == 'V' || field.kind == 'O') {
+                    throw std::runtime_error("Nested numpy record fields are not supported");
+                }
+                array.fields.push_back({name->text, field.kind, field.itemSize,
+                                        static_cast<size_t>(pickleNumber(entry.item(1)))});
+            }
+        }
+    }
+
+    const bool numeric = (array.kind == 'f' && (array.itemSize == 4 || array.itemSize == 8)) ||
+                         ((array.kind == 'i' || array.kind == 'u') &&
+                          (array.itemSize == 1 || array.itemSize == 2 || array.itemSize == 4 ||
+                           array.itemSize == 8)) ||
+                         (array.kind == 'b' && array.itemSize == 1);
+    if (!numeric && array.kind != 'O' && array.kind != 'V') {
+        throw std::runtime_error("Unsupported numpy dtype in pickle: " + code);
+    }
+}
+
+double readElement(char kind, size_t itemSize, const unsigned char* data) {
+    switch (kind) {
+        case 'f':
+            if (itemSize == 4) {
+                float value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            } else {
+                double value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+        case 'i': {
+            uint64_t bits = 0;
+            std::memcpy(&bits, data, itemSize);
+            if (itemSize < 8 && (bits >> (8 * itemSize - 1)) & 1) bits |= ~uint64_t{0} << (8 * itemSize);
+            return static_cast<double>(static_cast<int64_t>(bits));
+        }
+        case 'u':
+        case 'b': {
+            uint64_t bits = 0;
+            std::memcpy(&bits, data, itemSize);
+            return static_cast<double>(bits);
+        }
+        default:
+            throw std::runtime_error("numpy array is not numeric");
+    }
+}
+
+std::vector<size_t> readShape(const PickleValue& shape) {
+    std::vector<size_t> result;
+    for (const auto& dimension : shape.items) result.push_back(static_cast<size_t>(pickleNumber(*dimension)));
+    return result;
+}
+
+void attachData(const PickleValue& data, NumpyArray& array) {
+    // A crafted shape must not wrap the element count, or the size checks
+    // below would pass for data far shorter than the array.
+    size_t count = 1;
+    for (size_t dimension : array.shape) {
+        if (dimension != 0 && count > SIZE_MAX / dimension) {
+            throw std::runtime_error("numpy array shape is too large in pickle");
+        }
+        count *= dimension;
+    }
+
+    if (array.kind == 'O') {
+        if (data.type != PickleValue::Type::List || data.items.size() != count) {
+            throw std::runtime_error("Malformed numpy object array in pickle");
+        }
+        array.objects = data.items;
+        return;
+    }
+
+    if (data.type != PickleValue::Type::Bytes || array.itemSize == 0 || count > data.size / array.itemSize) {
+        throw std::runtime_error("Malformed numpy array data in pickle");
+    }
+    array.data = data.data;
+}
+}
+
+std::string PickleValue::className() const {
+    if (type != Type::Object || !callable) return "";
+    const size_t dot = callable->text.rfind('.');
+    return dot == std::string::npos ? callable->text : callable->text.substr(dot + 1);
+}
+
+const PickleValue* PickleValue::find(const std::string& key) const {
+    if (type == Type::Object) {
+        const PickleValue* attributes = state.get();
+        // A (dict, slots) pair when the class also has __slots__.
+        if (attributes && attributes->type == Type::Tuple && !attributes->items.empty()) {
+            attributes = attributes->items[0].get();
+        }
+        // Only a dict holds attributes; never follow one object's state into another's.
+        if (!attributes || attributes->type != Type::Dict) return nullptr;
+        return attributes->find(key);
+    }
+
+    if (type != Type::Dict) return nullptr;
+    for (size_t i = 0; i + 1 < items.size(); i += 2) {
+        if (items[i]->type == Type::String && items[i]->text == key) return items[i + 1].get();
+    }
+    return nullptr;
+}
+
+const PickleValue& PickleValue::at(const std::string& key) const {
+    const PickleValue* value = find(key);
+    if (!value) throw std::runtime_error("Pickled object has no attribute " + key);
+    return *value;
+}
+
+const PickleValue& PickleValue::item(size_t index) const {
+    if ((type != Type::Tuple && type != Type::List) || index >= items.size()) {
+        throw std::runtime_error("Pickled tuple is shorter than expected");
+    }
+    return *items[index];
+}
+
+PickleRef readPickle(const unsigned char* bytes, size_t size) {
+    return Unpickler(bytes, size).run();
+}
+
+bool NumpyArray::isArray(const PickleValue& value) {
+    return isNumpyGlobal(value, "_reconstruct") || isNumpyGlobal(value, "_frombuffer") ||
+           isNumpyGlobal(value, "scalar");
+}
+
+NumpyArray NumpyArray::from(const PickleValue& value) {
+    NumpyArray array;
+
+    if (isNumpyGlobal(value, "_reconstruct")) {
+        // ndarray.__reduce__: _reconstruct(ndarray, (0,), b'b') followed by
+        // BUILD with ([version,] shape, dtype, is_fortran, data).
+        if (!value.state || value.state->type != PickleValue::Type::Tuple) {
+            throw std::runtime_error("Malformed numpy array in pickle");
+        }
+        const auto& state = value.state->items;
+        const size_t first = state.size() == 5 ? 1 : 0;
+        if (state.size() != first + 4) throw std::runtime_error("Malformed numpy array in pickle");
+
+        readDtype(*state[first + 1], array);
+        array.shape = readShape(*state[first]);
+        array.fortranOrder = state[first + 2]->integer != 0;
+        attachData(*state[first + 3], array);
+    } else if (isNumpyGlobal(value, "_frombuffer")) {
+        // Protocol 5: _frombuffer(buffer, dtype, shape, order).
+        const PickleValue& arguments = *value.arguments;
+        readDtype(arguments.item(1), array);
+        array.shape = readShape(arguments.item(2));
+        array.fortranOrder = arguments.item(3).text == "F";
+        attachData(arguments.item(0), array);
+    } else if (isNumpyGlobal(value, "scalar")) {
+        // numpy scalars: scalar(dtype, raw bytes).
+        const PickleValue& arguments = *value.arguments;
+        readDtype(arguments.item(0), array);
+        if (array.kind == 'O') throw std::runtime_error("numpy object scalars are not supported");
+        attachData(arguments.item(1), array);
+    } else {
+        throw std::runtime_error("Pickled value is not a numpy array");
+    }
+
+    return array;
+}
+
+size_t NumpyArray::count() const {
+    size_t count = 1;
+    for (size_t dimension : shape) count *= dimension;
+    return count;
+}
+
+std::vector<double> NumpyArray::values() const {
+    const size_t total = count();
+    std::vector<double> result(total);
+
+    if (!fortranOrder || shape.size() < 2) {
+        for (size_t i = 0; i < total; ++i) result[i] = readElement(kind, itemSize, data + i * itemSize);
+        return result;
+    }
+
+    // Walk the C-order index and map it to the column-major offset.
+    std::vector<size_t> strides(shape.size(), 1);
+    for (size_t d = 1; d < shape.size(); ++d) strides[d] = strides[d - 1] * shape[d - 1];
+    std::vector<size_t> index(shape.size(), 0);
+    for (size_t i = 0; i < total; ++i) {
+        size_t offset = 0;
+        for (size_t d = 0; d < shape.size(); ++d) offset += index[d] * strides[d];
+        result[i] = readElement(kind, itemSize, data + offset * itemSize);
+
+        for (size_t d = shape.size(); d-- > 0;) {
+            if (++index[d] < shape[d]) break;
+            index[d] = 0;
+        }
+    }
+    return result;
+}
+
+std::vector<double> NumpyArray::field(const std::string& name) const {
+    for (const Field& f : fields) {
+        if (f.name != name) continue;
+        if (f.offset + f.itemSize > itemSize) throw std::runtime_error("numpy record field out of range");
+
+        const size_t total = count();
+        std::vector<double> result(total);
+        for (size_t i = 0; i < total; ++i) result[i] = readElement(f.kind, f.itemSize, data + i * itemSize + f.offset);
+        return result;
+    }
+    throw std::runtime_error("numpy record has no field " + name);
+}
+
+double pickleNumber(const PickleValue& value) {
+    switch (value.type) {
+        case PickleValue::Type::Bool:
+        case PickleValue::Type::Int:
+            return static_cast<double>(value.integer);
+        case PickleValue::Type::Float:
+            return value.number;
+        default:
+            break;
+    }
+
+    if (isNumpyGlobal(value, "scalar")) {
+        const NumpyArray scalar = NumpyArray::from(value);
+        if (scalar.kind != 'V') return scalar.values()[0];
+    }
+    throw std::runtime_error("Pickled value is not a number");
+}
+
+}
@@ -0,0 +1,45 @@
+#include "scaler.h"
+#include <stdexcept>
+
+#include "model_bundle.h"
+
+namespace Native {
+
+namespace {
+void validate(const Scaler& scaler, size_t features) {
+    if (scaler.mean.size() != features || scaler.scale.size() != features) {
+        throw std::runtime_error("Scaler does not match the number of features");
+    }
+    for (double scale : scaler.scale) {
+        if (!(scale > 0.0)) throw std::runtime_error("Scaler has a non-positive scale");
+    }
+}
+}
+
+Scaler Scaler::fromJson(const nlohmann::json& artifact, size_t features) {
+    Scaler scaler;
+
+    const auto section = artifact.find("scaler");
+    if (section == artifact.end() || section->is_null()) return scaler;
+
+    scaler.mean = section->at("mean").get<std::vector<double>>();
+    scaler.scale = section->at("scale").get<std::vector<double>>();
+    validate(scaler, features);
+
+    return scaler;
+}
+
+Scaler Scaler::fromBundle(const ModelBundle& bundle, size_t features) {
+    Scaler scaler;
+    if (!bundle.contains("scaler.mean")) return scaler;
+
+    const auto mean = bundle.array<double>("scaler.mean");
+    const auto scale = bundle.array<double>("scaler.scale");
+    scaler.mean.assign(mean.data, mean.data + mean.size());
+    scaler.scale.assign(scale.data, scale.data + scale.size());
+    validate(scaler, features);
+
+    return scaler;
+}
+
+}
@@ -0,0 +1,399 @@
+#include "sklearn_pickle.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "knn_model.h"
+#include "linear_model.h"
+#include "mapped_file.h"
+#include "model_bundle.h"
+#include "naive_bayes_model.h"
+#include "pickle_reader.h"
+#include "svm_model.h"
+#include "tree_ensemble.h"
+
+namespace Native {
+
+namespace {
+// The conversions below mirror the export_* functions of
+// model/src/native_export.py and bundle_sections() after them, so a
+// pickle loads into the same sections as the bundle exported from it.
+constexpr const char* kFormat = "ml-native";
+constexpr int kVersion = 1;
+constexpr size_t kVectorLanes = 8;
+constexpr size_t kQuickScorerMaxLeaves = 64;
+
+struct Matrix {
+    std::vector<double> values;   // row-major
+    size_t rows = 0;
+    size_t columns = 0;
+};
+
+NumpyArray arrayOf(const PickleValue& object, const std::string& name) {
+    const PickleValue& value = object.at(name);
+    if (!NumpyArray::isArray(value)) {
+        throw std::runtime_error(object.className() + "." + name + " is not a numpy array");
+    }
+    return NumpyArray::from(value);
+}
+
+std::vector<double> vectorOf(const PickleValue& object, const std::string& name) {
+    return arrayOf(object, name).values();
+}
+
+Matrix matrixOf(const PickleValue& object, const std::string& name) {
+    const NumpyArray array = arrayOf(object, name);
+    if (array.shape.size() != 2) {
+        throw std::runtime_error(object.className() + "." + name + " is not a matrix");
+    }
+    return {array.values(), array.shape[0], array.shape[1]};
+}
+
+std::string textOf(const PickleValue& object, const std::string& name) {
+    const PickleValue& value = object.at(name);
+    if (value.type != PickleValue::Type::String) {
+        throw std::runtime_error(object.className() + "." + name + " is not a string");
+    }
+    return value.text;
+}
+
+size_t paddedLength(size_t count) {
+    return (count + kVectorLanes - 1) / kVectorLanes * kVectorLanes;
+}
+
+// sklearn compares float32 features against float64 thresholds; rounding
+// down keeps x <= t exact for every float32 x (float32_floor).
+float float32Floor(double value) {
+    float rounded = static_cast<float>(value);
+    if (static_cast<double>(rounded) > value) {
+        rounded = std::nextafter(rounded, -std::numeric_limits<float>::infinity());
+    }
+    return rounded;
+}
+
+void addVector(ModelBundle& bundle, const std::string& name, const std::vector<double>& values) {
+    double* out = bundle.add<double>(name, values.size(), 1);
+    std::copy(values.begin(), values.end(), out);
+}
+
+void addPadded(ModelBundle& bundle, const std::string& name, const std::vector<double>& values) {
+    double* out = bundle.add<double>(name, paddedLength(values.size()), 1);
+    std::copy(values.begin(), values.end(), out);
+}
+
+// One float32 row per feature, padded with zeros to whole vectors.
+void addFeatureMajor(ModelBundle& bundle, const std::string& name, const Matrix& rows) {
+    const size_t stride = paddedLength(rows.rows);
+    float* out = bundle.add<float>(name, rows.columns, stride);
+    for (size_t row = 0; row < rows.rows; ++row) {
+        for (size_t f = 0; f < rows.columns; ++f) {
+            out[f * stride + row] = static_cast<float>(rows.values[row * rows.columns + f]);
+        }
+    }
+}
+
+nlohmann::json artifactFor(const PickleValue& estimator, const std::vector<std::string>& features) {
+    const std::vector<double> classes = vectorOf(estimator, "classes_");
+    if (classes.size() != 2) {
+        throw std::runtime_error("Native models support binary classifiers only");
+    }
+
+    const auto count = static_cast<size_t>(pickleNumber(estimator.at("n_features_in_")));
+    if (!features.empty() && features.size() != count) {
+        throw std::runtime_error("Pickled model does not match the number of features");
+    }
+
+    return {
+        {"format", kFormat},
+        {"version", kVersion},
+        {"classes", {static_cast<int>(classes[0]), static_cast<int>(classes[1])}},
+        {"num_features", count},
+        {"features", features},
+    };
+}
+
+struct TreeSections {
+    std::vector<int32_t> offsets{0};
+    std::vector<int32_t> feature;
+    std::vector<float> threshold;
+    std::vector<int32_t> left;
+    std::vector<int32_t> right;
+    std::vector<double> value;
+    std::vector<double> samples;
+    size_t maxLeaves = 0;
+};
+
+// export_tree(); leafValues maps the tree's value array (nodes x outputs x
+// classes, flattened) and class count to one value per node. classes is
+// what the value array must hold per node: 2 for a binary classifier
+// tree, 1 for a gradient boosting regressor.
+template <typename LeafValues>
+void appendTree(const PickleValue& estimator, size_t classes, TreeSections& out, LeafValues leafValues) {
+    const PickleValue& tree = estimator.at("tree_");
+    const NumpyArray nodes = arrayOf(tree, "nodes");
+    const NumpyArray values = arrayOf(tree, "values");
+    if (nodes.kind != 'V' || values.shape.size() != 3 || values.shape[0] != nodes.count() ||
+        values.shape[1] != 1 || values.shape[2] != classes) {
+        throw std::runtime_error("Malformed sklearn tree in pickle");
+    }
+
+    const std::vector<double> left = nodes.field("left_child");
+    const std::vector<double> right = nodes.field("right_child");
+    const std::vector<double> feature = nodes.field("feature");
+    const std::vector<double> threshold = nodes.field("threshold");
+    const std::vector<double> samples = nodes.field("weighted_n_node_samples");
+    const std::vector<double> leaves = leafValues(values.values(), values.shape[2]);
+
+    size_t leafCount = 0;
+    for (size_t node = 0; node < nodes.count(); ++node) {
+        const bool isLeaf = left[node] == -1;
+        leafCount += isLeaf;
+        out.feature.push_back(isLeaf ? -1 : static_cast<int32_t>(feature[node]));
+        out.threshold.push_back(float32Floor(isLeaf ? 0.0 : threshold[node]));
+        out.left.push_back(static_cast<int32_t>(left[node]));
+        out.right.push_back(static_cast<int32_t>(right[node]));
+        out.value.push_back(leaves[node]);
+        out.samples.push_back(samples[node]);
+    }
+
+    out.offsets.push_back(static_cast<int32_t>(out.feature.size()));
+    out.maxLeaves = std::max(out.maxLeaves, leafCount);
+}
+
+// positive_class_fraction(): normalized so count- and fraction-valued
+// trees both give the class-1 probability of every node.
+std::vector<double> positiveClassFraction(const std::vector<double>& values, size_t classes) {
+    std::vector<double> fractions(values.size() / classes);
+    for (size_t node = 0; node < fractions.size(); ++node) {
+        double total = 0.0;
+        for (size_t c = 0; c < classes; ++c) total += values[node * classes + c];
+        fractions[node] = values[node * classes + 1] / total;
+    }
+    return fractions;
+}
+
+// Prior log-odds of the init estimator, as _raw_predict_init computes it
+// for the binomial loss.
+double gradientBoostingBaseScore(const PickleValue& model) {
+    const PickleValue& init = model.at("init_");
+    if (init.type == PickleValue::Type::String && init.text == "zero") return 0.0;
+    if (init.className() != "DummyClassifier" || textOf(init, "_strategy") != "prior") {
+        throw std::runtime_error("Unsupported gradient boosting init estimator in pickle");
+    }
+
+    const double eps = std::numeric_limits<float>::epsilon();
+    const double p = std::min(std::max(vectorOf(init, "class_prior_").at(1), eps), 1.0 - eps);
+    return std::log(p / (1.0 - p));
+}
+
+void exportTrees(const PickleValue& model, nlohmann::json& artifact, ModelBundle& bundle) {
+    const std::string kind = model.className();
+    TreeSections trees;
+    nlohmann::json section = {{"aggregation", "mean_probability"}, {"base_score", 0.0}};
+
+    if (kind == "DecisionTreeClassifier") {
+        appendTree(model, 2, trees, positiveClassFraction);
+    } else if (kind == "RandomForestClassifier") {
+        const PickleValue& estimators = model.at("estimators_");
+        if (estimators.type != PickleValue::Type::List) {
+            throw std::runtime_error("Malformed random forest in pickle");
+        }
+        for (const auto& estimator : estimators.items) appendTree(*estimator, 2, trees, positiveClassFraction);
+    } else {
+        const std::string loss = textOf(model, "loss");
+        if (loss != "log_loss" && loss != "deviance") {
+            throw std::runtime_error("Unsupported gradient boosting loss in pickle: " + loss);
+        }
+
+        // The learning rate is folded into the leaves.
+        const double learningRate = pickleNumber(model.at("learning_rate"));
+        const NumpyArray stages = arrayOf(model, "estimators_");
+        if (stages.kind != 'O' || stages.shape.size() != 2 || stages.shape[1] != 1) {
+            throw std::runtime_error("Malformed gradient boosting stages in pickle");
+        }
+        for (const auto& stage : stages.objects) {
+            appendTree(*stage, 1, trees, [learningRate](const std::vector<double>& values, size_t outputs) {
+                std::vector<double> leaves(values.size() / outputs);
+                for (size_t node = 0; node < leaves.size(); ++node) {
+                    leaves[node] = values[node * outputs] * learningRate;
+                }
+                return leaves;
+            });
+        }
+
+        section = {
+            {"aggregation", "sum_logit"},
+            {"base_score", gradientBoostingBaseScore(model)},
+            {"evaluation", trees.maxLeaves <= kQuickScorerMaxLeaves ? "quickscorer" : "traversal"},
+        };
+    }
+
+    const size_t total = trees.feature.size();
+    std::copy(trees.offsets.begin(), trees.offsets.end(), bundle.add<int32_t>("trees.offsets", trees.offsets.size(), 1));
+    std::copy(trees.feature.begin(), trees.feature.end(), bundle.add<int32_t>("trees.feature", total, 1));
+    std::copy(trees.threshold.begin(), trees.threshold.end(), bundle.add<float>("trees.threshold", total, 1));
+    std::copy(trees.left.begin(), trees.left.end(), bundle.add<int32_t>("trees.left", total, 1));
+    std::copy(trees.right.begin(), trees.right.end(), bundle.add<int32_t>("trees.right", total, 1));
+    addVector(bundle, "trees.value", trees.value);
+    addVector(bundle, "trees.samples", trees.samples);
+
+    artifact["model"] = "trees";
+    artifact["trees"] = section;
+}
+
+void exportLinear(const PickleValue& model, nlohmann::json& artifact, ModelBundle& bundle) {
+    const Matrix coefficients = matrixOf(model, "coef_");
+    if (coefficients.rows != 1) {
+        throw std::runtime_error("Native logistic regression supports binary models only");
+    }
+
+    addVector(bundle, "linear.coefficients", coefficients.values);
+    artifact["model"] = "linear";
+    artifact["linear"] = {{"intercept", vectorOf(model, "intercept_").at(0)}};
+}
+
+void exportSvm(const PickleValue& model, nlohmann::json& artifact, ModelBundle& bundle) {
+    // Probabilities need the Platt parameters fitted by probability=True,
+    // read from the private attributes like the exporter does.
+    if (textOf(model, "kernel") != "rbf" || pickleNumber(model.at("probability")) == 0.0) {
+        throw std::runtime_error("Native SVMs support SVC(kernel='rbf', probability=True) only");
+    }
+    if (const PickleValue* sparse = model.find("_sparse"); sparse && pickleNumber(*sparse) != 0.0) {
+        throw std::runtime_error("Native SVMs do not support sparse training data");
+    }
+
+    const std::vector<double> probA = vectorOf(model, "_probA");
+    const std::vector<double> probB = vectorOf(model, "_probB");
+    const Matrix vectors = matrixOf(model, "support_vectors_");
+    const Matrix dualCoefficients = matrixOf(model, "dual_coef_");
+    if (probA.size() != 1 || probB.size() != 1 || dualCoefficients.rows != 1 ||
+        dualCoefficients.columns != vectors.rows) {
+        throw std::runtime_error("Malformed SVC in pickle");
+    }
+
+    // dual_coef_ and intercept_ carry sklearn's public sign.
+    addFeatureMajor(bundle, "svm.support_vectors", vectors);
+    addPadded(bundle, "svm.dual_coef", dualCoefficients.values);
+
+    artifact["model"] = "svm";
+    artifact["svm"] = {
+        {"kernel", "rbf"},
+        {"gamma", pickleNumber(model.at("_gamma"))},
+        {"intercept", vectorOf(model, "intercept_").at(0)},
+        {"prob_a", probA[0]},
+        {"prob_b", probB[0]},
+        {"support_vector_count", vectors.rows},
+    };
+}
+
+void exportKnn(const PickleValue& model, nlohmann::json& artifact, ModelBundle& bundle) {
+    if (textOf(model, "effective_metric_") != "euclidean") {
+        throw std::runtime_error("Native KNN models support the Euclidean metric only");
+    }
+    const PickleValue& weights = model.at("weights");
+    if (weights.type != PickleValue::Type::String || (weights.text != "uniform" && weights.text != "distance")) {
+        throw std::runtime_error("Native KNN models support uniform and distance weights only");
+    }
+
+    // _fit_X is already scaled; _y holds every row's index into classes_.
+    const Matrix references = matrixOf(model, "_fit_X");
+    const std::vector<double> targets = vectorOf(model, "_y");
+    if (targets.size() != references.rows) {
+        throw std::runtime_error("Malformed KNeighborsClassifier in pickle");
+    }
+
+    addFeatureMajor(bundle, "knn.references", references);
+    uint8_t* out = bundle.add<uint8_t>("knn.targets", targets.size(), 1);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (targets[i] != 0.0 && targets[i] != 1.0) throw std::runtime_error("KNN target is not a class index");
+        out[i] = static_cast<uint8_t>(targets[i]);
+    }
+
+    artifact["model"] = "knn";
+    artifact["knn"] = {
+        {"n_neighbors", static_cast<size_t>(pickleNumber(model.at("n_neighbors")))},
+        {"weights", weights.text},
+        {"reference_count", references.rows},
+    };
+}
+
+void exportNaiveBayes(const PickleValue& model, nlohmann::json& artifact, ModelBundle& bundle) {
+    // var_ already includes the var_smoothing term added during fit.
+    const Matrix theta = matrixOf(model, "theta_");
+    const Matrix var = matrixOf(model, "var_");
+    std::copy(theta.values.begin(), theta.values.end(),
+              bundle.add<double>("naive_bayes.theta", theta.rows, theta.columns));
+    std::copy(var.values.begin(), var.values.end(), bundle.add<double>("naive_bayes.var", var.rows, var.columns));
+    addVector(bundle, "naive_bayes.class_prior", vectorOf(model, "class_prior_"));
+
+    artifact["model"] = "naive_bayes";
+    artifact["naive_bayes"] = nlohmann::json::object();
+}
+
+// export_scaler(): mean_ or scale_ is None when the scaler was fitted with
+// with_mean or with_std off.
+void exportScaler(const PickleValue& scaler, size_t features, ModelBundle& bundle) {
+    if (scaler.className() != "StandardScaler") {
+        throw std::runtime_error("Scaler pickle does not hold a StandardScaler");
+    }
+
+    const PickleValue& mean = scaler.at("mean_");
+    const PickleValue& scale = scaler.at("scale_");
+    addVector(bundle, "scaler.mean", mean.isNone() ? std::vector<double>(features, 0.0) : vectorOf(scaler, "mean_"));
+    addVector(bundle, "scaler.scale", scale.isNone() ? std::vector<double>(features, 1.0) : vectorOf(scaler, "scale_"));
+}
+}
+
+std::unique_ptr<Model> loadPickledModel(const std::string& modelPath, const std::string& scalerPath,
+                                        const std::vector<std::string>& features) {
+    const MappedFile modelFile(modelPath);
+    const PickleRef estimator = readPickle(modelFile.data(), modelFile.size());
+    const std::string kind = estimator->className();
+
+    void (*convert)(const PickleValue&, nlohmann::json&, ModelBundle&) = nullptr;
+    if (kind == "DecisionTreeClassifier" || kind == "RandomForestClassifier" ||
+        kind == "GradientBoostingClassifier") {
+        convert = exportTrees;
+    } else if (kind == "LogisticRegression") {
+        convert = exportLinear;
+    } else if (kind == "SVC") {
+        convert = exportSvm;
+    } else if (kind == "KNeighborsClassifier") {
+        convert = exportKnn;
+    } else if (kind == "GaussianNB") {
+        convert = exportNaiveBayes;
+    } else {
+        throw std::runtime_error("Unsupported estimator in pickle: " + (kind.empty() ? "not an object" : kind));
+    }
+
+    nlohmann::json artifact = artifactFor(*estimator, features);
+    const std::shared_ptr<ModelBundle> bundle = ModelBundle::create();
+    convert(*estimator, artifact, *bundle);
+
+    if (!scalerPath.empty()) {
+        const MappedFile scalerFile(scalerPath);
+        exportScaler(*readPickle(scalerFile.data(), scalerFile.size()), artifact.at("num_features").get<size_t>(),
+                     *bundle);
+    }
+
+    const std::string type = artifact.at("model").get<std::string>();
+    bundle->setMetadata(std::move(artifact));
+
+    std::unique_ptr<Model> model;
+    if (type == "trees") {
+        model = TreeEnsemble::fromBundle(bundle);
+    } else if (type == "linear") {
+        model = LinearModel::fromBundle(bundle);
+    } else if (type == "svm") {
+        model = SvmModel::fromBundle(bundle);
+    } else if (type == "knn") {
+        model = KnnModel::fromBundle(bundle);
+    } else {
+        model = NaiveBayesModel::fromBundle(bundle);
+    }
+
+    model->setFeatureNames(features);
+    return model;
+}
+
+}
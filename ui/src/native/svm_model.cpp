@@ -0,0 +1,462 @@
+#include "svm_model.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "model_bundle.h"
+#include "simd_math.h"
+
+namespace Native {
+
+namespace {
+constexpr size_t kRowBlock = 4;
+constexpr size_t kVectorLanes = 8;
+
+// libsvm's sigmoid_predict: P(first class) for an internal decision value.
+double plattProbability(double decision, double a, double b) {
+    const double fApB = decision * a + b;
+    if (fApB >= 0) return std::exp(-fApB) / (1.0 + std::exp(-fApB));
+    return 1.0 / (1 + std::exp(fApB));
+}
+
+// libsvm's multiclass_probability for k = 2, step for step. It does not
+// return r01 unchanged: the fixed-point iteration stops at a tolerance of
+// 0.0025 and predict_proba reports wherever it stopped.
+void coupleProbabilities(double r01, double p[2]) {
+    constexpr int k = 2;
+    const double r[k][k] = {{0.0, r01}, {1.0 - r01, 0.0}};
+    double Q[k][k];
+    double Qp[k];
+    const double eps = 0.005 / k;
+
+    for (int t = 0; t < k; ++t) {
+        p[t] = 1.0 / k;
+        Q[t][t] = 0;
+        for (int j = 0; j < t; ++j) {
+            Q[t][t] += r[j][t] * r[j][t];
+            Q[t][j] = Q[j][t];
+        }
+        for (int j = t + 1; j < k; ++j) {
+            Q[t][t] += r[j][t] * r[j][t];
+            Q[t][j] = -r[j][t] * r[t][j];
+        }
+    }
+
+    for (int iter = 0; iter < 100; ++iter) {
+        double pQp = 0;
+        for (int t = 0; t < k; ++t) {
+            Qp[t] = 0;
+            for (int j = 0; j < k; ++j) Qp[t] += Q[t][j] * p[j];
+            pQp += p[t] * Qp[t];
+        }
+
+        double maxError = 0;
+        for (int t = 0; t < k; ++t) maxError = std::max(maxError, std::fabs(Qp[t] - pQp));
+        if (maxError < eps) break;
+
+        for (int t = 0; t < k; ++t) {
+            const double diff = (-Qp[t] + pQp) / Q[t][t];
+            p[t] += diff;
+            pQp = (pQp + diff * (diff * Q[t][t] + 2 * Qp[t])) / (1 + diff) / (1 + diff);
+            for (int j = 0; j < k; ++j) {
+                Qp[j] = (Qp[j] + diff * Q[t][j]) / (1 + diff);
+                p[j] /= (1 + diff);
+            }
+        }
+    }
+}
+
+// Decision value of one scaled row against every support vector: the sum
+// of coefficient * exp(-gamma * |x - sv|^2).
+double decisionScalar(const float* x, size_t features, const float* vectors, size_t stride,
+                      const double* coefficients, float gamma) {
+    double sum = 0.0;
+    for (size_t sv = 0; sv < stride; ++sv) {
+        float distance = 0.0f;
+        for (size_t f = 0; f < features; ++f) {
+            const float d = x[f] - vectors[f * stride + sv];
+            distance = std::fma(d, d, distance);
+        }
+        sum += coefficients[sv] * std::exp(-gamma * distance);
+    }
+    return sum;
+}
+
+#ifdef ML_NATIVE_X86_KERNELS
+// Same for Rows rows (row-major in x) at once: every support vector column
+// loaded is reused by all of them.
+template <size_t Rows>
+__attribute__((target("avx2,fma")))
+void decisionAvx2(const float* x, size_t features, const float* vectors, size_t stride,
+                  const double* coefficients, float gamma, double* decisions) {
+    __m256d sums[Rows][2];
+    for (size_t row = 0; row < Rows; ++row) {
+        sums[row][0] = _mm256_setzero_pd();
+        sums[row][1] = _mm256_setzero_pd();
+    }
+
+    const __m256 negativeGamma = _mm256_set1_ps(-gamma);
+
+    for (size_t sv = 0; sv < stride; sv += kVectorLanes) {
+        __m256 distance[Rows];
+        for (size_t row = 0; row < Rows; ++row) distance[row] = _mm256_setzero_ps();
+
+        for (size_t f = 0; f < features; ++f) {
+            const __m256 column = _mm256_loadu_ps(vectors + f * stride + sv);
+            for (size_t row = 0; row < Rows; ++row) {
+                const __m256 d = _mm256_sub_ps(_mm256_set1_ps(x[row * features + f]), column);
+                distance[row] = _mm256_fmadd_ps(d, d, distance[row]);
+            }
+        }
+
+        const __m256d low = _mm256_loadu_pd(coefficients + sv);
+        const __m256d high = _mm256_loadu_pd(coefficients + sv + 4);
+        for (size_t row = 0; row < Rows; ++row) {
+            const __m256 kernel = SimdMath::exp256(_mm256_mul_ps(negativeGamma, distance[row]));
+            sums[row][0] = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(kernel)), low, sums[row][0]);
+            sums[row][1] = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(kernel, 1)), high, sums[row][1]);
+        }
+    }
+
+    for (size_t row = 0; row < Rows; ++row) {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(sums[row][0], sums[row][1]));
+        decisions[row] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+}
+
+// Random feature layer for Rows rows: the sum of coefficient *
+// cos(x . w + offset) over all components.
+template <size_t Rows>
+__attribute__((target("avx2,fma")))
+void randomFeaturesAvx2(const float* x, size_t features, const float* weights, const float* offsets,
+                        size_t stride, const double* coefficients, double* decisions) {
+    __m256d sums[Rows][2];
+    for (size_t row = 0; row < Rows; ++row) {
+        sums[row][0] = _mm256_setzero_pd();
+        sums[row][1] = _mm256_setzero_pd();
+    }
+
+    for (size_t component = 0; component < stride; component += kVectorLanes) {
+        __m256 projection[Rows];
+        const __m256 offset = _mm256_loadu_ps(offsets + component);
+        for (size_t row = 0; row < Rows; ++row) projection[row] = offset;
+
+        for (size_t f = 0; f < features; ++f) {
+            const __m256 column = _mm256_loadu_ps(weights + f * stride + component);
+            for (size_t row = 0; row < Rows; ++row) {
+                projection[row] = _mm256_fmadd_ps(_mm256_set1_ps(x[row * features + f]), column, projection[row]);
+            }
+        }
+
+        const __m256d low = _mm256_loadu_pd(coefficients + component);
+        const __m256d high = _mm256_loadu_pd(coefficients + component + 4);
+        for (size_t row = 0; row < Rows; ++row) {
+            const __m256 feature = SimdMath::cos256(projection[row]);
+            sums[row][0] = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(feature)), low, sums[row][0]);
+            sums[row][1] = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(feature, 1)), high, sums[row][1]);
+        }
+    }
+
+    for (size_t row = 0; row < Rows; ++row) {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(sums[row][0], sums[row][1]));
+        decisions[row] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+}
+#endif
+
+double randomFeaturesScalar(const float* x, size_t features, const float* weights, const float* offsets,
+                            size_t stride, const double* coefficients) {
+    double sum = 0.0;
+    for (size_t component = 0; component < stride; ++component) {
+        float projection = offsets[component];
+        for (size_t f = 0; f < features; ++f) {
+            projection = std::fma(x[f], weights[f * stride + component], projection);
+        }
+        sum += coefficients[component] * std::cos(projection);
+    }
+    return sum;
+}
+}
+
+std::unique_ptr<SvmModel> SvmModel::create(const nlohmann::json& artifact) {
+    auto model = std::make_unique<SvmModel>();
+
+    model->features = artifact.at("num_features").get<size_t>();
+
+    const auto& classes = artifact.at("classes");
+    if (classes.size() != 2) {
+        throw std::runtime_error("Native SVMs support binary classifiers only");
+    }
+    model->classes[0] = classes[0].get<int>();
+    model->classes[1] = classes[1].get<int>();
+
+    const auto& section = artifact.at("svm");
+    if (section.value("kernel", "") != "rbf") {
+        throw std::runtime_error("Native SVMs support the RBF kernel only");
+    }
+
+    model->intercept = section.at("intercept").get<double>();
+    model->gamma = section.at("gamma").get<float>();
+    model->probA = section.at("prob_a").get<double>();
+    model->probB = section.at("prob_b").get<double>();
+    model->isa = Cpu::detect();
+
+    return model;
+}
+
+std::unique_ptr<SvmModel> SvmModel::fromJson(const nlohmann::json& artifact) {
+    auto model = create(artifact);
+    Storage& storage = model->storage;
+    const auto& section = artifact.at("svm");
+
+    const auto& supportVectors = section.at("support_vectors");
+    const auto dualCoefficients = section.at("dual_coef").get<std::vector<double>>();
+    model->supportVectors = supportVectors.size();
+    if (model->supportVectors == 0 || dualCoefficients.size() != model->supportVectors) {
+        throw std::runtime_error("Malformed support vectors in native model");
+    }
+
+    model->stride = (model->supportVectors + kVectorLanes - 1) / kVectorLanes * kVectorLanes;
+    storage.vectors.assign(model->features * model->stride, 0.0f);
+    storage.coefficients.assign(model->stride, 0.0);
+
+    for (size_t sv = 0; sv < model->supportVectors; ++sv) {
+        const auto values = supportVectors[sv].get<std::vector<double>>();
+        if (values.size() != model->features) {
+            throw std::runtime_error("Support vector does not match the number of features");
+        }
+        for (size_t f = 0; f < model->features; ++f) {
+            storage.vectors[f * model->stride + sv] = static_cast<float>(values[f]);
+        }
+        storage.coefficients[sv] = dualCoefficients[sv];
+    }
+
+    model->vectors = storage.vectors.data();
+    model->coefficients = storage.coefficients.data();
+    model->scaler = Scaler::fromJson(artifact, model->features);
+
+    const auto approximation = section.find("random_features");
+    if (approximation != section.end()) {
+        const auto& weights = approximation->at("weights");
+        const auto offsets = approximation->at("offsets").get<std::vector<double>>();
+        const auto coefficients = approximation->at("coefficients").get<std::vector<double>>();
+
+        RandomFeatures& layer = model->randomFeatures;
+        layer.components = weights.size();
+        if (layer.components == 0 || offsets.size() != layer.components ||
+            coefficients.size() != layer.components) {
+            throw std::runtime_error("Malformed random feature approximation in native model");
+        }
+
+        layer.stride = (layer.components + kVectorLanes - 1) / kVectorLanes * kVectorLanes;
+        storage.weights.assign(model->features * layer.stride, 0.0f);
+        storage.offsets.assign(layer.stride, 0.0f);
+        storage.randomCoefficients.assign(layer.stride, 0.0);
+
+        for (size_t component = 0; component < layer.components; ++component) {
+            const auto row = weights[component].get<std::vector<double>>();
+            if (row.size() != model->features) {
+                throw std::runtime_error("Random feature weights do not match the number of features");
+            }
+            for (size_t f = 0; f < model->features; ++f) {
+                storage.weights[f * layer.stride + component] = static_cast<float>(row[f]);
+            }
+            storage.offsets[component] = static_cast<float>(offsets[component]);
+            storage.randomCoefficients[component] = coefficients[component];
+        }
+
+        layer.weights = storage.weights.data();
+        layer.offsets = storage.offsets.data();
+        layer.coefficients = storage.randomCoefficients.data();
+        layer.intercept = approximation->at("intercept").get<double>();
+        layer.agreement = approximation->value("agreement", 0.0);
+    }
+
+    return model;
+}
+
+std::unique_ptr<SvmModel> SvmModel::fromBundle(const std::shared_ptr<const ModelBundle>& bundle) {
+    const nlohmann::json& artifact = bundle->metadata();
+    auto model = create(artifact);
+    const auto& section = artifact.at("svm");
+
+    // Sections are exported in the layout the kernels scan: features x
+    // stride float32, the stride padded to whole vectors.
+    const auto vectors = bundle->array<float>("svm.support_vectors");
+    const auto coefficients = bundle->array<double>("svm.dual_coef");
+    model->supportVectors = section.at("support_vector_count").get<size_t>();
+    model->stride = vectors.columns;
+    if (model->supportVectors == 0 || vectors.rows != model->features || model->stride % kVectorLanes != 0 ||
+        model->stride < model->supportVectors || coefficients.size() != model->stride) {
+        throw std::runtime_error("Malformed support vectors in native model");
+    }
+
+    model->vectors = vectors.data;
+    model->coefficients = coefficients.data;
+    model->scaler = Scaler::fromBundle(*bundle, model->features);
+
+    const auto approximation = section.find("random_features");
+    if (approximation != section.end()) {
+        const auto weights = bundle->array<float>("svm.rff.weights");
+        const auto offsets = bundle->array<float>("svm.rff.offsets");
+        const auto randomCoefficients = bundle->array<double>("svm.rff.coefficients");
+
+        RandomFeatures& layer = model->randomFeatures;
+        layer.components = approximation->at("components").get<size_t>();
+        layer.stride = weights.columns;
+        if (layer.components == 0 || weights.rows != model->features || layer.stride % kVectorLanes != 0 ||
+            layer.stride < layer.components || offsets.size() != layer.stride ||
+            randomCoefficients.size() != layer.stride) {
+            throw std::runtime_error("Malformed random feature approximation in native model");
+        }
+
+        layer.weights = weights.data;
+        layer.offsets = offsets.data;
+        layer.coefficients = randomCoefficients.data;
+        layer.intercept = approximation->at("intercept").get<double>();
+        layer.agreement = approximation->value("agreement", 0.0);
+    }
+
+    model->bundle = bundle;
+    return model;
+}
+
+std::string SvmModel::kind() const {
+    return "svm";
+}
+
+size_t SvmModel::numFeatures() const {
+    return features;
+}
+
+size_t SvmModel::numSupportVectors() const {
+    return supportVectors;
+}
+
+SvmModel::Evaluation SvmModel::evaluation() const {
+    return mode;
+}
+
+bool SvmModel::supportsRandomFeatures() const {
+    return randomFeatures.components > 0;
+}
+
+bool SvmModel::setEvaluation(Evaluation newMode) {
+    if (newMode == Evaluation::RandomFeatures && !supportsRandomFeatures()) return false;
+
+    mode = newMode;
+    return true;
+}
+
+double SvmModel::randomFeatureAgreement() const {
+    return randomFeatures.agreement;
+}
+
+void SvmModel::plattProbabilities(double decision, double probA, double probB, double p[2]) {
+    const double r01 = std::min(std::max(plattProbability(decision, probA, probB), 1e-7), 1 - 1e-7);
+    coupleProbabilities(r01, p);
+}
+
+Prediction SvmModel::finish(double decision) const {
+    // The artifact uses sklearn's public sign (positive means the second
+    // class); libsvm computes probabilities on the negated value.
+    double p[2];
+    plattProbabilities(-decision, probA, probB, p);
+
+    return {classes[decision > 0.0 ? 1 : 0], p[1]};
+}
+
+void SvmModel::scaleRows(const float* rows, size_t count, float* scaled) const {
+    for (size_t row = 0; row < count; ++row) {
+        const float* input = rows + row * features;
+        for (size_t f = 0; f < features; ++f) {
+            scaled[row * features + f] = scaler.isIdentity()
+                ? input[f]
+                : static_cast<float>((input[f] - scaler.mean[f]) / scaler.scale[f]);
+        }
+    }
+}
+
+void SvmModel::predictBatch(const float* rows, size_t count, Prediction* out) const {
+    if (mode == Evaluation::RandomFeatures) {
+        predictRandomFeatures(rows, count, out);
+    } else {
+        predictExact(rows, count, out);
+    }
+}
+
+void SvmModel::predictExact(const float* rows, size_t count, Prediction* out) const {
+    std::vector<float> scaled(kRowBlock * features);
+    double decisions[kRowBlock];
+
+    for (size_t first = 0; first < count; first += kRowBlock) {
+        const size_t block = std::min(kRowBlock, count - first);
+        scaleRows(rows + first * features, block, scaled.data());
+
+        // Leftover rows run one at a time so each row's arithmetic, and so
+        // its result, is the same whatever block it lands in.
+#ifdef ML_NATIVE_X86_KERNELS
+        if (isa != Cpu::Isa::None) {
+            if (block == kRowBlock) {
+                decisionAvx2<kRowBlock>(scaled.data(), features, vectors, stride,
+                                        coefficients, gamma, decisions);
+            } else {
+                for (size_t row = 0; row < block; ++row) {
+                    decisionAvx2<1>(scaled.data() + row * features, features, vectors, stride,
+                                    coefficients, gamma, decisions + row);
+                }
+            }
+        } else
+#endif
+        {
+            for (size_t row = 0; row < block; ++row) {
+                decisions[row] = decisionScalar(scaled.data() + row * features, features, vectors,
+                                                stride, coefficients, gamma);
+            }
+        }
+
+        for (size_t row = 0; row < block; ++row) {
+            out[first + row] = finish(decisions[row] + intercept);
+        }
+    }
+}
+
+void SvmModel::predictRandomFeatures(const float* rows, size_t count, Prediction* out) const {
+    const RandomFeatures& layer = randomFeatures;
+    std::vector<float> scaled(kRowBlock * features);
+    double decisions[kRowBlock];
+
+    for (size_t first = 0; first < count; first += kRowBlock) {
+        const size_t block = std::min(kRowBlock, count - first);
+        scaleRows(rows + first * features, block, scaled.data());
+
+#ifdef ML_NATIVE_X86_KERNELS
+        if (isa != Cpu::Isa::None) {
+            if (block == kRowBlock) {
+                randomFeaturesAvx2<kRowBlock>(scaled.data(), features, layer.weights, layer.offsets,
+                                              layer.stride, layer.coefficients, decisions);
+            } else {
+                for (size_t row = 0; row < block; ++row) {
+                    randomFeaturesAvx2<1>(scaled.data() + row * features, features, layer.weights,
+                                          layer.offsets, layer.stride, layer.coefficients,
+                                          decisions + row);
+                }
+            }
+        } else
+#endif
+        {
+            for (size_t row = 0; row < block; ++row) {
+                decisions[row] = randomFeaturesScalar(scaled.data() + row * features, features, layer.weights,
+                                                      layer.offsets, layer.stride, layer.coefficients);
+            }
+        }
+
+        for (size_t row = 0; row < block; ++row) {
+            out[first + row] = finish(decisions[row] + layer.intercept);
+        }
+    }
+}
+
+}
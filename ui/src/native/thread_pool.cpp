@@ -0,0 +1,162 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+
+namespace Native {
+
+namespace {
+
+// The pool whose loop the current thread is running chunks of, if any.
+// Workers are always inside their pool; a caller is while its loop runs.
+thread_local const ThreadPool* currentPool = nullptr;
+
+// A participant's run of chunk indices, begin in the high and end in the low
+// half, so that its owner popping the front and thieves popping the back
+// agree through a single compare-and-swap.
+struct alignas(64) ChunkRange {
+    std::atomic<uint64_t> span{0};
+
+    static uint64_t pack(uint64_t begin, uint64_t end) { return begin << 32 | end; }
+
+    bool popFront(size_t& chunk) {
+        uint64_t current = span.load(std::memory_order_relaxed);
+        while (true) {
+            const uint64_t begin = current >> 32, end = current & 0xffffffffu;
+            if (begin >= end) return false;
+            if (span.compare_exchange_weak(current, pack(begin + 1, end), std::memory_order_acq_rel)) {
+                chunk = static_cast<size_t>(begin);
+                return true;
+            }
+        }
+    }
+
+    bool popBack(size_t& chunk) {
+        uint64_t current = span.load(std::memory_order_relaxed);
+        while (true) {
+            const uint64_t begin = current >> 32, end = current & 0xffffffffu;
+            if (begin >= end) return false;
+            if (span.compare_exchange_weak(current, pack(begin, end - 1), std::memory_order_acq_rel)) {
+                chunk = static_cast<size_t>(end - 1);
+                return true;
+            }
+        }
+    }
+};
+
+}
+
+struct ThreadPool::Job {
+    const std::function<void(size_t, size_t)>* body;
+    size_t count;
+    size_t grain;
+    size_t participants;
+    std::unique_ptr<ChunkRange[]> ranges;
+};
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t participant = 1; participant < std::max<size_t>(threads, 1); ++participant) {
+        workers.emplace_back(&ThreadPool::work, this, participant);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body,
+                             size_t maxThreads) {
+    if (count == 0) return;
+
+    // Chunk indices have to fit the 32-bit halves of a ChunkRange.
+    constexpr size_t kMaxChunks = std::numeric_limits<uint32_t>::max();
+    grain = std::max({grain, size_t{1}, (count + kMaxChunks - 1) / kMaxChunks});
+    const size_t chunks = (count + grain - 1) / grain;
+
+    const size_t participants = std::min({size(), maxThreads != 0 ? maxThreads : size(), chunks});
+    // A nested call must not try_lock busy: its own thread may hold it.
+    if (participants <= 1 || currentPool == this || !busy.try_lock()) {
+        body(0, count);
+        return;
+    }
+    std::lock_guard<std::mutex> release(busy, std::adopt_lock);
+
+    Job current{&body, count, grain, participants, std::make_unique<ChunkRange[]>(participants)};
+    for (size_t participant = 0; participant < participants; ++participant) {
+        current.ranges[participant].span.store(
+            ChunkRange::pack(chunks * participant / participants, chunks * (participant + 1) / participants),
+            std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &current;
+        ++generation;
+    }
+    wake.notify_all();
+
+    const ThreadPool* outer = currentPool;
+    currentPool = this;
+    run(current, 0);
+    currentPool = outer;
+
+    // Every chunk has been taken once run() returns; workers still inside
+    // the job are finishing theirs. Late wake-ups must not join any more.
+    std::unique_lock<std::mutex> lock(mutex);
+    job = nullptr;
+    idle.wait(lock, [this]() { return active == 0; });
+}
+
+void ThreadPool::run(Job& job, size_t participant) {
+    size_t chunk = 0;
+    while (true) {
+        bool found = job.ranges[participant].popFront(chunk);
+        for (size_t offset = 1; !found && offset < job.participants; ++offset) {
+            found = job.ranges[(participant + offset) % job.participants].popBack(chunk);
+        }
+        if (!found) return;
+
+        const size_t begin = chunk * job.grain;
+        (*job.body)(begin, std::min(job.count, begin + job.grain));
+    }
+}
+
+void ThreadPool::work(size_t participant) {
+    currentPool = this;
+    uint64_t seen = 0;
+
+    while (true) {
+        Job* current = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || (job && generation != seen); });
+            if (stopping) return;
+
+            seen = generation;
+            if (participant >= job->participants) continue;
+
+            current = job;
+            ++active;
+        }
+
+        run(*current, participant);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0) idle.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,585 @@
+#include "tree_ensemble.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <stdexcept>
+
+#include "model_bundle.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Native {
+
+namespace {
+constexpr size_t kQuickScorerMaxLeaves = 64;
+
+inline uint32_t lowestSetBit(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif
+}
+}
+
+std::unique_ptr<TreeEnsemble> TreeEnsemble::fromJson(const nlohmann::json& artifact) {
+    auto ensemble = create(artifact);
+
+    bool allSamples = true;
+    for (const auto& tree : artifact.at("trees").at("trees")) {
+        const auto treeFeature = tree.at("feature").get<std::vector<int32_t>>();
+        const auto treeThreshold = tree.at("threshold").get<std::vector<float>>();
+        const auto treeLeft = tree.at("left").get<std::vector<int32_t>>();
+        const auto treeRight = tree.at("right").get<std::vector<int32_t>>();
+        const auto treeValue = tree.at("value").get<std::vector<double>>();
+
+        const size_t nodes = treeFeature.size();
+        if (nodes == 0 || treeThreshold.size() != nodes || treeLeft.size() != nodes ||
+            treeRight.size() != nodes || treeValue.size() != nodes) {
+            throw std::runtime_error("Malformed tree in native model");
+        }
+
+        // Optional per-node training sample counts, used as branch
+        // frequencies by the HotPath layout.
+        std::vector<double> samples;
+        const auto treeSamples = tree.find("samples");
+        if (treeSamples != tree.end() && treeSamples->size() == nodes) {
+            samples = treeSamples->get<std::vector<double>>();
+        } else {
+            allSamples = false;
+        }
+
+        ensemble->addTree(treeFeature.data(), treeThreshold.data(), treeLeft.data(), treeRight.data(),
+                          treeValue.data(), samples.empty() ? nullptr : samples.data(), nodes);
+    }
+
+    if (!allSamples) ensemble->visits.clear();
+    ensemble->finishLoading(artifact.at("trees"));
+    return ensemble;
+}
+
+std::unique_ptr<TreeEnsemble> TreeEnsemble::fromBundle(const std::shared_ptr<const ModelBundle>& bundle) {
+    const nlohmann::json& artifact = bundle->metadata();
+    auto ensemble = create(artifact);
+
+    // Trees are concatenated; offsets holds the first node of each and the
+    // total node count at the end. Child indices are local to their tree.
+    const auto offsets = bundle->array<int32_t>("trees.offsets");
+    const auto treeFeature = bundle->array<int32_t>("trees.feature");
+    const auto treeThreshold = bundle->array<float>("trees.threshold");
+    const auto treeLeft = bundle->array<int32_t>("trees.left");
+    const auto treeRight = bundle->array<int32_t>("trees.right");
+    const auto treeValue = bundle->array<double>("trees.value");
+    const bool hasSamples = bundle->contains("trees.samples");
+    const auto treeSamples = hasSamples ? bundle->array<double>("trees.samples") : ModelBundle::Array<double>{};
+
+    const size_t total = treeFeature.size();
+    if (offsets.size() < 2 || offsets.data[0] != 0 || static_cast<size_t>(offsets.data[offsets.size() - 1]) != total ||
+        treeThreshold.size() != total || treeLeft.size() != total || treeRight.size() != total ||
+        treeValue.size() != total || (hasSamples && treeSamples.size() != total)) {
+        throw std::runtime_error("Malformed trees in native model bundle");
+    }
+
+    for (size_t tree = 0; tree + 1 < offsets.size(); ++tree) {
+        const int32_t first = offsets.data[tree];
+        if (offsets.data[tree + 1] <= first) {
+            throw std::runtime_error("Malformed trees in native model bundle");
+        }
+        ensemble->addTree(treeFeature.data + first, treeThreshold.data + first, treeLeft.data + first,
+                          treeRight.data + first, treeValue.data + first,
+                          hasSamples ? treeSamples.data + first : nullptr,
+                          static_cast<size_t>(offsets.data[tree + 1] - first));
+    }
+
+    ensemble->finishLoading(artifact.at("trees"));
+    return ensemble;
+}
+
+std::unique_ptr<TreeEnsemble> TreeEnsemble::create(const nlohmann::json& artifact) {
+    auto ensemble = std::make_unique<TreeEnsemble>();
+
+    ensemble->features = artifact.at("num_features").get<size_t>();
+
+    const auto& classes = artifact.at("classes");
+    if (classes.size() != 2) {
+        throw std::runtime_error("Native trees support binary classifiers only");
+    }
+    ensemble->classes[0] = classes[0].get<int>();
+    ensemble->classes[1] = classes[1].get<int>();
+
+    const auto& section = artifact.at("trees");
+    const std::string aggregation = section.at("aggregation").get<std::string>();
+    if (aggregation == "mean_probability") {
+        ensemble->aggregation = Aggregation::MeanProbability;
+    } else if (aggregation == "sum_logit") {
+        ensemble->aggregation = Aggregation::SumLogit;
+    } else {
+        throw std::runtime_error("Unknown tree aggregation: " + aggregation);
+    }
+    ensemble->baseScore = section.value("base_score", 0.0);
+
+    return ensemble;
+}
+
+void TreeEnsemble::addTree(const int32_t* treeFeature, const float* treeThreshold, const int32_t* treeLeft,
+                           const int32_t* treeRight, const double* treeValue, const double* treeSamples,
+                           size_t nodes) {
+    const auto offset = static_cast<int32_t>(feature.size());
+    roots.push_back(offset);
+    size_t leaves = 0;
+
+    if (treeSamples) visits.insert(visits.end(), treeSamples, treeSamples + nodes);
+
+    // Every node but the root is some node's child exactly once.
+    std::vector<bool> claimed(nodes, false);
+
+    for (size_t node = 0; node < nodes; ++node) {
+        const int32_t split = treeFeature[node];
+        const int32_t leftChild = treeLeft[node];
+        const int32_t rightChild = treeRight[node];
+
+        if (split >= static_cast<int32_t>(features)) {
+            throw std::runtime_error("Tree split on unknown feature");
+        }
+        if (split >= 0 && (leftChild <= 0 || rightChild <= 0 ||
+                           leftChild >= static_cast<int32_t>(nodes) ||
+                           rightChild >= static_cast<int32_t>(nodes))) {
+            throw std::runtime_error("Tree child index out of range");
+        }
+        // sklearn numbers children after their parent, which also rules out
+        // cycles that would make traversal and the layout builders loop.
+        if (split >= 0) {
+            if (leftChild <= static_cast<int32_t>(node) || rightChild <= static_cast<int32_t>(node) ||
+                leftChild == rightChild || claimed[leftChild] || claimed[rightChild]) {
+                throw std::runtime_error("Tree nodes do not form a tree");
+            }
+            claimed[leftChild] = true;
+            claimed[rightChild] = true;
+        }
+
+        if (split < 0) ++leaves;
+
+        feature.push_back(split);
+        threshold.push_back(treeThreshold[node]);
+        left.push_back(split >= 0 ? offset + leftChild : -1);
+        right.push_back(split >= 0 ? offset + rightChild : -1);
+        value.push_back(treeValue[node]);
+    }
+
+    maxLeaves = std::max(maxLeaves, leaves);
+}
+
+void TreeEnsemble::finishLoading(const nlohmann::json& section) {
+    if (roots.empty()) {
+        throw std::runtime_error("Native model has no trees");
+    }
+
+    const std::string evaluation = section.value("evaluation", "traversal");
+    if (evaluation == "quickscorer") {
+        // Falls back to traversal for trees that are too deep.
+        setEvaluation(Evaluation::QuickScorer);
+    } else if (evaluation == "simd") {
+        // Falls back to traversal on CPUs without AVX2.
+        setEvaluation(Evaluation::Simd);
+    }
+}
+
+std::string TreeEnsemble::kind() const {
+    return "trees";
+}
+
+size_t TreeEnsemble::numFeatures() const {
+    return features;
+}
+
+size_t TreeEnsemble::numTrees() const {
+    return roots.size();
+}
+
+size_t TreeEnsemble::numNodes() const {
+    return feature.size();
+}
+
+TreeEnsemble::Evaluation TreeEnsemble::evaluation() const {
+    return mode;
+}
+
+bool TreeEnsemble::supportsQuickScorer() const {
+    return maxLeaves <= kQuickScorerMaxLeaves;
+}
+
+bool TreeEnsemble::supportsSimd() const {
+    return Cpu::detect() != Cpu::Isa::None;
+}
+
+bool TreeEnsemble::setEvaluation(Evaluation newMode) {
+    if (newMode == Evaluation::QuickScorer) {
+        if (!supportsQuickScorer()) return false;
+        if (quickScorer.featureOffsets.empty()) buildQuickScorer();
+    }
+
+    if (newMode == Evaluation::Simd) {
+        if (!supportsSimd()) return false;
+        if (simdIsa == Cpu::Isa::None) simdIsa = Cpu::detect();
+        if (simd.roots.empty()) simd = TreeSimd::build(roots, feature, threshold, left, right, value);
+    }
+
+    mode = newMode;
+    return true;
+}
+
+size_t TreeEnsemble::simdLanes() const {
+    return Cpu::lanes(simdIsa == Cpu::Isa::None ? Cpu::detect() : simdIsa);
+}
+
+bool TreeEnsemble::setSimdLanes(size_t lanes) {
+    const Cpu::Isa best = Cpu::detect();
+
+    if (lanes == 16 && best == Cpu::Isa::Avx512) {
+        simdIsa = Cpu::Isa::Avx512;
+    } else if (lanes == 8 && best != Cpu::Isa::None) {
+        simdIsa = Cpu::Isa::Avx2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+uint32_t TreeEnsemble::indexLeaves(int32_t node, uint32_t& nextLeaf,
+                                   std::vector<std::pair<int32_t, uint64_t>>& splits) {
+    if (feature[node] < 0) {
+        quickScorer.leafValues.push_back(value[node]);
+        ++nextLeaf;
+        return 1;
+    }
+
+    // Leaves are numbered left to right, so the left subtree of a split
+    // always owns a contiguous run of bits. Both subtrees have at least one
+    // leaf, hence leftLeaves < 64 and the shift below is defined.
+    const uint32_t first = nextLeaf;
+    const uint32_t leftLeaves = indexLeaves(left[node], nextLeaf, splits);
+    const uint64_t leftSubtree = ((uint64_t{1} << leftLeaves) - 1) << first;
+    splits.emplace_back(node, ~leftSubtree);
+
+    return leftLeaves + indexLeaves(right[node], nextLeaf, splits);
+}
+
+void TreeEnsemble::buildQuickScorer() {
+    struct Split {
+        float threshold;
+        uint32_t tree;
+        uint64_t mask;
+    };
+
+    quickScorer = QuickScorerIndex{};
+    std::vector<std::vector<Split>> byFeature(features);
+    std::vector<std::pair<int32_t, uint64_t>> splits;
+
+    for (uint32_t tree = 0; tree < roots.size(); ++tree) {
+        quickScorer.leafOffsets.push_back(static_cast<uint32_t>(quickScorer.leafValues.size()));
+
+        uint32_t nextLeaf = 0;
+        splits.clear();
+        indexLeaves(roots[tree], nextLeaf, splits);
+
+        for (const auto& [node, mask] : splits) {
+            byFeature[feature[node]].push_back({threshold[node], tree, mask});
+        }
+    }
+
+    quickScorer.featureOffsets.push_back(0);
+    for (auto& group : byFeature) {
+        std::stable_sort(group.begin(), group.end(),
+                         [](const Split& a, const Split& b) { return a.threshold < b.threshold; });
+
+        for (const Split& split : group) {
+            quickScorer.thresholds.push_back(split.threshold);
+            quickScorer.trees.push_back(split.tree);
+            quickScorer.masks.push_back(split.mask);
+        }
+        quickScorer.featureOffsets.push_back(static_cast<uint32_t>(quickScorer.thresholds.size()));
+    }
+}
+
+TreeEnsemble::NodeLayout TreeEnsemble::nodeLayout() const {
+    return layout;
+}
+
+size_t TreeEnsemble::sharedTopLevels() const {
+    return topLevels;
+}
+
+bool TreeEnsemble::hasBranchFrequencies() const {
+    return !visits.empty();
+}
+
+void TreeEnsemble::calibrate(const float* rows, size_t count) {
+    visits.assign(feature.size(), 0.0);
+
+    for (int32_t root : roots) {
+        for (size_t row = 0; row < count; ++row) {
+            const float* x = rows + row * features;
+            int32_t node = root;
+            visits[node] += 1.0;
+            while (feature[node] >= 0) {
+                node = x[feature[node]] <= threshold[node] ? left[node] : right[node];
+                visits[node] += 1.0;
+            }
+        }
+    }
+}
+
+bool TreeEnsemble::setNodeLayout(NodeLayout newLayout, size_t newTopLevels) {
+    if (newLayout == NodeLayout::HotPath && visits.empty()) return false;
+
+    std::vector<int32_t> order;
+    order.reserve(feature.size());
+    std::vector<char> placed(feature.size(), 0);
+
+    // Shared block: the first levels of every tree, breadth first.
+    if (newTopLevels > 0) {
+        for (int32_t root : roots) {
+            std::deque<std::pair<int32_t, size_t>> queue{{root, 0}};
+            while (!queue.empty()) {
+                const auto [node, depth] = queue.front();
+                queue.pop_front();
+
+                order.push_back(node);
+                placed[node] = 1;
+                if (feature[node] >= 0 && depth + 1 < newTopLevels) {
+                    queue.emplace_back(left[node], depth + 1);
+                    queue.emplace_back(right[node], depth + 1);
+                }
+            }
+        }
+    }
+
+    std::vector<int32_t> treeOrder;
+    for (int32_t root : roots) {
+        treeOrder.clear();
+        appendTreeOrder(root, newLayout, treeOrder);
+        for (int32_t node : treeOrder) {
+            if (!placed[node]) order.push_back(node);
+        }
+    }
+
+    applyNodeOrder(order);
+    layout = newLayout;
+    topLevels = newTopLevels;
+    return true;
+}
+
+void TreeEnsemble::appendTreeOrder(int32_t root, NodeLayout treeLayout, std::vector<int32_t>& order) const {
+    if (treeLayout == NodeLayout::BreadthFirst) {
+        std::deque<int32_t> queue{root};
+        while (!queue.empty()) {
+            const int32_t node = queue.front();
+            queue.pop_front();
+
+            order.push_back(node);
+            if (feature[node] >= 0) {
+                queue.push_back(left[node]);
+                queue.push_back(right[node]);
+            }
+        }
+        return;
+    }
+
+    if (treeLayout == NodeLayout::VanEmdeBoas) {
+        // Height of every subtree in levels, computed children first: in
+        // preorder a parent always comes before its children.
+        std::vector<int32_t> preorder;
+        appendTreeOrder(root, NodeLayout::DepthFirst, preorder);
+
+        std::vector<int32_t> heights(feature.size(), 1);
+        for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+            if (feature[*it] >= 0) heights[*it] = 1 + std::max(heights[left[*it]], heights[right[*it]]);
+        }
+
+        appendVanEmdeBoas(root, heights[root], heights, order);
+        return;
+    }
+
+    // DepthFirst and HotPath: preorder, with HotPath descending into the
+    // more frequently visited child first so the common path is contiguous.
+    std::vector<int32_t> stack{root};
+    while (!stack.empty()) {
+        const int32_t node = stack.back();
+        stack.pop_back();
+
+        order.push_back(node);
+        if (feature[node] < 0) continue;
+
+        int32_t first = left[node];
+        int32_t second = right[node];
+        if (treeLayout == NodeLayout::HotPath && visits[second] > visits[first]) std::swap(first, second);
+
+        stack.push_back(second);
+        stack.push_back(first);
+    }
+}
+
+void TreeEnsemble::appendVanEmdeBoas(int32_t node, int32_t levels, const std::vector<int32_t>& heights,
+                                     std::vector<int32_t>& order) const {
+    levels = std::min(levels, heights[node]);
+    if (levels == 1) {
+        order.push_back(node);
+        return;
+    }
+
+    // The top half of the levels is laid out first, then each subtree
+    // hanging below it, recursively.
+    const int32_t top = levels / 2;
+    appendVanEmdeBoas(node, top, heights, order);
+
+    std::vector<std::pair<int32_t, int32_t>> stack{{node, 0}};
+    std::vector<int32_t> bottoms;
+    while (!stack.empty()) {
+        const auto [current, depth] = stack.back();
+        stack.pop_back();
+
+        if (depth == top) {
+            bottoms.push_back(current);
+        } else if (feature[current] >= 0) {
+            stack.emplace_back(right[current], depth + 1);
+            stack.emplace_back(left[current], depth + 1);
+        }
+    }
+
+    for (int32_t bottom : bottoms) {
+        appendVanEmdeBoas(bottom, levels - top, heights, order);
+    }
+}
+
+void TreeEnsemble::applyNodeOrder(const std::vector<int32_t>& order) {
+    std::vector<int32_t> position(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = static_cast<int32_t>(i);
+    }
+
+    auto permute = [&order](auto& values) {
+        std::remove_reference_t<decltype(values)> reordered(values.size());
+        for (size_t i = 0; i < order.size(); ++i) reordered[i] = values[order[i]];
+        values.swap(reordered);
+    };
+
+    permute(feature);
+    permute(threshold);
+    permute(left);
+    permute(right);
+    permute(value);
+    if (!visits.empty()) permute(visits);
+
+    for (size_t i = 0; i < left.size(); ++i) {
+        if (feature[i] >= 0) {
+            left[i] = position[left[i]];
+            right[i] = position[right[i]];
+        }
+    }
+
+    for (int32_t& root : roots) {
+        root = position[root];
+    }
+}
+
+double TreeEnsemble::leafValue(int32_t node, const float* row) const {
+    // Same test as sklearn: go left when x <= threshold. Thresholds were
+    // rounded down to float32 at export so this matches the float64 compare.
+    while (feature[node] >= 0) {
+        node = row[feature[node]] <= threshold[node] ? left[node] : right[node];
+    }
+    return value[node];
+}
+
+Prediction TreeEnsemble::finish(double sum) const {
+    double probability;
+
+    if (aggregation == Aggregation::MeanProbability) {
+        probability = sum / static_cast<double>(roots.size());
+        // Ties go to the first class, like argmax in predict_proba.
+        return {classes[probability > 0.5 ? 1 : 0], probability};
+    }
+
+    const double raw = baseScore + sum;
+    probability = 1.0 / (1.0 + std::exp(-raw));
+    return {classes[raw > 0.0 ? 1 : 0], probability};
+}
+
+void TreeEnsemble::predictBatch(const float* rows, size_t count, Prediction* out) const {
+    if (mode == Evaluation::QuickScorer) {
+        predictQuickScorer(rows, count, out);
+    } else if (mode == Evaluation::Simd) {
+        predictSimd(rows, count, out);
+    } else {
+        predictTraversal(rows, count, out);
+    }
+}
+
+void TreeEnsemble::predictTraversal(const float* rows, size_t count, Prediction* out) const {
+    // Trees in the outer loop keep one tree's nodes hot in cache while all
+    // rows walk it; sums are accumulated per row in tree order, as sklearn
+    // does.
+    std::vector<double> sums(count, 0.0);
+
+    for (int32_t root : roots) {
+        for (size_t row = 0; row < count; ++row) {
+            sums[row] += leafValue(root, rows + row * features);
+        }
+    }
+
+    for (size_t row = 0; row < count; ++row) {
+        out[row] = finish(sums[row]);
+    }
+}
+
+void TreeEnsemble::predictQuickScorer(const float* rows, size_t count, Prediction* out) const {
+    const QuickScorerIndex& index = quickScorer;
+    std::vector<uint64_t> leaves(roots.size());
+
+    for (size_t row = 0; row < count; ++row) {
+        const float* x = rows + row * features;
+        std::fill(leaves.begin(), leaves.end(), ~uint64_t{0});
+
+        // A split is false unless x <= threshold, so NaN fails every split
+        // and goes right, as in traversal; splits are sorted, so the scan of
+        // a feature stops at the first split that holds.
+        for (size_t f = 0; f < features; ++f) {
+            const float value = x[f];
+            const uint32_t end = index.featureOffsets[f + 1];
+
+            for (uint32_t i = index.featureOffsets[f]; i < end && !(value <= index.thresholds[i]); ++i) {
+                leaves[index.trees[i]] &= index.masks[i];
+            }
+        }
+
+        // Summed in tree order so the result matches traversal bit for bit.
+        double sum = 0.0;
+        for (size_t tree = 0; tree < roots.size(); ++tree) {
+            sum += index.leafValues[index.leafOffsets[tree] + lowestSetBit(leaves[tree])];
+        }
+
+        out[row] = finish(sum);
+    }
+}
+
+void TreeEnsemble::predictSimd(const float* rows, size_t count, Prediction* out) const {
+    const size_t blockRows = TreeSimd::blockRows(simdIsa, features);
+    std::vector<double> sums(std::min(count, blockRows));
+
+    for (size_t first = 0; first < count; first += blockRows) {
+        const size_t block = std::min(blockRows, count - first);
+        std::fill(sums.begin(), sums.begin() + block, 0.0);
+
+        TreeSimd::accumulate(simdIsa, simd, rows + first * features, block, features, sums.data());
+
+        for (size_t row = 0; row < block; ++row) {
+            out[first + row] = finish(sums[row]);
+        }
+    }
+}
+
+}
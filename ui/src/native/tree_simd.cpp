@@ -0,0 +1,210 @@
+#include "tree_simd.h"
+#include <algorithm>
+#include <deque>
+
+#ifdef ML_NATIVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Native {
+
+namespace TreeSimd {
+
+namespace {
+constexpr size_t kBlockBytes = 16 * 1024;
+
+// Scalar walk over the SIMD layout, for the rows left over after the last
+// full vector.
+void accumulateScalar(const Layout& layout, const float* rows, size_t first, size_t count,
+                      size_t features, double* sums) {
+    for (int32_t root : layout.roots) {
+        for (size_t row = first; row < count; ++row) {
+            const float* x = rows + row * features;
+            int32_t node = root;
+            while (layout.feature[node] >= 0) {
+                node = layout.left[node] + (x[layout.feature[node]] <= layout.threshold[node] ? 0 : 1);
+            }
+            sums[row] += layout.value[node];
+        }
+    }
+}
+
+#ifdef ML_NATIVE_X86_KERNELS
+// GCC warns about the deliberately undefined pass-through operand inside its
+// own gather and extract intrinsics.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx2")))
+size_t accumulateAvx2(const Layout& layout, const float* rows, size_t count, size_t features, double* sums) {
+    const size_t vectors = count / 8;
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rowOffsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                  _mm256_set1_epi32(static_cast<int>(features)));
+
+    for (size_t tree = 0; tree < layout.roots.size(); ++tree) {
+        const int32_t depth = layout.depths[tree];
+
+        for (size_t v = 0; v < vectors; ++v) {
+            const float* x = rows + v * 8 * features;
+            __m256i node = _mm256_set1_epi32(layout.roots[tree]);
+
+            for (int32_t level = 0; level < depth; ++level) {
+                const __m256i split = _mm256_i32gather_epi32(layout.feature.data(), node, 4);
+                const __m256 limit = _mm256_i32gather_ps(layout.threshold.data(), node, 4);
+                const __m256i child = _mm256_i32gather_epi32(layout.left.data(), node, 4);
+                const __m256 input = _mm256_i32gather_ps(x, _mm256_add_epi32(rowOffsets, _mm256_max_epi32(split, zero)), 4);
+
+                // NLE_UQ sends NaN right, like the scalar x <= t test; the
+                // split > -1 term keeps lanes that reached a leaf in place.
+                const __m256i goRight = _mm256_and_si256(
+                    _mm256_castps_si256(_mm256_cmp_ps(input, limit, _CMP_NLE_UQ)),
+                    _mm256_cmpgt_epi32(split, minusOne));
+                const __m256i next = _mm256_add_epi32(child, _mm256_and_si256(goRight, one));
+
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(next, node)) == -1) break;
+                node = next;
+            }
+
+            double* sum = sums + v * 8;
+            const __m256d low = _mm256_i32gather_pd(layout.value.data(), _mm256_castsi256_si128(node), 8);
+            const __m256d high = _mm256_i32gather_pd(layout.value.data(), _mm256_extracti128_si256(node, 1), 8);
+            _mm256_storeu_pd(sum, _mm256_add_pd(_mm256_loadu_pd(sum), low));
+            _mm256_storeu_pd(sum + 4, _mm256_add_pd(_mm256_loadu_pd(sum + 4), high));
+        }
+    }
+
+    return vectors * 8;
+}
+
+__attribute__((target("avx512f")))
+size_t accumulateAvx512(const Layout& layout, const float* rows, size_t count, size_t features, double* sums) {
+    const size_t vectors = count / 16;
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i minusOne = _mm512_set1_epi32(-1);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i rowOffsets = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32(static_cast<int>(features)));
+
+    for (size_t tree = 0; tree < layout.roots.size(); ++tree) {
+        const int32_t depth = layout.depths[tree];
+
+        for (size_t v = 0; v < vectors; ++v) {
+            const float* x = rows + v * 16 * features;
+            __m512i node = _mm512_set1_epi32(layout.roots[tree]);
+
+            for (int32_t level = 0; level < depth; ++level) {
+                const __m512i split = _mm512_i32gather_epi32(node, layout.feature.data(), 4);
+                const __m512 limit = _mm512_i32gather_ps(node, layout.threshold.data(), 4);
+                const __m512i child = _mm512_i32gather_epi32(node, layout.left.data(), 4);
+                const __m512 input = _mm512_i32gather_ps(_mm512_add_epi32(rowOffsets, _mm512_max_epi32(split, zero)), x, 4);
+
+                const __mmask16 goRight = _mm512_cmp_ps_mask(input, limit, _CMP_NLE_UQ) &
+                                          _mm512_cmpgt_epi32_mask(split, minusOne);
+                const __m512i next = _mm512_mask_add_epi32(child, goRight, child, one);
+
+                if (_mm512_cmpeq_epi32_mask(next, node) == 0xFFFF) break;
+                node = next;
+            }
+
+            double* sum = sums + v * 16;
+            const __m512d low = _mm512_i32gather_pd(_mm512_castsi512_si256(node), layout.value.data(), 8);
+            const __m512d high = _mm512_i32gather_pd(_mm512_extracti64x4_epi64(node, 1), layout.value.data(), 8);
+            _mm512_storeu_pd(sum, _mm512_add_pd(_mm512_loadu_pd(sum), low));
+            _mm512_storeu_pd(sum + 8, _mm512_add_pd(_mm512_loadu_pd(sum + 8), high));
+        }
+    }
+
+    return vectors * 16;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+}
+
+Layout build(const std::vector<int32_t>& roots, const std::vector<int32_t>& feature,
+             const std::vector<float>& threshold, const std::vector<int32_t>& left,
+             const std::vector<int32_t>& right, const std::vector<double>& value) {
+    Layout layout;
+    layout.feature.reserve(feature.size());
+
+    struct Pending {
+        int32_t source;
+        int32_t slot;
+        int32_t depth;
+    };
+
+    for (int32_t root : roots) {
+        const auto rootSlot = static_cast<int32_t>(layout.feature.size());
+        layout.roots.push_back(rootSlot);
+        layout.feature.push_back(0);
+        layout.threshold.push_back(0.0f);
+        layout.left.push_back(0);
+        layout.value.push_back(0.0);
+
+        int32_t depth = 0;
+        std::deque<Pending> queue{{root, rootSlot, 0}};
+
+        while (!queue.empty()) {
+            const Pending current = queue.front();
+            queue.pop_front();
+            depth = std::max(depth, current.depth);
+
+            const int32_t node = current.source;
+            layout.feature[current.slot] = feature[node];
+            layout.threshold[current.slot] = threshold[node];
+            layout.value[current.slot] = value[node];
+
+            if (feature[node] < 0) {
+                layout.left[current.slot] = current.slot;
+                continue;
+            }
+
+            const auto children = static_cast<int32_t>(layout.feature.size());
+            layout.left[current.slot] = children;
+            layout.feature.resize(children + 2);
+            layout.threshold.resize(children + 2);
+            layout.left.resize(children + 2);
+            layout.value.resize(children + 2);
+
+            queue.push_back({left[node], children, current.depth + 1});
+            queue.push_back({right[node], children + 1, current.depth + 1});
+        }
+
+        layout.depths.push_back(depth);
+    }
+
+    return layout;
+}
+
+size_t blockRows(Cpu::Isa isa, size_t features) {
+    const size_t width = Cpu::lanes(isa);
+    const size_t rows = kBlockBytes / (std::max<size_t>(features, 1) * sizeof(float));
+    return std::max(width, rows / width * width);
+}
+
+void accumulate(Cpu::Isa isa, const Layout& layout, const float* rows, size_t count,
+                size_t features, double* sums) {
+    size_t done = 0;
+
+#ifdef ML_NATIVE_X86_KERNELS
+    if (isa == Cpu::Isa::Avx512) {
+        done = accumulateAvx512(layout, rows, count, features, sums);
+    } else if (isa == Cpu::Isa::Avx2) {
+        done = accumulateAvx2(layout, rows, count, features, sums);
+    }
+#endif
+
+    accumulateScalar(layout, rows, done, count, features, sums);
+}
+
+}
+
+}
@@ -0,0 +1,137 @@
+// Checks the built-in ONNX interpreter against ONNX Runtime on
+// TreeEnsembleClassifier graphs whose weights all go to one class column,
+// the case where Runtime derives both probabilities from one score.
+//
+// The expected labels and probabilities were produced by onnxruntime 1.31
+// on the same graphs, built with onnx.helper from the attributes below.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "onnx_graph.h"
+#include "onnx_model.h"
+
+namespace {
+
+using Native::OnnxAttribute;
+
+OnnxAttribute ints(const std::string& name, std::vector<int64_t> values) {
+    OnnxAttribute attribute;
+    attribute.name = name;
+    attribute.type = OnnxAttribute::Type::Ints;
+    attribute.integers = std::move(values);
+    return attribute;
+}
+
+OnnxAttribute floats(const std::string& name, std::vector<float> values) {
+    OnnxAttribute attribute;
+    attribute.name = name;
+    attribute.type = OnnxAttribute::Type::Floats;
+    attribute.numbers = std::move(values);
+    return attribute;
+}
+
+OnnxAttribute strings(const std::string& name, std::vector<std::string> values) {
+    OnnxAttribute attribute;
+    attribute.name = name;
+    attribute.type = OnnxAttribute::Type::Strings;
+    attribute.texts = std::move(values);
+    return attribute;
+}
+
+OnnxAttribute text(const std::string& name, const std::string& value) {
+    OnnxAttribute attribute;
+    attribute.name = name;
+    attribute.type = OnnxAttribute::Type::String;
+    attribute.text = value;
+    return attribute;
+}
+
+struct Expected {
+    int label;
+    double probability;
+};
+
+struct Case {
+    std::vector<float> weights;
+    std::string postTransform;
+    std::vector<float> baseValues;
+    std::vector<Expected> rows;   // for x = 0, 1, 2
+};
+
+// Two stumps on one feature, splitting at 0.5 and 1.5, every leaf weight
+// in class column 0.
+Native::OnnxGraph stumps(const Case& test) {
+    Native::OnnxNode node;
+    node.opType = "TreeEnsembleClassifier";
+    node.domain = "ai.onnx.ml";
+    node.inputs = {"X"};
+    node.outputs = {"label", "probabilities"};
+    node.attributes = {
+        ints("nodes_treeids", {0, 0, 0, 1, 1, 1}),
+        ints("nodes_nodeids", {0, 1, 2, 0, 1, 2}),
+        ints("nodes_featureids", {0, 0, 0, 0, 0, 0}),
+        floats("nodes_values", {0.5f, 0.0f, 0.0f, 1.5f, 0.0f, 0.0f}),
+        strings("nodes_modes", {"BRANCH_LEQ", "LEAF", "LEAF", "BRANCH_LEQ", "LEAF", "LEAF"}),
+        ints("nodes_truenodeids", {1, 0, 0, 1, 0, 0}),
+        ints("nodes_falsenodeids", {2, 0, 0, 2, 0, 0}),
+        ints("class_treeids", {0, 0, 1, 1}),
+        ints("class_nodeids", {1, 2, 1, 2}),
+        ints("class_ids", {0, 0, 0, 0}),
+        floats("class_weights", test.weights),
+        ints("classlabels_int64s", {0, 1}),
+        text("post_transform", test.postTransform),
+    };
+    if (!test.baseValues.empty()) node.attributes.push_back(floats("base_values", test.baseValues));
+
+    Native::OnnxGraph graph;
+    graph.opsets = {{"", 17}, {"ai.onnx.ml", 3}};
+    graph.nodes = {node};
+    graph.inputs = {{"X", Native::OnnxValueInfo::Kind::Tensor, Native::OnnxType::Float, {-1, 1}}};
+    graph.outputs = {
+        {"label", Native::OnnxValueInfo::Kind::Tensor, Native::OnnxType::Int64, {-1}},
+        {"probabilities", Native::OnnxValueInfo::Kind::Tensor, Native::OnnxType::Float, {-1, 2}},
+    };
+    return graph;
+}
+
+}
+
+int main() {
+    const std::vector<float> positive = {0.05f, 0.2f, 0.1f, 0.35f};
+    const std::vector<float> mixed = {-0.4f, 0.3f, -0.2f, 0.6f};
+
+    const std::vector<Case> cases = {
+        // The middle row's probability is above 0.5 but its score is not,
+        // and Runtime labels positive weights by the score.
+        {positive, "LOGISTIC", {0.1f}, {{0, 0.562176525592804}, {0, 0.5986876487731934}, {1, 0.6570104956626892}}},
+        {positive, "LOGISTIC", {}, {{0, 0.5374298095703125}, {0, 0.5744425058364868}, {1, 0.6341356039047241}}},
+        {mixed, "LOGISTIC", {-0.2f}, {{0, 0.31002551317214966}, {0, 0.4750208258628845}, {1, 0.6681877970695496}}},
+        {positive, "SOFTMAX", {}, {{0, 0.15000000596046448}, {0, 0.30000001192092896}, {1, 0.550000011920929}}},
+        {mixed, "SOFTMAX", {}, {{0, -0.6000000238418579}, {1, 0.10000000894069672}, {1, 0.9000000357627869}}},
+        {positive, "NONE", {}, {{0, 0.15000000596046448}, {0, 0.30000001192092896}, {1, 0.550000011920929}}},
+        {mixed, "NONE", {}, {{0, -0.6000000238418579}, {1, 0.10000000894069672}, {1, 0.9000000357627869}}},
+    };
+
+    const float rows[] = {0.0f, 1.0f, 2.0f};
+    int failures = 0;
+    for (const Case& test : cases) {
+        const auto model = Native::OnnxModel::fromGraph(stumps(test));
+        Native::Prediction out[3];
+        model->predictBatch(rows, 3, out);
+
+        for (size_t row = 0; row < 3; ++row) {
+            const Expected& expected = test.rows[row];
+            if (out[row].label != expected.label || std::fabs(out[row].probability - expected.probability) > 1e-6) {
+                std::fprintf(stderr, "%s, %s weights, x = %zu: got label %d, p %.9f; expected label %d, p %.9f\n",
+                             test.postTransform.c_str(), test.weights[0] < 0.0f ? "mixed" : "positive", row,
+                             out[row].label, out[row].probability, expected.label, expected.probability);
+                ++failures;
+            }
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Builds the HNSW index a KNN native model searches instead of its exported
+// training rows, for reference cohorts of millions of rows.
+//
+//   knn-index-builder <native_model.json> <cohort.csv|cohort.bin> <index.hnsw>
+//                     [--target column] [--m M] [--ef-construction ef]
+//
+// A CSV cohort has a header row and must hold every feature of the model,
+// encoded like the rows the UI sends, plus the target column (default
+// "num"). Targets are binarized like the notebook: a positive value is the
+// second class. Rows with a missing or non-numeric value are skipped. Any
+// other file is read as raw float32 rows of the features followed by the
+// class index. Rows are scaled with the model's scaler before indexing.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hnsw_index.h"
+#include "scaler.h"
+#include "json.hpp"
+
+namespace {
+
+struct Cohort {
+    std::vector<float> rows;
+    std::vector<uint8_t> labels;
+    size_t skipped = 0;
+};
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        if (!field.empty() && field.back() == '\r') field.pop_back();
+        fields.push_back(field);
+    }
+    if (!line.empty() && line.back() == ',') fields.emplace_back();
+    return fields;
+}
+
+bool parseNumber(const std::string& field, double& value) {
+    if (field.empty()) return false;
+    char* end = nullptr;
+    value = std::strtod(field.c_str(), &end);
+    return end == field.c_str() + field.size();
+}
+
+Cohort readCsv(const std::string& path, const std::vector<std::string>& features, const std::string& target) {
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file, line)) {
+        throw std::runtime_error("Could not read " + path);
+    }
+
+    const std::vector<std::string> header = splitCsvLine(line);
+    auto columnOf = [&](const std::string& name) {
+        for (size_t column = 0; column < header.size(); ++column) {
+            if (header[column] == name) return column;
+        }
+        throw std::runtime_error("Cohort has no column " + name);
+    };
+
+    std::vector<size_t> columns;
+    for (const auto& feature : features) columns.push_back(columnOf(feature));
+    const size_t targetColumn = columnOf(target);
+
+    Cohort cohort;
+    std::vector<float> row(features.size());
+    while (std::getline(file, line)) {
+        if (line.empty() || line == "\r") continue;
+
+        const std::vector<std::string> fields = splitCsvLine(line);
+        bool valid = fields.size() == header.size();
+        double value = 0.0;
+        for (size_t f = 0; valid && f < columns.size(); ++f) {
+            valid = parseNumber(fields[columns[f]], value);
+            row[f] = static_cast<float>(value);
+        }
+        valid = valid && parseNumber(fields[targetColumn], value);
+
+        if (!valid) {
+            ++cohort.skipped;
+            continue;
+        }
+        cohort.rows.insert(cohort.rows.end(), row.begin(), row.end());
+        cohort.labels.push_back(value > 0.0 ? 1 : 0);
+    }
+    return cohort;
+}
+
+Cohort readBinary(const std::string& path, size_t features) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not read " + path);
+    }
+
+    Cohort cohort;
+    std::vector<float> row(features + 1);
+    while (file.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(float)))) {
+        const float label = row[features];
+        if (label != 0.0f && label != 1.0f) {
+            ++cohort.skipped;
+            continue;
+        }
+        cohort.rows.insert(cohort.rows.end(), row.begin(), row.end() - 1);
+        cohort.labels.push_back(static_cast<uint8_t>(label));
+    }
+    if (file.gcount() != 0) {
+        throw std::runtime_error(path + " is not a whole number of rows");
+    }
+    return cohort;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::fprintf(stderr,
+                     "usage: %s <native_model.json> <cohort.csv|cohort.bin> <index.hnsw> "
+                     "[--target column] [--m M] [--ef-construction ef]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::string target = "num";
+    Native::HnswIndex::BuildOptions options;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        if (option == "--target") {
+            target = argv[i + 1];
+        } else if (option == "--m") {
+            options.m = std::strtoul(argv[i + 1], nullptr, 10);
+        } else if (option == "--ef-construction") {
+            options.efConstruction = std::strtoul(argv[i + 1], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    try {
+        std::ifstream file(argv[1]);
+        const nlohmann::json artifact = nlohmann::json::parse(file, nullptr, false);
+        if (!artifact.is_object() || artifact.value("model", "") != "knn") {
+            throw std::runtime_error(std::string("Not a KNN native model: ") + argv[1]);
+        }
+
+        const auto features = artifact.at("features").get<std::vector<std::string>>();
+        const std::string cohortPath = argv[2];
+        Cohort cohort = endsWith(cohortPath, ".csv") ? readCsv(cohortPath, features, target)
+                                                     : readBinary(cohortPath, features.size());
+
+        const size_t count = cohort.labels.size();
+        std::printf("%zu rows read, %zu skipped\n", count, cohort.skipped);
+
+        const Native::Scaler scaler = Native::Scaler::fromJson(artifact, features.size());
+        if (!scaler.isIdentity()) {
+            for (size_t row = 0; row < count; ++row) {
+                for (size_t f = 0; f < features.size(); ++f) {
+                    float& value = cohort.rows[row * features.size() + f];
+                    value = static_cast<float>((value - scaler.mean[f]) / scaler.scale[f]);
+                }
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        Native::HnswIndex::build(cohort.rows.data(), cohort.labels.data(), count, features.size(), options, argv[3]);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        auto index = Native::HnswIndex::open(argv[3]);
+        std::printf("indexed %zu rows in %.1f s, %zu levels, M = %zu, ef_construction = %zu\n", index->size(),
+                    elapsed.count(), index->levels(), options.m, options.efConstruction);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
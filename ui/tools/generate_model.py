@@ -0,0 +1,165 @@
+"""Compiles a native_model.json tree ensemble into C++ source.
+
+    generate_model.py <native_model.json> <output.cpp> [--style if|ternary]
+
+Every tree becomes one inline function with its thresholds and leaf values
+as literals, so the compiler can schedule the comparisons and keep the
+constants in the instruction stream. The output implements
+include/native/generated_model.h.
+
+Styles:
+  if       nested if/else, one branch per split
+  ternary  one nested conditional expression per tree, which compilers can
+           lower to conditional moves for shallow trees
+"""
+
+import argparse
+import hashlib
+import json
+import sys
+
+# Deeper trees would exceed the bracket nesting limit of some compilers in
+# ternary style; they are emitted as if/else instead.
+MAX_TERNARY_DEPTH = 64
+
+def float_literal(value):
+    # Hex literals are exact: thresholds are float32 values and leaves are
+    # doubles, both written without any decimal rounding.
+    return float(value).hex() + 'f'
+
+def double_literal(value):
+    return float(value).hex()
+
+def tree_depth(tree, node=0):
+    if tree['feature'][node] < 0:
+        return 0
+    return 1 + max(tree_depth(tree, tree['left'][node]), tree_depth(tree, tree['right'][node]))
+
+def emit_if(tree, node, indent, out):
+    pad = '    ' * indent
+    if tree['feature'][node] < 0:
+        out.append(f"{pad}return {double_literal(tree['value'][node])};")
+        return
+
+    out.append(f"{pad}if (x[{tree['feature'][node]}] <= {float_literal(tree['threshold'][node])}) {{")
+    emit_if(tree, tree['left'][node], indent + 1, out)
+    out.append(f"{pad}}} else {{")
+    emit_if(tree, tree['right'][node], indent + 1, out)
+    out.append(f"{pad}}}")
+
+def ternary(tree, node):
+    if tree['feature'][node] < 0:
+        return double_literal(tree['value'][node])
+
+    condition = f"x[{tree['feature'][node]}] <= {float_literal(tree['threshold'][node])}"
+    return f"({condition} ? {ternary(tree, tree['left'][node])} : {ternary(tree, tree['right'][node])})"
+
+def emit_tree(index, tree, style, out):
+    out.append(f"inline double tree{index}(const float* x) {{")
+    if style == 'ternary' and tree_depth(tree) <= MAX_TERNARY_DEPTH:
+        out.append(f"    return {ternary(tree, 0)};")
+    else:
+        emit_if(tree, 0, 1, out)
+    out.append("}")
+    out.append("")
+
+def generate(artifact, digest, style):
+    if artifact.get('model') != 'trees':
+        raise ValueError('only tree ensembles can be compiled')
+
+    section = artifact['trees']
+    trees = section['trees']
+    classes = artifact['classes']
+    names = ', '.join(json.dumps(name) for name in artifact.get('features', []))
+
+    out = [
+        "// Generated by tools/generate_model.py. Do not edit.",
+        "",
+        "#include <cmath>",
+        "#include <string>",
+        "#include <vector>",
+        "",
+        '#include "generated_model.h"',
+        "",
+        "namespace Native {",
+        "",
+        "namespace {",
+        "",
+    ]
+
+    for index, tree in enumerate(trees):
+        emit_tree(index, tree, style, out)
+
+    out.append("inline Prediction score(const float* x) {")
+    out.append("    double sum = 0.0;")
+    for index in range(len(trees)):
+        out.append(f"    sum += tree{index}(x);")
+
+    # Same aggregation as TreeEnsemble::finish.
+    if section['aggregation'] == 'mean_probability':
+        out.append(f"    const double probability = sum / {double_literal(len(trees))};")
+        out.append(f"    return {{probability > 0.5 ? {classes[1]} : {classes[0]}, probability}};")
+    elif section['aggregation'] == 'sum_logit':
+        out.append(f"    const double raw = {double_literal(section.get('base_score', 0.0))} + sum;")
+        out.append(f"    return {{raw > 0.0 ? {classes[1]} : {classes[0]}, 1.0 / (1.0 + std::exp(-raw))}};")
+    else:
+        raise ValueError(f"unknown aggregation {section['aggregation']}")
+    out.append("}")
+    out.append("")
+
+    out += [
+        "class CompiledTrees : public Model {",
+        "public:",
+        '    std::string kind() const override { return "generated-trees"; }',
+        f"    size_t numFeatures() const override {{ return {artifact['num_features']}; }}",
+        "",
+        "    Prediction predict(const float* row) const override {",
+        "        return score(row);",
+        "    }",
+        "",
+        "    void predictBatch(const float* rows, size_t count, Prediction* out) const override {",
+        "        for (size_t row = 0; row < count; ++row) {",
+        f"            out[row] = score(rows + row * {artifact['num_features']});",
+        "        }",
+        "    }",
+        "};",
+        "",
+        "}",
+        "",
+        "std::unique_ptr<Model> makeGeneratedModel() {",
+        "    auto model = std::make_unique<CompiledTrees>();",
+        f"    model->setFeatureNames({{{names}}});",
+        "    return model;",
+        "}",
+        "",
+        "const char* generatedModelFingerprint() {",
+        f'    return "{digest}";',
+        "}",
+        "",
+        "}",
+        "",
+    ]
+    return "\n".join(out)
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('artifact')
+    parser.add_argument('output')
+    parser.add_argument('--style', choices=['if', 'ternary'], default='if')
+    args = parser.parse_args()
+
+    with open(args.artifact, 'rb') as f:
+        raw = f.read()
+
+    try:
+        source = generate(json.loads(raw), hashlib.sha1(raw).hexdigest(), args.style)
+    except (ValueError, KeyError) as e:
+        print(f"generate_model.py: {args.artifact}: {e}", file=sys.stderr)
+        return 1
+
+    with open(args.output, 'w') as f:
+        f.write(source)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
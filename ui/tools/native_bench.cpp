@@ -0,0 +1,295 @@
+// Times the native engine on random rows drawn from the feature limits.
+//
+//   native-bench <native_model.json|native_model.bin|best_model.onnx> [rows] [repeats] [knn-index]
+//
+// Tree ensembles are timed in every evaluation mode they support, and every
+// mode's results are checked against traversal. Traversal is timed in each
+// node layout and Simd mode at each vector width the CPU has. SVMs are
+// timed exactly and with their random feature approximation, if exported.
+// KNN models are timed on one thread and on all of them, and with an HNSW
+// index, if given, at several ef with their recall@k. Other models' batches
+// are also timed split across the shared ThreadPool. Builds with
+// ML_GENERATED_MODEL also time the compiled-in model, which should be
+// generated from the same artifact for the comparison to mean anything.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "feature_limits.h"
+#include "hnsw_index.h"
+#include "knn_model.h"
+#include "native_model.h"
+#include "onnx_model.h"
+#include "svm_model.h"
+#include "thread_pool.h"
+#include "tree_ensemble.h"
+
+#ifdef HAVE_GENERATED_MODEL
+#include "generated_model.h"
+#endif
+
+namespace {
+
+std::vector<float> randomRows(const Native::Model& model, size_t rows) {
+    std::mt19937 generator(42);
+    const auto& limits = featureLimits();
+    const auto& names = model.featureNames();
+    std::vector<float> data(rows * model.numFeatures());
+
+    for (size_t column = 0; column < model.numFeatures(); ++column) {
+        FeatureLimit limit{0.0f, 1.0f, false};
+        if (column < names.size() && limits.count(names[column])) {
+            limit = limits.at(names[column]);
+        }
+
+        std::uniform_real_distribution<float> distribution(limit.min, limit.max);
+        for (size_t row = 0; row < rows; ++row) {
+            float value = distribution(generator);
+            data[row * model.numFeatures() + column] = limit.isInteger ? std::round(value) : value;
+        }
+    }
+
+    return data;
+}
+
+// Best of repeats, in nanoseconds per row.
+double timePerRow(size_t rows, int repeats, const std::function<void()>& run) {
+    double best = 1e300;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        best = std::min(best, elapsed.count() / static_cast<double>(rows));
+    }
+    return best;
+}
+
+void report(const std::string& label, const Native::Model& model, const std::vector<float>& data,
+            size_t rows, int repeats, std::vector<Native::Prediction>& out) {
+    const size_t columns = model.numFeatures();
+
+    double batch = timePerRow(rows, repeats, [&]() { model.predictBatch(data.data(), rows, out.data()); });
+    double single = timePerRow(rows, repeats, [&]() {
+        for (size_t row = 0; row < rows; ++row) out[row] = model.predict(data.data() + row * columns);
+    });
+
+    std::printf("%-28s batch %9.1f ns/row   single %9.1f ns/row\n", label.c_str(), batch, single);
+}
+
+size_t countMismatches(const std::vector<Native::Prediction>& out, const std::vector<Native::Prediction>& reference) {
+    size_t mismatches = 0;
+    for (size_t row = 0; row < out.size(); ++row) {
+        mismatches += out[row].label != reference[row].label ||
+                      out[row].probability != reference[row].probability;
+    }
+    return mismatches;
+}
+
+// Times predictParallel on the shared pool and compares it with the
+// single-threaded results already in out.
+void reportParallel(const Native::Model& model, const std::vector<float>& data, size_t rows, int repeats,
+                    std::vector<Native::Prediction>& out) {
+    const std::vector<Native::Prediction> reference = out;
+    double batch = timePerRow(rows, repeats, [&]() { Native::predictParallel(model, data.data(), rows, out.data()); });
+
+    const std::string label = std::to_string(Native::ThreadPool::shared().size()) + " threads";
+    std::printf("%-28s batch %9.1f ns/row   %zu mismatches\n", label.c_str(), batch, countMismatches(out, reference));
+}
+
+// Times an HNSW index at a range of ef and reports recall@k against exact
+// search over the same rows.
+void reportIndex(Native::KnnModel& knn, const std::string& path, const std::vector<float>& data, size_t rows,
+                 int repeats, std::vector<Native::Prediction>& out) {
+    std::shared_ptr<const Native::HnswIndex> index;
+    try {
+        index = Native::HnswIndex::open(path);
+        knn.attachIndex(index);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return;
+    }
+
+    const size_t k = knn.neighbours();
+    const size_t columns = knn.numFeatures();
+    std::printf("index of %zu rows, %zu levels\n", index->size(), index->levels());
+
+    // Exact search over millions of rows is slow, so recall is measured on
+    // a sample of the queries.
+    const size_t queries = std::min<size_t>(rows, 1000);
+    std::vector<Native::KnnModel::Neighbour> exact(queries * k);
+    const double exactTime = timePerRow(queries, 1, [&]() {
+        for (size_t row = 0; row < queries; ++row) knn.exactNeighbours(data.data() + row * columns, &exact[row * k]);
+    });
+    std::printf("%-28s single %9.1f ns/row\n", "exact", exactTime);
+
+    std::vector<Native::KnnModel::Neighbour> found(k);
+    for (size_t ef : {k, size_t{16}, size_t{32}, size_t{64}, size_t{128}, size_t{256}}) {
+        if (ef < k) continue;
+        knn.setSearchBreadth(ef);
+
+        size_t hits = 0;
+        for (size_t row = 0; row < queries; ++row) {
+            knn.kneighbours(data.data() + row * columns, found.data());
+            for (size_t i = 0; i < k; ++i) {
+                for (size_t j = 0; j < k; ++j) {
+                    if (found[i].index == exact[row * k + j].index) {
+                        ++hits;
+                        break;
+                    }
+                }
+            }
+        }
+
+        report("hnsw ef=" + std::to_string(ef), knn, data, rows, repeats, out);
+        std::printf("%-28s recall@%zu %.4f\n", "", k, static_cast<double>(hits) / static_cast<double>(queries * k));
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <native_model.json|native_model.bin|best_model.onnx> [rows] [repeats] [knn-index]\n", argv[0]);
+        return 1;
+    }
+
+    const size_t rows = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    const int repeats = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    std::unique_ptr<Native::Model> model;
+    try {
+        model = Native::loadModel(argv[1]);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::vector<float> data = randomRows(*model, rows);
+    std::vector<Native::Prediction> out(rows);
+    std::printf("%s model, %zu features, %zu rows\n", model->kind().c_str(), model->numFeatures(), rows);
+
+    if (auto* svm = dynamic_cast<Native::SvmModel*>(model.get())) {
+        std::printf("%zu support vectors\n", svm->numSupportVectors());
+        report("exact", *svm, data, rows, repeats, out);
+        std::vector<Native::Prediction> reference = out;
+
+        if (svm->setEvaluation(Native::SvmModel::Evaluation::RandomFeatures)) {
+            report("random features", *svm, data, rows, repeats, out);
+
+            size_t agree = 0;
+            double maxDifference = 0.0;
+            for (size_t row = 0; row < rows; ++row) {
+                agree += out[row].label == reference[row].label;
+                maxDifference = std::max(maxDifference, std::fabs(out[row].probability - reference[row].probability));
+            }
+            std::printf("random features agreement %.4f (%.4f at export), max probability difference %.4f\n",
+                        static_cast<double>(agree) / static_cast<double>(rows), svm->randomFeatureAgreement(),
+                        maxDifference);
+        }
+        return 0;
+    }
+
+    if (auto* knn = dynamic_cast<Native::KnnModel*>(model.get())) {
+        std::printf("%zu references, k = %zu\n", knn->numReferences(), knn->neighbours());
+        knn->setThreads(1);
+        report("1 thread", *knn, data, rows, repeats, out);
+        std::vector<Native::Prediction> reference = out;
+
+        knn->setThreads(0);
+        report("all threads", *knn, data, rows, repeats, out);
+        std::printf("%zu mismatches against 1 thread\n", countMismatches(out, reference));
+
+        if (argc > 4) reportIndex(*knn, argv[4], data, rows, repeats, out);
+        return 0;
+    }
+
+    if (auto* onnx = dynamic_cast<Native::OnnxModel*>(model.get())) {
+        std::string pipeline;
+        for (const std::string& op : onnx->operators()) pipeline += (pipeline.empty() ? "" : " -> ") + op;
+        std::printf("operators: %s\n", pipeline.c_str());
+    }
+
+    auto* trees = dynamic_cast<Native::TreeEnsemble*>(model.get());
+    if (!trees) {
+        report(model->kind(), *model, data, rows, repeats, out);
+        reportParallel(*model, data, rows, repeats, out);
+        return 0;
+    }
+
+    std::printf("%zu trees, %zu nodes\n", trees->numTrees(), trees->numNodes());
+
+    trees->setEvaluation(Native::TreeEnsemble::Evaluation::Traversal);
+    report("traversal", *trees, data, rows, repeats, out);
+    reportParallel(*trees, data, rows, repeats, out);
+    std::vector<Native::Prediction> reference = out;
+
+    if (trees->setEvaluation(Native::TreeEnsemble::Evaluation::QuickScorer)) {
+        report("quickscorer", *trees, data, rows, repeats, out);
+        std::printf("quickscorer mismatches vs traversal: %zu\n", countMismatches(out, reference));
+    } else {
+        std::printf("quickscorer: not supported (trees have more than 64 leaves)\n");
+    }
+
+    // Traversal in every node layout, on its own and with the first levels
+    // of all trees moved to a shared block. HotPath runs on the artifact's
+    // sample counts when present and on frequencies calibrated with the
+    // benchmark rows otherwise.
+    trees->setEvaluation(Native::TreeEnsemble::Evaluation::Traversal);
+    if (!trees->hasBranchFrequencies()) trees->calibrate(data.data(), std::min<size_t>(rows, 10000));
+
+    const std::pair<Native::TreeEnsemble::NodeLayout, const char*> layouts[] = {
+        {Native::TreeEnsemble::NodeLayout::DepthFirst, "depth-first"},
+        {Native::TreeEnsemble::NodeLayout::BreadthFirst, "breadth-first"},
+        {Native::TreeEnsemble::NodeLayout::VanEmdeBoas, "veb"},
+        {Native::TreeEnsemble::NodeLayout::HotPath, "hot-path"},
+    };
+
+    for (size_t topLevels : {0, 3}) {
+        for (const auto& [nodeLayout, name] : layouts) {
+            trees->setNodeLayout(nodeLayout, topLevels);
+
+            const std::string label = std::string("layout ") + name + (topLevels ? " +top3" : "");
+            report(label, *trees, data, rows, repeats, out);
+            std::printf("%s mismatches vs traversal: %zu\n", label.c_str(), countMismatches(out, reference));
+        }
+    }
+    trees->setNodeLayout(Native::TreeEnsemble::NodeLayout::DepthFirst);
+
+    if (trees->setEvaluation(Native::TreeEnsemble::Evaluation::Simd)) {
+        const double scalar = timePerRow(rows, repeats, [&]() {
+            trees->setEvaluation(Native::TreeEnsemble::Evaluation::Traversal);
+            trees->predictBatch(data.data(), rows, out.data());
+        });
+        trees->setEvaluation(Native::TreeEnsemble::Evaluation::Simd);
+
+        for (size_t lanes : {16, 8}) {
+            if (!trees->setSimdLanes(lanes)) continue;
+
+            const std::string label = "simd x" + std::to_string(lanes);
+            const double simd = timePerRow(rows, repeats, [&]() { trees->predictBatch(data.data(), rows, out.data()); });
+            std::printf("%-28s batch %9.1f ns/row   %.2fx vs traversal\n", label.c_str(), simd, scalar / simd);
+            std::printf("%s mismatches vs traversal: %zu\n", label.c_str(), countMismatches(out, reference));
+        }
+    } else {
+        std::printf("simd: not supported (needs AVX2)\n");
+    }
+
+#ifdef HAVE_GENERATED_MODEL
+    std::unique_ptr<Native::Model> generated = Native::makeGeneratedModel();
+    if (generated->numFeatures() == model->numFeatures()) {
+        report("generated", *generated, data, rows, repeats, out);
+        std::printf("generated mismatches vs traversal: %zu\n", countMismatches(out, reference));
+    } else {
+        std::printf("generated: compiled-in model has %zu features\n", generated->numFeatures());
+    }
+#endif
+
+    return 0;
+}